@@ -1824,7 +1824,6 @@ static void ipc_agm_session_write(DBusConnection *conn,
     DBusMessageIter arg_i, array_i, r_arg;
     agm_session_data *ses_data = (agm_session_data *)userdata;
     uint32_t buf_size;
-    void *buf;
     char *value = NULL;
     char **addr_value = &value;
     int n_elements = 0;
@@ -1856,15 +1855,17 @@ static void ipc_agm_session_write(DBusConnection *conn,
     dbus_message_iter_next(&arg_i);
     dbus_message_iter_recurse(&arg_i, &array_i);
     dbus_message_iter_get_fixed_array(&array_i, addr_value, &n_elements);
-    buf = (void *)malloc(n_elements*sizeof(char));
-    memcpy(buf, value, n_elements);
-
-    if (agm_session_write(ses_data->handle, buf, (size_t *) &buf_size)) {
+    if (buf_size > (uint32_t)n_elements)
+        buf_size = n_elements;
+
+    /*
+     * The payload stays valid until msg is released after this handler
+     * returns, so hand it to the session without copying it.
+     */
+    if (agm_session_write(ses_data->handle, value, (size_t *) &buf_size)) {
         AGM_LOGE("agm_session_write failed.");
         agm_dbus_send_error(mdata->conn, msg, DBUS_ERROR_FAILED,
                             "agm_session_write failed.");
-        free(buf);
-        buf = NULL;
         return;
     }
 
@@ -1872,8 +1873,6 @@ static void ipc_agm_session_write(DBusConnection *conn,
     dbus_message_iter_init_append(reply, &r_arg);
     dbus_message_iter_append_basic(&r_arg, DBUS_TYPE_UINT32, &buf_size);
     dbus_connection_send(conn, reply, NULL);
-    free(buf);
-    buf = NULL;
     dbus_message_unref(reply);
 }
 
@@ -68,6 +68,7 @@
 #include <log/log.h>
 #include <unistd.h>
 #include <vendor/qti/hardware/AGMIPC/1.0/IAGM.h>
+#include <vendor/qti/hardware/AGMIPC/1.1/IAGM.h>
 
 #include <agm/agm_api.h>
 #include "inc/AGMCallback.h"
@@ -76,6 +77,7 @@
 using android::hardware::Return;
 using android::hardware::hidl_vec;
 using vendor::qti::hardware::AGMIPC::V1_0::IAGM;
+using IAGM_V1_1 = vendor::qti::hardware::AGMIPC::V1_1::IAGM;
 using vendor::qti::hardware::AGMIPC::V1_0::IAGMCallback;
 using vendor::qti::hardware::AGMIPC::V1_0::implementation::AGMCallback;
 using vendor::qti::hardware::AGMIPC::V1_0::MmapBufInfo;
@@ -88,6 +90,7 @@ using android::sp;
 static bool agm_server_died = false;
 static pthread_mutex_t agmclient_init_lock = PTHREAD_MUTEX_INITIALIZER;
 static android::sp<IAGM> agm_client = NULL;
+static android::sp<IAGM_V1_1> agm_client_v1_1 = NULL;
 static sp<server_death_notifier> Server_death_notifier = NULL;
 #ifdef AGM_HIDL_ENABLED
 sp<IAGMCallback> ClbkBinder = NULL;
@@ -134,6 +137,20 @@ done:
     return agm_client ;
 }
 
+/* servers without the 1.1 interface cannot prewarm */
+static android::sp<IAGM_V1_1> get_agm_server_v1_1()
+{
+    android::sp<IAGM> client = get_agm_server();
+
+    if (client == nullptr)
+        return nullptr;
+    pthread_mutex_lock(&agmclient_init_lock);
+    if (agm_client_v1_1 == NULL)
+        agm_client_v1_1 = IAGM_V1_1::castFrom(client);
+    pthread_mutex_unlock(&agmclient_init_lock);
+    return agm_client_v1_1;
+}
+
 int agm_register_service_crash_callback(agm_service_crash_cb cb, uint64_t cookie)
 {
     int ret = 0;
@@ -328,6 +345,19 @@ int agm_sessionid_flush(uint32_t session_id)
     return -EINVAL;
 }
 
+int agm_session_prewarm(uint32_t session_id, enum agm_session_mode sess_mode)
+{
+    ALOGV("%s called with session id = %d", __func__, session_id);
+    if (!agm_server_died) {
+        android::sp<IAGM_V1_1> agm_client = get_agm_server_v1_1();
+        if (agm_client == nullptr)
+            return -ENOSYS;
+        return agm_client->ipc_agm_session_prewarm(session_id,
+                                                   (AgmSessionMode) sess_mode);
+    }
+    return -EINVAL;
+}
+
 int agm_session_resume(uint64_t handle){
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) handle);
     if (!agm_server_died) {
@@ -20,6 +20,7 @@ LOCAL_SHARED_LIBRARIES := \
     libbase \
     libar-gsl \
     vendor.qti.hardware.AGMIPC@1.0 \
+    vendor.qti.hardware.AGMIPC@1.1 \
     libagm
 
 include $(BUILD_SHARED_LIBRARY)
@@ -49,6 +50,7 @@ LOCAL_SHARED_LIBRARIES := \
     libhardware \
     libhidlbase \
     vendor.qti.hardware.AGMIPC@1.0 \
+    vendor.qti.hardware.AGMIPC@1.1 \
     vendor.qti.hardware.AGMIPC@1.0-impl \
     libagm
 
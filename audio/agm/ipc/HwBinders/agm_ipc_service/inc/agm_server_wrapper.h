@@ -63,6 +63,7 @@
 #define ANDROID_SYSTEM_AGMIPC_V1_0_AGM_H
 
 #include <vendor/qti/hardware/AGMIPC/1.0/IAGM.h>
+#include <vendor/qti/hardware/AGMIPC/1.1/IAGM.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <vector>
@@ -127,7 +128,7 @@ typedef struct clbk_data {
    SrvrClbk *srv_clt_data;
 } clbk_data;
 
-struct AGM : public IAGM {
+struct AGM : public ::vendor::qti::hardware::AGMIPC::V1_1::IAGM {
     public :
     AGM() {
       agm_initialized = agm_init() == 0?true:false;
@@ -248,6 +249,8 @@ struct AGM : public IAGM {
                                ipc_agm_get_aif_info_list_cb _hidl_cb) override;
     Return<int32_t> ipc_agm_session_write_datapath_params(uint32_t session_id,
                                const hidl_vec<AgmBuff>& buff) override;
+    Return<int32_t> ipc_agm_session_prewarm(uint32_t session_id,
+                               AgmSessionMode sess_mode) override;
 
     int is_agm_initialized() { return agm_initialized;}
 
@@ -1091,24 +1091,16 @@ Return<void> AGM::ipc_agm_session_write(uint64_t hndl,
                                         uint32_t count,
                                         ipc_agm_session_write_cb _hidl_cb) {
     ALOGV("%s called with handle = %llx \n", __func__, (unsigned long long) hndl);
-    void* buffer = NULL;
 
     if (buff.size() < count) {
         _hidl_cb(-EINVAL, count);
         return Void();
     }
 
-    buffer = (void*) calloc(1,count);
-    if (buffer == NULL) {
-        ALOGE("%s: Cannot allocate memory for buffer\n", __func__);
-        _hidl_cb (-ENOMEM, count);
-        return Void();
-    }
-    memcpy(buffer, buff.data(), count);
+    /* buff stays valid for the duration of the call, write it in place */
     size_t cnt = (size_t) count;
-    int ret = agm_session_write(hndl, buffer, &cnt);
+    int ret = agm_session_write(hndl, (void *)buff.data(), &cnt);
     _hidl_cb (ret, cnt);
-    free(buffer);
     return Void();
 }
 
@@ -1595,6 +1587,12 @@ Return<void> AGM::ipc_agm_get_group_aif_info_list(uint32_t num_groups,
     return Void();
 }
 
+Return<int32_t> AGM::ipc_agm_session_prewarm(uint32_t session_id,
+                                              AgmSessionMode sess_mode) {
+    ALOGV("%s : session_id = %d, sess_mode = %d\n", __func__, session_id, sess_mode);
+    return agm_session_prewarm(session_id, (enum agm_session_mode) sess_mode);
+}
+
 Return<int32_t> AGM::ipc_agm_session_write_datapath_params(uint32_t session_id,
                                                 const hidl_vec<AgmBuff>& buff_hidl)
 {
@@ -123,6 +123,9 @@ class IAgmService: public ::android::IInterface
                            struct agm_buf_info *buf_info, uint32_t flag) = 0;
 };
 
+/* drop the shared data buffer of a session, see SESSION_SHM_MAP */
+void agm_session_shm_unmap(pid_t pid, uint64_t handle);
+
 class BnAgmService : public ::android::BnInterface<IAgmService> {
     android::status_t onTransact(uint32_t code,
                                    const android::Parcel& data,
@@ -215,6 +215,7 @@ void client_death_notifier::binderDied(const wp<IBinder>& who)
                 hndl = node_to_item(sess_node, agm_client_session_handle, list);
                    if (hndl->handle) {
                        agm_session_close(hndl->handle);
+                       agm_session_shm_unmap(handle->pid, hndl->handle);
                        list_remove(sess_node);
                        free(hndl);
                    }
@@ -49,6 +49,13 @@
 #include <cstring>
 #include <memory.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <mutex>
 #include "ipc_interface.h"
 #include "agm_death_notifier.h"
 #include <agm/agm_api.h>
@@ -116,8 +123,82 @@ enum {
     AIF_SET_PARAMS,
     SET_GAPLESS_SESSION_METADATA,
     GET_BUF_INFO,
+    SESSION_SHM_MAP,
+    SESSION_SHM_UNMAP,
+    SESSION_SHM_READ,
+    SESSION_SHM_WRITE,
 };
 
+/*
+ * Optional per session shared data buffer. The client maps one once the
+ * session buffer size is known, after which READ and WRITE only carry
+ * an offset and a length instead of the payload. Data calls on a session
+ * are synchronous, so a single period sized buffer is enough.
+ */
+struct agm_shm_region {
+    void *addr;
+    size_t size;
+    int fd;
+    std::mutex lock;
+
+    agm_shm_region() : addr(NULL), size(0), fd(-1) {}
+    ~agm_shm_region()
+    {
+        if (addr)
+            munmap(addr, size);
+        if (fd >= 0)
+            close(fd);
+    }
+};
+
+/* the client can neither shrink nor grow a buffer the server has mapped */
+#define AGM_SHM_SEALS (F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL)
+
+/* keyed by the client pid as well, a session handle is only valid for its owner */
+typedef std::pair<pid_t, uint64_t> agm_shm_key;
+
+static std::map<agm_shm_key, std::shared_ptr<agm_shm_region>> shm_srv_regions;
+static std::mutex shm_srv_lock;
+
+static std::shared_ptr<agm_shm_region> agm_session_shm_get(pid_t pid, uint64_t handle)
+{
+    std::lock_guard<std::mutex> lock(shm_srv_lock);
+    auto it = shm_srv_regions.find(agm_shm_key(pid, handle));
+
+    return it == shm_srv_regions.end() ? nullptr : it->second;
+}
+
+void agm_session_shm_unmap(pid_t pid, uint64_t handle)
+{
+    std::lock_guard<std::mutex> lock(shm_srv_lock);
+
+    shm_srv_regions.erase(agm_shm_key(pid, handle));
+}
+
+/* a mapping of a region the client could truncate would SIGBUS the server */
+static int agm_session_shm_check(int fd, size_t size)
+{
+    struct stat st;
+    int seals;
+
+    seals = fcntl(fd, F_GET_SEALS);
+    if (seals < 0 || (seals & AGM_SHM_SEALS) != AGM_SHM_SEALS) {
+        AGM_LOGE("shm fd not sealed, seals %x errno %d\n", seals, errno);
+        return -EPERM;
+    }
+    if (fstat(fd, &st) < 0) {
+        AGM_LOGE("shm fstat failed, errno %d\n", errno);
+        return -errno;
+    }
+    if (st.st_size < 0 || (size_t)st.st_size < size) {
+        AGM_LOGE("shm region %lld bytes, %zu requested\n",
+                 (long long)st.st_size, size);
+        return -EINVAL;
+    }
+
+    return 0;
+}
+
 class BpAgmService : public ::android::BpInterface<IAgmService>
 {
     public:
@@ -135,6 +216,62 @@ class BpAgmService : public ::android::BpInterface<IAgmService>
             AGM_LOGD("calling REG_CLIENT from BpAgmService\n");
         }
 
+        std::shared_ptr<agm_shm_region> shm_get(uint64_t handle)
+        {
+            std::lock_guard<std::mutex> lock(shm_lock);
+            auto it = shm_regions.find(handle);
+
+            return it == shm_regions.end() ? nullptr : it->second;
+        }
+
+        void shm_map(uint64_t handle, size_t size)
+        {
+            android::Parcel data, reply;
+            std::shared_ptr<agm_shm_region> region = shm_get(handle);
+
+            if (region && region->size >= size)
+                return;
+
+            region = std::make_shared<agm_shm_region>();
+            region->fd = memfd_create("agm_session_shm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+            if (region->fd < 0 || ftruncate(region->fd, size) < 0 ||
+                fcntl(region->fd, F_ADD_SEALS, AGM_SHM_SEALS) < 0) {
+                AGM_LOGE("shm alloc failed for %zu bytes, errno %d\n", size,
+                         errno);
+                goto fallback;
+            }
+            region->addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                                region->fd, 0);
+            if (region->addr == MAP_FAILED) {
+                region->addr = NULL;
+                AGM_LOGE("shm mmap failed, errno %d\n", errno);
+                goto fallback;
+            }
+            region->size = size;
+
+            data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
+            data.writeInt64((long)handle);
+            data.writeUint32(size);
+            data.writeFileDescriptor(region->fd);
+            /* older servers do not know the transaction, keep using parcels */
+            if (remote()->transact(SESSION_SHM_MAP, data, &reply) != android::OK ||
+                reply.readInt32() != 0) {
+                AGM_LOGD("shm not negotiated for handle %llx\n",
+                         (unsigned long long)handle);
+                goto fallback;
+            }
+
+            shm_lock.lock();
+            shm_regions[handle] = region;
+            shm_lock.unlock();
+            return;
+
+        fallback:
+            shm_lock.lock();
+            shm_regions.erase(handle);
+            shm_lock.unlock();
+        }
+
         ~BpAgmService()
         {
             android:: Parcel data, reply;
@@ -198,7 +335,10 @@ class BpAgmService : public ::android::BpInterface<IAgmService>
             blob1.release();
             blob2.release();
             blob3.release();
-            return reply.readInt32();
+            int rc = reply.readInt32();
+            if (rc == 0 && buffer_config->size != 0)
+                shm_map(handle, buffer_config->size);
+            return rc;
         }
 
         virtual int ipc_agm_init()
@@ -307,6 +447,9 @@ class BpAgmService : public ::android::BpInterface<IAgmService>
             data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
             data.writeInt64((long)handle);
             remote()->transact(CLOSE, data, &reply);
+            shm_lock.lock();
+            shm_regions.erase(handle);
+            shm_lock.unlock();
             return reply.readInt32();
         }
 
@@ -398,6 +541,25 @@ class BpAgmService : public ::android::BpInterface<IAgmService>
             int rc = 0;
             android::Parcel data, reply;
             android::Parcel::ReadableBlob blob;
+            std::shared_ptr<agm_shm_region> region = shm_get(session_handle);
+
+            if (region && *count <= region->size) {
+                std::lock_guard<std::mutex> lock(region->lock);
+
+                data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
+                data.writeInt64((long)session_handle);
+                data.writeUint32(0);
+                data.writeUint32(*count);
+                remote()->transact(SESSION_SHM_READ, data, &reply);
+                rc = reply.readInt32();
+                if (rc != 0) {
+                    AGM_LOGE("read failed error out %d\n", rc);
+                    return rc;
+                }
+                *count = MIN(reply.readUint32(), region->size);
+                memcpy(buff, region->addr, *count);
+                return rc;
+            }
 
             data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
             data.writeInt64((long)session_handle);
@@ -421,6 +583,20 @@ class BpAgmService : public ::android::BpInterface<IAgmService>
         {
             android::Parcel data, reply;
             android::Parcel::WritableBlob blob;
+            std::shared_ptr<agm_shm_region> region = shm_get(session_handle);
+
+            if (region && *count <= region->size) {
+                std::lock_guard<std::mutex> lock(region->lock);
+
+                memcpy(region->addr, buff, *count);
+                data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
+                data.writeInt64((long)session_handle);
+                data.writeUint32(0);
+                data.writeUint32(*count);
+                remote()->transact(SESSION_SHM_WRITE, data, &reply);
+                *count = reply.readUint32();
+                return reply.readInt32();
+            }
 
             data.writeInterfaceToken(IAgmService::getInterfaceDescriptor());
             data.writeInt64((long)session_handle);
@@ -737,6 +913,10 @@ class BpAgmService : public ::android::BpInterface<IAgmService>
         }
         return reply.readInt32();
     }
+
+    private:
+        std::map<uint64_t, std::shared_ptr<agm_shm_region>> shm_regions;
+        std::mutex shm_lock;
 };
 
 void ipc_cb (uint32_t session_id, struct agm_event_cb_params *event_params,
@@ -915,6 +1095,7 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         uint64_t handle = (uint64_t )data.readInt64();
         rc = ipc_agm_session_close(handle);
         agm_remove_session_obj_handle(handle);
+        agm_session_shm_unmap(IPCThreadState::self()->getCallingPid(), handle);
         reply->writeInt32(rc);
         break; }
 
@@ -1429,6 +1610,105 @@ android::status_t BnAgmService::onTransact(uint32_t code,
         reply->writeInt32(rc);
         break; }
 
+    case SESSION_SHM_MAP : {
+        uint64_t handle;
+        size_t size;
+        int fd;
+        std::shared_ptr<agm_shm_region> region;
+
+        handle = (uint64_t )data.readInt64();
+        size = data.readUint32();
+        fd = data.readFileDescriptor();
+
+        region = std::make_shared<agm_shm_region>();
+        region->fd = dup(fd);
+        if (region->fd < 0 || size == 0) {
+            AGM_LOGE("invalid shm fd %d size %zu\n", fd, size);
+            rc = -EINVAL;
+            reply->writeInt32(rc);
+            break;
+        }
+        rc = agm_session_shm_check(region->fd, size);
+        if (rc) {
+            reply->writeInt32(rc);
+            break;
+        }
+        region->addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                            region->fd, 0);
+        if (region->addr == MAP_FAILED) {
+            region->addr = NULL;
+            rc = -errno;
+            AGM_LOGE("shm mmap failed %d\n", rc);
+            reply->writeInt32(rc);
+            break;
+        }
+        region->size = size;
+
+        shm_srv_lock.lock();
+        shm_srv_regions[agm_shm_key(IPCThreadState::self()->getCallingPid(), handle)] =
+                region;
+        shm_srv_lock.unlock();
+        rc = 0;
+        reply->writeInt32(rc);
+        break; }
+
+    case SESSION_SHM_UNMAP : {
+        uint64_t handle = (uint64_t )data.readInt64();
+        agm_session_shm_unmap(IPCThreadState::self()->getCallingPid(), handle);
+        reply->writeInt32(0);
+        break; }
+
+    case SESSION_SHM_READ : {
+        uint64_t handle;
+        size_t offset, byte_count;
+        std::shared_ptr<agm_shm_region> region;
+
+        handle = (uint64_t )data.readInt64();
+        offset = data.readUint32();
+        byte_count = data.readUint32();
+        region = agm_session_shm_get(IPCThreadState::self()->getCallingPid(), handle);
+        if (!region || offset > region->size ||
+            byte_count > region->size - offset) {
+            AGM_LOGE("invalid shm read, offset %zu count %zu\n", offset,
+                     byte_count);
+            reply->writeInt32(-EINVAL);
+            break;
+        }
+
+        rc = ipc_agm_session_read(handle, (uint8_t *)region->addr + offset,
+                                  &byte_count);
+        reply->writeInt32(rc);
+        if (rc != 0) {
+            AGM_LOGE("session_read failed %d\n", rc);
+            break;
+        }
+        reply->writeUint32(byte_count);
+        break; }
+
+    case SESSION_SHM_WRITE : {
+        uint64_t handle;
+        size_t offset, byte_count;
+        std::shared_ptr<agm_shm_region> region;
+
+        handle = (uint64_t )data.readInt64();
+        offset = data.readUint32();
+        byte_count = data.readUint32();
+        region = agm_session_shm_get(IPCThreadState::self()->getCallingPid(), handle);
+        if (!region || offset > region->size ||
+            byte_count > region->size - offset) {
+            AGM_LOGE("invalid shm write, offset %zu count %zu\n", offset,
+                     byte_count);
+            reply->writeUint32(0);
+            reply->writeInt32(-EINVAL);
+            break;
+        }
+
+        rc = ipc_agm_session_write(handle, (uint8_t *)region->addr + offset,
+                                   &byte_count);
+        reply->writeUint32(byte_count);
+        reply->writeInt32(rc);
+        break; }
+
     default:
         return BBinder::onTransact(code, data, reply, flags);
     }
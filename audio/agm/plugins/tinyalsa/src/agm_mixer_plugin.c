@@ -1295,6 +1295,92 @@ static int amp_pcm_calibration_put(struct mixer_plugin *plugin,
     return ret;
 }
 
+static int amp_batch_write_one(struct mixer_plugin *plugin,
+                struct snd_control *ctl, struct agm_mixer_batch_value *val)
+{
+    struct snd_value_tlv_bytes *tlv_bytes;
+    struct snd_ctl_elem_value ev;
+    uint32_t i, count;
+
+    if (ctl->access & SNDRV_CTL_ELEM_ACCESS_TLV_READWRITE) {
+        tlv_bytes = ctl->value;
+        if (val->length > tlv_bytes->size)
+            return -EINVAL;
+        return tlv_bytes->put(plugin, ctl, (struct snd_ctl_tlv *)val);
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    switch (ctl->type) {
+    case SNDRV_CTL_ELEM_TYPE_ENUMERATED:
+        count = val->length / sizeof(uint32_t);
+        if (count == 0 || count > ARRAY_SIZE(ev.value.enumerated.item))
+            return -EINVAL;
+        for (i = 0; i < count; i++)
+            ev.value.enumerated.item[i] = val->data[i];
+        break;
+    case SNDRV_CTL_ELEM_TYPE_BYTES:
+        if (val->length > sizeof(ev.value.bytes.data))
+            return -EINVAL;
+        memcpy(ev.value.bytes.data, val->data, val->length);
+        break;
+    default:
+        /* integer element width differs between tinyalsa versions */
+        return -EINVAL;
+    }
+
+    return ctl->put(plugin, ctl, &ev);
+}
+
+static int amp_batch_write_get(struct mixer_plugin *plugin __unused,
+                struct snd_control *ctl __unused, struct snd_ctl_tlv *tlv __unused)
+{
+    return 0;
+}
+
+/* apply the writes of one batch in order, see struct agm_mixer_batch_value */
+static int amp_batch_write_put(struct mixer_plugin *plugin,
+                struct snd_control *ctl __unused, struct snd_ctl_tlv *tlv)
+{
+    struct amp_priv *amp_priv = plugin->priv;
+    struct agm_mixer_batch_value *val;
+    uint8_t *cur = (uint8_t *)&tlv->tlv[0];
+    uint8_t *end = cur + tlv->length;
+    size_t value_size;
+    int count = 0, ret = 0, err;
+
+    /* keep going past a failed write, teardown sequences must complete */
+    while (cur < end) {
+        if ((size_t)(end - cur) < sizeof(*val))
+            goto malformed;
+        val = (struct agm_mixer_batch_value *)cur;
+        value_size = AGM_MIXER_BATCH_ALIGN((size_t)val->length);
+        if ((size_t)(end - (uint8_t *)val->data) < value_size)
+            goto malformed;
+
+        if (val->numid >= (uint32_t)amp_priv->ctl_count) {
+            AGM_LOGE("%s: no control %u\n", __func__, val->numid);
+            err = -EINVAL;
+        } else {
+            err = amp_batch_write_one(plugin, &amp_priv->ctls[val->numid], val);
+            if (err)
+                AGM_LOGE("%s: write %d to %s failed, err %d\n", __func__, count,
+                         amp_priv->ctls[val->numid].name, err);
+        }
+        if (err && !ret)
+            ret = err;
+
+        cur = (uint8_t *)val->data + value_size;
+        count++;
+    }
+
+    AGM_LOGV("%s: applied %d writes, ret %d\n", __func__, count, ret);
+    return ret;
+
+malformed:
+    AGM_LOGE("%s: malformed record %d\n", __func__, count);
+    return ret ? ret : -EINVAL;
+}
+
 static int amp_pcm_set_acdb_tunnel_get(struct mixer_plugin *plugin __unused,
                 struct snd_control *ctl __unused, struct snd_ctl_tlv *ev __unused)
 {
@@ -1649,6 +1735,9 @@ static struct snd_value_tlv_bytes pcm_setparamtagacdb_bytes =
     SND_VALUE_TLV_BYTES(256 * 1024, amp_pcm_set_param_get, amp_pcm_set_param_put);
 static struct snd_value_tlv_bytes pcm_setacdbtunnel_bytes =
     SND_VALUE_TLV_BYTES(256 * 1024, amp_pcm_set_acdb_tunnel_get, amp_pcm_set_acdb_tunnel_put);
+static struct snd_value_tlv_bytes batch_write_bytes =
+    SND_VALUE_TLV_BYTES(AGM_MIXER_BATCH_MAX_SIZE, amp_batch_write_get,
+                        amp_batch_write_put);
 static struct snd_value_tlv_bytes pcm_setparam_bytes =
     SND_VALUE_TLV_BYTES(512 * 1024, amp_pcm_set_param_get, amp_pcm_set_param_put);
 static struct snd_value_tlv_bytes pcm_getparam_bytes =
@@ -1916,6 +2005,16 @@ static void amp_create_acdb_tunnel_set_ctl(struct amp_priv *amp_priv,
             pcm_setacdbtunnel_bytes, pval, pdata);
 }
 
+/* static mixer control for batched control writes */
+static void amp_create_batch_write_ctl(struct amp_priv *amp_priv,
+                int ctl_idx)
+{
+    struct snd_control *ctl = AMP_PRIV_GET_CTL_PTR(amp_priv, ctl_idx);
+
+    INIT_SND_CONTROL_TLV_BYTES(ctl, AGM_MIXER_BATCH_CTL_NAME,
+            batch_write_bytes, 0, amp_priv);
+}
+
 /* BE related mixer control creations here */
 static void amp_create_metadata_ctl(struct amp_priv *amp_priv,
                 char *be_name, int ctl_idx, int pval, void *pdata)
@@ -2142,6 +2241,7 @@ static int amp_form_acdb_ctls(struct amp_priv *amp_priv, int ctl_idx)
 
     amp_create_acdb_tunnel_set_ctl(amp_priv, ctl_idx, acdb_adi->idx_arr[0],
                                     acdb_adi);
+    amp_create_batch_write_ctl(amp_priv, ctl_idx + 1);
 
     return 0;
 }
@@ -2294,8 +2394,8 @@ MIXER_PLUGIN_OPEN_FN(agm_mixer_plugin)
     total_ctl_cnt += be_grp_ctl_cnt;
     pcm_ctl_cnt = amp_get_pcm_ctl_count(amp_priv);
     total_ctl_cnt += pcm_ctl_cnt;
-    /* add one static mixer control for acdb param set */
-    total_ctl_cnt += 1;
+    /* add static mixer controls for acdb param set and batch write */
+    total_ctl_cnt += 2;
     /*
      * Create the controls to be registered
      * When changing this code, be careful to make sure to create
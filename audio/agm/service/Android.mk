@@ -6,6 +6,22 @@ LOCAL_VENDOR_MODULE         := true
 LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)/inc/public
 include $(BUILD_HEADER_LIBRARY)
 
+# Build libagm_latency
+include $(CLEAR_VARS)
+
+LOCAL_MODULE        := libagm_latency
+LOCAL_MODULE_OWNER  := qti
+LOCAL_MODULE_TAGS   := optional
+LOCAL_VENDOR_MODULE := true
+
+LOCAL_CFLAGS        := -D_ANDROID_ -Wall
+LOCAL_C_INCLUDES    := $(LOCAL_PATH)/inc/public
+LOCAL_EXPORT_C_INCLUDE_DIRS := $(LOCAL_PATH)/inc/public
+
+LOCAL_SRC_FILES     := src/agm_latency.c
+
+include $(BUILD_SHARED_LIBRARY)
+
 # Build libagm
 include $(CLEAR_VARS)
 
@@ -50,7 +66,8 @@ LOCAL_SHARED_LIBRARIES := \
     liblog \
     liblx-osal \
     libaudioroute \
-    libats
+    libats \
+    libagm_latency
 
 #if android version is R, use qtitinyalsa lib otherwise use upstream ones
 #This assumes we would be using AR code only for Android R and subsequent versions.
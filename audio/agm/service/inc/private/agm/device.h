@@ -165,6 +165,8 @@ struct device_group_data {
     struct refcount refcnt;
     struct agm_group_media_config media_config;
     struct listnode list_node;
+    /* serializes endpoint configuration across the whole group */
+    pthread_mutex_t hwep_lock;
 };
 
 struct device_obj {
@@ -180,6 +182,8 @@ struct device_obj {
 
     struct listnode list_node;
     pthread_mutex_t lock;
+    /* serializes endpoint configuration across sessions, see device_get_hwep_lock */
+    pthread_mutex_t hwep_lock;
     /* pcm device info associated with the device object */
     uint32_t card_id;
     hw_ep_info_t hw_ep_info;
@@ -241,5 +245,7 @@ int device_get_group_list(struct aif_info *aif_list, size_t *num_groups);
 
 int device_get_start_refcnt(struct device_obj *dev_obj);
 int device_get_state(struct device_obj *dev_obj);
+/* Returns the lock guarding configuration of the hw endpoint behind dev_obj */
+pthread_mutex_t *device_get_hwep_lock(struct device_obj *dev_obj);
 bool get_file_path_extn(char* file_path_extn);
 #endif
@@ -293,6 +293,43 @@ int graph_stop(struct graph_obj *gph_obj,
  */
 int graph_close(struct graph_obj *gph_obj);
 
+/**
+ *\brief Close the graph of a session that is going away. The graph is
+ * kept open in a small LRU cache instead if it still matches the key
+ * vectors and media configs it was opened with, so that a graph_open
+ * with the same configuration can reuse it without rebuilding it.
+ * Calibration set on the graph is rolled back on reuse, a custom config
+ * other than the MFC output format the client resends on every start
+ * keeps the graph out of the cache.
+ *\param [in] graph_obj: associated graph obj, stopped or never started
+ *
+ * return AR_EOK on success or error code otherwise.
+ */
+int graph_release(struct graph_obj *gph_obj);
+
+/**
+ *\brief Open a graph and keep it in the graph cache without
+ * starting it, so that a later graph_open with the same arguments
+ * finds it ready.
+ *\param [in] meta_data_kv: composite graph and calibration
+ *        key vectors needed to setup the complete graph.
+ *\param [in] session_obj: session obj the graph is opened for
+ *\param [in] device_obj: Device the session would be connected to,
+ *        NULL for sessions without a device.
+ *
+ * return AR_EOK on success, -ENOSYS if the cache is disabled or
+ * error code otherwise.
+ */
+int graph_prewarm(struct agm_meta_data_gsl *meta_data_kv,
+                  struct session_obj *ses_obj,
+                  struct device_obj *dev_obj);
+
+/**
+ *\brief Close all cached graphs, used when the calibration they were
+ * opened with is no longer valid.
+ */
+void graph_cache_flush();
+
 /**
  *\brief return the no of buffers consumed/captured by the HW(SPF).
  * memory.
@@ -139,6 +139,21 @@ struct graph_buf_info {
     uint64_t timestamp;
 };
 
+/*
+ * Everything a closed graph has to match to stand in for a new one,
+ * see graph_release()
+ */
+struct graph_cache_key {
+    uint64_t hash;
+    struct agm_key_vector_gsl gkv;
+    struct agm_key_vector_gsl ckv;
+    struct device_obj *dev_obj;
+    struct agm_session_config stream_config;
+    struct agm_media_config in_media_config;
+    struct agm_media_config out_media_config;
+    struct agm_media_config dev_media_config;
+};
+
 struct graph_obj {
     pthread_mutex_t lock;
     pthread_mutex_t gph_open_thread_lock;
@@ -155,6 +170,12 @@ struct graph_obj {
     uint32_t spr_miid;
     struct graph_buf_info buf_info;
     bool is_config_buf_params_done;
+    /* cleared once the graph holds state the next session must not see */
+    bool cacheable;
+    /* calibration differs from cache_key.ckv */
+    bool cal_dirty;
+    struct graph_cache_key cache_key;
+    struct listnode cache_node;
 };
 
 void get_stream_module_list_array(module_info_t **info, size_t *size);
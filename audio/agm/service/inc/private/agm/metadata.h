@@ -31,9 +31,37 @@
 #define _METADATA_H_
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <agm/agm_priv.h>
 
+/*
+ * Reusable merge target. Inputs are appended after a reset and deduped
+ * by finish, giving the same result as metadata_merge() of the inputs.
+ * The arrays of meta only grow, and the merged result stays current
+ * while generation matches metadata_get_generation().
+ */
+struct metadata_arena {
+    struct agm_meta_data_gsl meta;
+    size_t gkv_cap;
+    size_t ckv_cap;
+    size_t props_cap;
+    uint32_t generation;
+    bool valid;
+};
+
 struct agm_meta_data_gsl* metadata_merge(int num, ...);
+void metadata_arena_reset(struct metadata_arena *arena);
+int metadata_arena_add(struct metadata_arena *arena,
+                       struct agm_meta_data_gsl *meta);
+int metadata_arena_finish(struct metadata_arena *arena);
+void metadata_arena_free(struct metadata_arena *arena);
+/*
+ * Bumped when session, aif or device metadata is set or has its cal
+ * updated. Freeing the temporary merges of open and set_config does not
+ * bump it, the inputs to a cached merge are only replaced through
+ * metadata_copy().
+ */
+uint32_t metadata_get_generation(void);
 int metadata_copy(struct agm_meta_data_gsl *dest, uint32_t size, uint8_t *payload);
 void metadata_free(struct agm_meta_data_gsl *metadata);
 void metadata_update_cal(struct agm_meta_data_gsl *meta_data,
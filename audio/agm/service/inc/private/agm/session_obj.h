@@ -79,8 +79,12 @@ struct session_cb {
     void *client_data;
 };
 
+#define SESSION_MERGED_AIF_MAX 16
+
 struct session_obj {
     struct listnode node;
+    struct listnode id_node;
+    struct listnode hndl_node;
     uint32_t sess_id;
     enum session_state state;
     struct agm_meta_data_gsl sess_meta;
@@ -100,13 +104,28 @@ struct session_obj {
     bool ec_ref_state;
     uint32_t rx_metadata_sz;
     uint32_t tx_metadata_sz;
+    /* scratch merge target, only used under lock */
+    struct metadata_arena scratch_meta;
+    /* merged session and aif metadata, with the aifs it was built from */
+    struct metadata_arena merged_meta;
+    struct aif *merged_aifs[SESSION_MERGED_AIF_MAX];
+    uint32_t merged_num_aifs;
     pthread_mutex_t lock;
     pthread_mutex_t cb_pool_lock;
 };
 
+#define SESSION_POOL_HASH_SIZE 64
+
+/*
+ * Sessions are kept on session_list and are also hashed by session id
+ * and by handle, so the per call lookups do not walk the whole pool.
+ * Lookups only take the pool lock for reading.
+ */
 struct session_pool {
     struct listnode session_list;
-    pthread_mutex_t lock;
+    struct listnode id_hash[SESSION_POOL_HASH_SIZE];
+    struct listnode hndl_hash[SESSION_POOL_HASH_SIZE];
+    pthread_rwlock_t lock;
 };
 
 struct session_pool *sess_pool;
@@ -175,6 +194,7 @@ int session_obj_register_for_events(struct session_obj *sess_obj,
                              struct agm_event_reg_cfg *evt_reg_cfg);
 int session_obj_set_ec_ref(struct session_obj *sess_obj, uint32_t aif_id,
                              bool state);
+int session_obj_prewarm(uint32_t session_id, enum agm_session_mode sess_mode);
 int session_obj_eos(struct session_obj *sess_obj);
 int session_obj_get_timestamp(struct session_obj *sess_obj,
                              uint64_t *timestamp);
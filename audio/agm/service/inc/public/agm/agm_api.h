@@ -438,6 +438,27 @@ struct agm_cal_config {
     struct agm_key_value kv[]; /**< tag key vector*/
 };
 
+/**
+ * Name of the static mixer plugin control that applies a batch of
+ * control writes in order. A failing write does not stop the ones after
+ * it, the first error is returned.
+ */
+#define AGM_MIXER_BATCH_CTL_NAME "agm batch write"
+#define AGM_MIXER_BATCH_MAX_SIZE (512 * 1024)
+#define AGM_MIXER_BATCH_ALIGN(x) (((x) + 3) & ~3)
+
+/**
+ * A batch is a sequence of agm_mixer_batch_value records, each followed
+ * by length bytes of value padded with AGM_MIXER_BATCH_ALIGN. Values are
+ * what mixer_ctl_set_array() takes for TLV and bytes controls, and uint32
+ * item indexes for enum controls.
+ */
+struct agm_mixer_batch_value {
+    uint32_t numid;      /**< control index, mixer_ctl_get_id() on the virtual card */
+    uint32_t length;     /**< value bytes, before padding */
+    uint32_t data[];
+};
+
 struct agm_acdb_param {
     bool isTKV;
     uint32_t tag;
@@ -1023,6 +1044,20 @@ int agm_session_set_loopback(uint32_t capture_session_id,
 int agm_session_set_ec_ref(uint32_t capture_session_id, uint32_t aif_id,
                                                             bool state);
 
+/**
+  * \brief Open the graph of a session ahead of its use and keep it
+  *        cached, so that a following agm_session_open with the same
+  *        metadata, media configs and audio interface reuses it. The
+  *        session itself stays closed.
+  *
+  * \param[in] session_id - Valid audio session id
+  * \param[in] sess_mode - Mode the session would be opened in
+  *
+  * \return 0 on success, -ENOSYS if graph caching is disabled,
+  *         error code otherwise
+  */
+int agm_session_prewarm(uint32_t session_id, enum agm_session_mode sess_mode);
+
 /**
   * \brief send eos of the session.
   *
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef __AGM_LATENCY_H__
+#define __AGM_LATENCY_H__
+
+/*
+ * Per buffer latency of the playback write path, from the HAL down to
+ * the AGM graph. Each layer wraps its write in a scope of its stage:
+ *
+ *   AGM_LATENCY_STAGE_HAL      StreamOutPrimary::write
+ *   AGM_LATENCY_STAGE_PAL      pal_stream_write
+ *   AGM_LATENCY_STAGE_SESSION  SessionAlsaPcm::write
+ *   AGM_LATENCY_STAGE_GRAPH    graph_write
+ *
+ * The outermost scope on a thread takes a new sequence id and publishes
+ * it in a slot of the thread, the scopes nested in it reuse the id, so
+ * the records of one buffer share it across the libraries. The time of
+ * a stage includes the stages below it. A graph served by the AGM
+ * service runs on a binder thread and gets an id of its own.
+ *
+ * The durations go to per stage histograms in a file mapped shared by
+ * every process of the stack, so the AGM service and the HAL fill the
+ * same histograms. Recording takes no locks, the counters are updated
+ * with atomic adds and the recent records sit in a ring guarded by a
+ * generation per entry. Recording is off until agm_latency_set_enabled()
+ * turns it on for all processes; the switch lives in the file and so
+ * survives a restart of any of them. agm_latency_dump() prints count,
+ * mean, p50, p99, p999 and max per stage followed by the recent records.
+ *
+ * The recorder is libagm_latency, one mapping per process whichever
+ * library of the stack records. The layout is shared by 32 and 64 bit processes, keep every 64 bit
+ * field 8 byte aligned and bump AGM_LATENCY_MAGIC when it changes.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#define AGM_LATENCY_MAGIC 0x3154414c /* "LAT1" */
+/* histogram buckets below 16 us are exact, then 8 per power of two */
+#define AGM_LATENCY_SUB_BITS 3
+#define AGM_LATENCY_MAX_US_BITS 24
+#define AGM_LATENCY_NUM_BUCKETS \
+    ((AGM_LATENCY_MAX_US_BITS - AGM_LATENCY_SUB_BITS + 1) << AGM_LATENCY_SUB_BITS)
+/* recent records, power of two */
+#define AGM_LATENCY_RING_SIZE 256
+#define AGM_LATENCY_MAX_THREADS 256
+
+enum agm_latency_stage {
+    AGM_LATENCY_STAGE_HAL = 0,
+    AGM_LATENCY_STAGE_PAL,
+    AGM_LATENCY_STAGE_SESSION,
+    AGM_LATENCY_STAGE_GRAPH,
+    AGM_LATENCY_STAGE_MAX,
+};
+
+struct agm_latency_hist {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t max_us;
+    uint64_t buckets[AGM_LATENCY_NUM_BUCKETS];
+};
+
+struct agm_latency_record {
+    uint64_t gen;       /**< ring index + 1, 0 while being written */
+    uint32_t seq;
+    uint32_t stage;
+    uint32_t tid;
+    uint32_t dur_us;
+    uint64_t begin_ns;  /**< CLOCK_MONOTONIC */
+};
+
+struct agm_latency_region {
+    uint32_t magic;
+    uint32_t enabled;
+    uint32_t next_seq;
+    uint32_t reserved;
+    uint64_t ring_head;
+    uint64_t threads[AGM_LATENCY_MAX_THREADS];  /**< tid << 32 | seq */
+    struct agm_latency_hist hist[AGM_LATENCY_STAGE_MAX];
+    struct agm_latency_record ring[AGM_LATENCY_RING_SIZE];
+};
+
+struct agm_latency_scope {
+    struct agm_latency_region *region;  /**< NULL when not recording */
+    uint64_t begin_ns;
+    uint64_t owner;  /**< slot value published by this scope, 0 if nested */
+    uint32_t seq;
+    uint32_t tid;
+    uint32_t stage;
+};
+
+/**
+ * Starts a scope of the given stage on the calling thread, does nothing
+ * while recording is off or the file does not exist.
+ */
+void agm_latency_begin(struct agm_latency_scope *scope, enum agm_latency_stage stage);
+
+/** Records the time since agm_latency_begin() of the scope. */
+void agm_latency_end(struct agm_latency_scope *scope);
+
+/**
+ * Switches recording for all processes, enabling creates the file and
+ * starts over with empty histograms.
+ *
+ * \return 0 on success, negative errno otherwise
+ */
+int agm_latency_set_enabled(int enable);
+
+/**
+ * Prints the per stage statistics and the recent records to fd.
+ *
+ * \return 0 on success, negative errno otherwise
+ */
+int agm_latency_dump(int fd);
+
+#ifdef __cplusplus
+} /* extern "C" */
+
+/* records the enclosing block as one stage */
+class AgmLatencyScope {
+ public:
+    explicit AgmLatencyScope(enum agm_latency_stage stage) { agm_latency_begin(&scope_, stage); }
+    ~AgmLatencyScope() { agm_latency_end(&scope_); }
+    AgmLatencyScope(const AgmLatencyScope &) = delete;
+    AgmLatencyScope &operator=(const AgmLatencyScope &) = delete;
+
+ private:
+    struct agm_latency_scope scope_;
+};
+#endif /* __cplusplus */
+
+#endif /* __AGM_LATENCY_H__ */
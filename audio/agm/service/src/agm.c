@@ -885,6 +885,11 @@ done:
     return ret;
 }
 
+int agm_session_prewarm(uint32_t session_id, enum agm_session_mode sess_mode)
+{
+    return session_obj_prewarm(session_id, sess_mode);
+}
+
 int agm_session_eos(uint64_t handle)
 {
     if (!handle) {
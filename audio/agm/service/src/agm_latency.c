@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <agm/agm_latency.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#ifndef AGM_LATENCY_PATH
+#ifdef __ANDROID__
+#define AGM_LATENCY_PATH "/data/vendor/audio/audio_latency.bin"
+#else
+#define AGM_LATENCY_PATH "/var/cache/audio/audio_latency.bin"
+#endif
+#endif
+
+/* how often a process looks again for a file that is not there yet */
+#define AGM_LATENCY_RETRY_NS 1000000000ULL
+
+/* shared by every library of the process that records */
+static struct agm_latency_region *mapped;
+static uint64_t retry_ns;
+static __thread uint32_t tid;
+
+static uint64_t agm_latency_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint32_t agm_latency_tid(void)
+{
+    if (!tid)
+        tid = (uint32_t)syscall(SYS_gettid);
+    return tid;
+}
+
+static uint32_t agm_latency_bucket(uint64_t us)
+{
+    uint32_t msb, shift;
+
+    if (us < (2U << AGM_LATENCY_SUB_BITS))
+        return (uint32_t)us;
+    if (us >> AGM_LATENCY_MAX_US_BITS)
+        return AGM_LATENCY_NUM_BUCKETS - 1;
+    msb = 63 - __builtin_clzll(us);
+    shift = msb - AGM_LATENCY_SUB_BITS;
+    return ((shift + 1) << AGM_LATENCY_SUB_BITS) +
+           (uint32_t)((us >> shift) & ((1U << AGM_LATENCY_SUB_BITS) - 1));
+}
+
+/* largest value that falls into bucket idx */
+static uint64_t agm_latency_bucket_max_us(uint32_t idx)
+{
+    uint32_t shift, sub;
+
+    if (idx < (2U << AGM_LATENCY_SUB_BITS))
+        return idx;
+    shift = (idx >> AGM_LATENCY_SUB_BITS) - 1;
+    sub = idx & ((1U << AGM_LATENCY_SUB_BITS) - 1);
+    return ((uint64_t)((1U << AGM_LATENCY_SUB_BITS) + sub + 1) << shift) - 1;
+}
+
+static struct agm_latency_region *agm_latency_map(int create)
+{
+    struct agm_latency_region *region;
+    uint32_t magic = 0;
+    struct stat st;
+    int fd;
+
+    fd = open(AGM_LATENCY_PATH, O_RDWR | O_CLOEXEC | (create ? O_CREAT : 0), 0660);
+    if (fd < 0)
+        return NULL;
+    if (fstat(fd, &st) ||
+        (st.st_size < (off_t)sizeof(*region) && ftruncate(fd, sizeof(*region)))) {
+        close(fd);
+        return NULL;
+    }
+    region = (struct agm_latency_region *)mmap(NULL, sizeof(*region),
+                                               PROT_READ | PROT_WRITE,
+                                               MAP_SHARED, fd, 0);
+    close(fd);
+    if (region == MAP_FAILED)
+        return NULL;
+
+    /* a new file is all zero, which is a valid empty region */
+    __atomic_compare_exchange_n(&region->magic, &magic, AGM_LATENCY_MAGIC, 0,
+                                __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    if (magic && magic != AGM_LATENCY_MAGIC) {
+        munmap(region, sizeof(*region));
+        errno = EPROTO;
+        return NULL;
+    }
+
+    return region;
+}
+
+static void agm_latency_unmap(struct agm_latency_region *region)
+{
+    munmap(region, sizeof(*region));
+}
+
+/* mapping for the data path, looks for the file at most once a second */
+static struct agm_latency_region *agm_latency_region_get(void)
+{
+    struct agm_latency_region *region, *expected = NULL;
+    uint64_t now;
+
+    region = __atomic_load_n(&mapped, __ATOMIC_ACQUIRE);
+    if (region)
+        return region;
+
+    now = agm_latency_now_ns();
+    if (now < __atomic_load_n(&retry_ns, __ATOMIC_RELAXED))
+        return NULL;
+    __atomic_store_n(&retry_ns, now + AGM_LATENCY_RETRY_NS, __ATOMIC_RELAXED);
+
+    region = agm_latency_map(0);
+    if (region && !__atomic_compare_exchange_n(&mapped, &expected, region, 0,
+                                               __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        agm_latency_unmap(region);
+        region = expected;
+    }
+
+    return region;
+}
+
+void agm_latency_begin(struct agm_latency_scope *scope,
+                       enum agm_latency_stage stage)
+{
+    struct agm_latency_region *region = agm_latency_region_get();
+    uint64_t *slot, cur;
+
+    scope->region = NULL;
+    if (!region || !__atomic_load_n(&region->enabled, __ATOMIC_RELAXED))
+        return;
+
+    scope->tid = agm_latency_tid();
+    scope->stage = stage;
+    scope->owner = 0;
+    slot = &region->threads[scope->tid % AGM_LATENCY_MAX_THREADS];
+    cur = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    if ((uint32_t)(cur >> 32) == scope->tid && (uint32_t)cur) {
+        scope->seq = (uint32_t)cur;
+    } else {
+        do {
+            scope->seq = __atomic_add_fetch(&region->next_seq, 1, __ATOMIC_RELAXED);
+        } while (!scope->seq);
+        scope->owner = ((uint64_t)scope->tid << 32) | scope->seq;
+        __atomic_store_n(slot, scope->owner, __ATOMIC_RELAXED);
+    }
+    scope->region = region;
+    scope->begin_ns = agm_latency_now_ns();
+}
+
+void agm_latency_end(struct agm_latency_scope *scope)
+{
+    struct agm_latency_region *region = scope->region;
+    struct agm_latency_record *rec;
+    struct agm_latency_hist *hist;
+    uint64_t us, max, idx;
+
+    if (!region)
+        return;
+
+    us = (agm_latency_now_ns() - scope->begin_ns) / 1000;
+    hist = &region->hist[scope->stage];
+    __atomic_add_fetch(&hist->count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->sum_us, us, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&hist->buckets[agm_latency_bucket(us)], 1, __ATOMIC_RELAXED);
+    max = __atomic_load_n(&hist->max_us, __ATOMIC_RELAXED);
+    while (us > max && !__atomic_compare_exchange_n(&hist->max_us, &max, us, 1,
+                                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+
+    idx = __atomic_fetch_add(&region->ring_head, 1, __ATOMIC_RELAXED);
+    rec = &region->ring[idx & (AGM_LATENCY_RING_SIZE - 1)];
+    __atomic_store_n(&rec->gen, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    rec->seq = scope->seq;
+    rec->stage = scope->stage;
+    rec->tid = scope->tid;
+    rec->dur_us = us > UINT32_MAX ? UINT32_MAX : (uint32_t)us;
+    rec->begin_ns = scope->begin_ns;
+    __atomic_store_n(&rec->gen, idx + 1, __ATOMIC_RELEASE);
+
+    if (scope->owner) {
+        max = scope->owner;
+        __atomic_compare_exchange_n(&region->threads[scope->tid % AGM_LATENCY_MAX_THREADS],
+                                    &max, 0, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+}
+
+/* enabling starts over with empty histograms */
+int agm_latency_set_enabled(int enable)
+{
+    struct agm_latency_region *region = agm_latency_map(enable);
+    uint32_t i, j;
+
+    if (!region)
+        return (!enable && errno == ENOENT) ? 0 : -errno;
+
+    if (enable && !__atomic_load_n(&region->enabled, __ATOMIC_RELAXED)) {
+        for (i = 0; i < AGM_LATENCY_STAGE_MAX; i++) {
+            __atomic_store_n(&region->hist[i].count, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&region->hist[i].sum_us, 0, __ATOMIC_RELAXED);
+            __atomic_store_n(&region->hist[i].max_us, 0, __ATOMIC_RELAXED);
+            for (j = 0; j < AGM_LATENCY_NUM_BUCKETS; j++)
+                __atomic_store_n(&region->hist[i].buckets[j], 0, __ATOMIC_RELAXED);
+        }
+        for (i = 0; i < AGM_LATENCY_RING_SIZE; i++)
+            __atomic_store_n(&region->ring[i].gen, 0, __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&region->enabled, enable ? 1 : 0, __ATOMIC_RELEASE);
+    agm_latency_unmap(region);
+    /* this process records from its next write, the others within a second */
+    if (enable)
+        __atomic_store_n(&retry_ns, 0, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+/* permille percentile of a stage from a snapshot of its buckets */
+static uint64_t agm_latency_percentile(const uint64_t *buckets, uint64_t total,
+                                       uint64_t max_us, uint32_t permille)
+{
+    uint64_t rank = (total * permille + 999) / 1000, seen = 0;
+    uint64_t us;
+    uint32_t i;
+
+    for (i = 0; i < AGM_LATENCY_NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank && seen) {
+            us = agm_latency_bucket_max_us(i);
+            return us < max_us ? us : max_us;
+        }
+    }
+
+    return max_us;
+}
+
+int agm_latency_dump(int fd)
+{
+    static const char *const names[AGM_LATENCY_STAGE_MAX] = {
+        "hal", "pal", "session", "graph",
+    };
+    struct agm_latency_region *region = agm_latency_map(0);
+    uint64_t buckets[AGM_LATENCY_NUM_BUCKETS];
+    struct agm_latency_record rec;
+    uint64_t total, sum, max, head, gen, i;
+    uint32_t s, b;
+
+    if (!region)
+        return -errno;
+
+    dprintf(fd, "latency tracing %s\n",
+            __atomic_load_n(&region->enabled, __ATOMIC_RELAXED) ? "on" : "off");
+    dprintf(fd, "%-8s %10s %9s %9s %9s %9s %9s\n",
+            "stage", "count", "mean_us", "p50_us", "p99_us", "p999_us", "max_us");
+    for (s = 0; s < AGM_LATENCY_STAGE_MAX; s++) {
+        total = 0;
+        for (b = 0; b < AGM_LATENCY_NUM_BUCKETS; b++) {
+            buckets[b] = __atomic_load_n(&region->hist[s].buckets[b], __ATOMIC_RELAXED);
+            total += buckets[b];
+        }
+        sum = __atomic_load_n(&region->hist[s].sum_us, __ATOMIC_RELAXED);
+        max = __atomic_load_n(&region->hist[s].max_us, __ATOMIC_RELAXED);
+        dprintf(fd, "%-8s %10llu %9llu %9llu %9llu %9llu %9llu\n", names[s],
+                (unsigned long long)total,
+                (unsigned long long)(total ? sum / total : 0),
+                (unsigned long long)agm_latency_percentile(buckets, total, max, 500),
+                (unsigned long long)agm_latency_percentile(buckets, total, max, 990),
+                (unsigned long long)agm_latency_percentile(buckets, total, max, 999),
+                (unsigned long long)max);
+    }
+
+    dprintf(fd, "\nrecent records, oldest first\n%10s %-8s %8s %20s %9s\n",
+            "seq", "stage", "tid", "begin_ns", "dur_us");
+    head = __atomic_load_n(&region->ring_head, __ATOMIC_ACQUIRE);
+    for (i = head > AGM_LATENCY_RING_SIZE ? head - AGM_LATENCY_RING_SIZE : 0; i < head; i++) {
+        struct agm_latency_record *src = &region->ring[i & (AGM_LATENCY_RING_SIZE - 1)];
+
+        gen = __atomic_load_n(&src->gen, __ATOMIC_ACQUIRE);
+        rec = *src;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        /* skip entries rewritten while being copied */
+        if (gen != i + 1 || __atomic_load_n(&src->gen, __ATOMIC_RELAXED) != gen ||
+            rec.stage >= AGM_LATENCY_STAGE_MAX)
+            continue;
+        dprintf(fd, "%10u %-8s %8u %20llu %9u\n", rec.seq, names[rec.stage], rec.tid,
+                (unsigned long long)rec.begin_ns, rec.dur_us);
+    }
+    agm_latency_unmap(region);
+
+    return 0;
+}
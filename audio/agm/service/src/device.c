@@ -902,6 +902,17 @@ int device_get_state(struct device_obj *dev_obj)
         return dev_obj->state;
 }
 
+pthread_mutex_t *device_get_hwep_lock(struct device_obj *dev_obj)
+{
+    struct device_obj *obj = device_get_pcm_obj(dev_obj);
+
+    /* grouped backends share their configuration, so they share the lock */
+    if (obj->group_data)
+        return &obj->group_data->hwep_lock;
+
+    return &obj->hwep_lock;
+}
+
 static struct device_group_data* device_get_group_data_by_name(char *dev_name)
 {
     struct device_group_data *grp_data = NULL;
@@ -931,6 +942,7 @@ static struct device_group_data* device_get_group_data_by_name(char *dev_name)
     }
 
     strlcpy(grp_data->name, group_name, pos);
+    pthread_mutex_init(&grp_data->hwep_lock, (const pthread_mutexattr_t *) NULL);
     list_add_tail(&device_group_data_list, &grp_data->list_node);
     num_group_devices++;
 
@@ -989,6 +1001,7 @@ int parse_snd_card()
         }
 
         pthread_mutex_init(&dev_obj->lock, (const pthread_mutexattr_t *) NULL);
+        pthread_mutex_init(&dev_obj->hwep_lock, (const pthread_mutexattr_t *) NULL);
         list_add_tail(&device_list, &dev_obj->list_node);
         count++;
         if (dev_obj->num_virtual_child) {
@@ -70,6 +70,7 @@
 #include <dlfcn.h>
 #include <unistd.h>
 #include "gsl_intf.h"
+#include <agm/agm_latency.h>
 #include <agm/graph.h>
 #include <agm/graph_module.h>
 #include <agm/metadata.h>
@@ -94,6 +95,7 @@
 /* TODO: remove this later after including in spf header files */
 #define PARAM_ID_SOFT_PAUSE_START 0x800102e
 #define PARAM_ID_SOFT_PAUSE_RESUME 0x800102f
+#define PARAM_ID_MFC_OUTPUT_MEDIA_FORMAT 0x08001024
 
 #define CONVX(x) #x
 #define CONV_TO_STRING(x) CONVX(x)
@@ -115,7 +117,20 @@ typedef struct module_info_link_list {
    struct listnode tagged_list;
 }module_info_link_list_t;
 
+/* closed graphs kept open for reuse, 0 disables the cache */
+#ifndef AGM_GRAPH_CACHE_MAX
+#define AGM_GRAPH_CACHE_MAX 4
+#endif
+
+#define FNV1A_64_OFFSET 0xcbf29ce484222325ULL
+#define FNV1A_64_PRIME 0x100000001b3ULL
+
 static char acdb_path[ACDB_PATH_MAX_LENGTH];
+
+/* most recently released first */
+static list_declare(graph_cache);
+static uint32_t graph_cache_count;
+static pthread_mutex_t graph_cache_lock = PTHREAD_MUTEX_INITIALIZER;
 static void print_graph_alias(const struct agm_meta_data_gsl *meta_data_kv);
 
 static int get_acdb_files_from_directory(const char* acdb_files_path,
@@ -397,6 +412,7 @@ err:
 int graph_deinit()
 {
 
+    graph_cache_flush();
     gsl_deinit();
     return 0;
 }
@@ -531,6 +547,207 @@ done:
     return ret;
 }
 
+static uint64_t graph_cache_hash(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *p = data;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= FNV1A_64_PRIME;
+    }
+    return hash;
+}
+
+static int graph_cache_copy_kv(struct agm_key_vector_gsl *dst,
+                               struct agm_key_vector_gsl *src)
+{
+    dst->num_kvs = src->num_kvs;
+    dst->kv = NULL;
+    if (!src->num_kvs)
+        return 0;
+
+    dst->kv = calloc(src->num_kvs, sizeof(struct agm_key_value));
+    if (!dst->kv)
+        return -ENOMEM;
+    memcpy(dst->kv, src->kv, src->num_kvs * sizeof(struct agm_key_value));
+    return 0;
+}
+
+static void graph_cache_key_free(struct graph_cache_key *key)
+{
+    free(key->gkv.kv);
+    free(key->ckv.kv);
+    memset(key, 0, sizeof(*key));
+}
+
+static int graph_cache_key_init(struct graph_cache_key *key,
+                                struct agm_meta_data_gsl *meta_data_kv,
+                                struct session_obj *sess_obj,
+                                struct device_obj *dev_obj)
+{
+    uint64_t hash = FNV1A_64_OFFSET;
+
+    memset(key, 0, sizeof(*key));
+    if (graph_cache_copy_kv(&key->gkv, &meta_data_kv->gkv) ||
+        graph_cache_copy_kv(&key->ckv, &meta_data_kv->ckv)) {
+        graph_cache_key_free(key);
+        return -ENOMEM;
+    }
+
+    key->dev_obj = dev_obj;
+    key->stream_config = sess_obj->stream_config;
+    key->in_media_config = sess_obj->in_media_config;
+    key->out_media_config = sess_obj->out_media_config;
+    if (dev_obj) {
+        pthread_mutex_lock(&dev_obj->lock);
+        key->dev_media_config = dev_obj->media_config;
+        pthread_mutex_unlock(&dev_obj->lock);
+    }
+
+    hash = graph_cache_hash(hash, key->gkv.kv,
+                            key->gkv.num_kvs * sizeof(struct agm_key_value));
+    hash = graph_cache_hash(hash, key->ckv.kv,
+                            key->ckv.num_kvs * sizeof(struct agm_key_value));
+    hash = graph_cache_hash(hash, &key->dev_obj,
+                            sizeof(*key) - offsetof(struct graph_cache_key, dev_obj));
+    key->hash = hash;
+    return 0;
+}
+
+/* the config structs are compared bytewise, padding can only cause a miss */
+static bool graph_cache_key_equal(struct graph_cache_key *a,
+                                  struct graph_cache_key *b)
+{
+    return a->hash == b->hash &&
+           a->gkv.num_kvs == b->gkv.num_kvs &&
+           a->ckv.num_kvs == b->ckv.num_kvs &&
+           !memcmp(a->gkv.kv, b->gkv.kv,
+                   a->gkv.num_kvs * sizeof(struct agm_key_value)) &&
+           !memcmp(a->ckv.kv, b->ckv.kv,
+                   a->ckv.num_kvs * sizeof(struct agm_key_value)) &&
+           !memcmp(&a->dev_obj, &b->dev_obj,
+                   sizeof(*a) - offsetof(struct graph_cache_key, dev_obj));
+}
+
+static struct graph_obj *graph_cache_take(struct graph_cache_key *key)
+{
+    struct graph_obj *graph_obj = NULL;
+    struct listnode *node = NULL;
+
+    pthread_mutex_lock(&graph_cache_lock);
+    list_for_each(node, &graph_cache) {
+        graph_obj = node_to_item(node, struct graph_obj, cache_node);
+        if (graph_cache_key_equal(&graph_obj->cache_key, key)) {
+            list_remove(&graph_obj->cache_node);
+            graph_cache_count--;
+            pthread_mutex_unlock(&graph_cache_lock);
+            return graph_obj;
+        }
+    }
+    pthread_mutex_unlock(&graph_cache_lock);
+
+    return NULL;
+}
+
+/*
+ * Make a cached graph look freshly opened for sess_obj. Calibration the
+ * last session applied is rolled back to the ckv the graph was opened
+ * with, which is part of the cache key.
+ */
+static int graph_cache_reuse(struct graph_obj *graph_obj,
+                             struct session_obj *sess_obj)
+{
+    struct listnode *node = NULL;
+    module_info_t *mod = NULL;
+    int ret = 0;
+
+    pthread_mutex_lock(&graph_obj->lock);
+    if (graph_obj->cal_dirty) {
+        ret = gsl_set_cal(graph_obj->graph_handle,
+                          (struct gsl_key_vector *)&graph_obj->cache_key.gkv,
+                          (struct gsl_key_vector *)&graph_obj->cache_key.ckv);
+        if (ret) {
+            ret = ar_err_get_lnx_err_code(ret);
+            AGM_LOGE("failed to restore calibration of cached graph %d\n", ret);
+            goto done;
+        }
+        graph_obj->cal_dirty = false;
+    }
+    graph_obj->sess_obj = sess_obj;
+    graph_obj->cb = NULL;
+    graph_obj->client_data = NULL;
+    graph_obj->is_config_buf_params_done = false;
+    memset(&graph_obj->buf_info, 0, sizeof(graph_obj->buf_info));
+    list_for_each(node, &graph_obj->tagged_mod_list) {
+        mod = node_to_item(node, module_info_t, list);
+        mod->is_configured = false;
+    }
+done:
+    pthread_mutex_unlock(&graph_obj->lock);
+    return ret;
+}
+
+/*
+ * A custom config keeps the graph cacheable only if every parameter in
+ * it is one the client sends again on each start before the graph runs,
+ * so the next session overwrites it anyway. PAL does this for the MFC
+ * output format of every PCM session.
+ */
+static bool graph_config_is_idempotent(void *payload, size_t payload_size)
+{
+    struct apm_module_param_data_t *header = NULL;
+    size_t offset = 0;
+    size_t param_size = 0;
+
+    while (payload_size - offset >= sizeof(struct apm_module_param_data_t)) {
+        header = (struct apm_module_param_data_t *)((uint8_t *)payload + offset);
+        if (header->param_id != PARAM_ID_MFC_OUTPUT_MEDIA_FORMAT)
+            return false;
+        param_size = sizeof(struct apm_module_param_data_t) + header->param_size;
+        ALIGN_PAYLOAD(param_size, 8);
+        if (param_size > payload_size - offset)
+            return false;
+        offset += param_size;
+    }
+
+    return offset == payload_size;
+}
+
+void graph_cache_flush()
+{
+    struct graph_obj *graph_obj = NULL;
+    struct listnode *node = NULL, *temp_node = NULL;
+    list_declare(evicted);
+
+    pthread_mutex_lock(&graph_cache_lock);
+    list_for_each_safe(node, temp_node, &graph_cache) {
+        list_remove(node);
+        list_add_tail(&evicted, node);
+    }
+    graph_cache_count = 0;
+    pthread_mutex_unlock(&graph_cache_lock);
+
+    list_for_each_safe(node, temp_node, &evicted) {
+        list_remove(node);
+        graph_obj = node_to_item(node, struct graph_obj, cache_node);
+        graph_close(graph_obj);
+    }
+}
+
+/*
+ * The DSP restarted and took every cached graph handle with it, drop
+ * them all now rather than failing on each one as it is reused. Called
+ * with graph_obj->lock held, the cache never holds graph_obj itself.
+ */
+static void graph_handle_ssr(struct graph_obj *graph_obj)
+{
+    AGM_LOGE("subsystem reset, dropping cached graphs\n");
+    if (graph_obj)
+        graph_obj->cacheable = false;
+    graph_cache_flush();
+}
+
 int graph_open(struct agm_meta_data_gsl *meta_data_kv,
                struct session_obj *sess_obj, struct device_obj *dev_obj,
                struct graph_obj **gph_obj)
@@ -551,6 +768,8 @@ int graph_open(struct agm_meta_data_gsl *meta_data_kv,
     module_info_t *stream_module_list = NULL;
     module_info_t *hw_ep_module = NULL;
     module_info_t *add_module = NULL;
+    struct graph_cache_key cache_key;
+    bool cacheable = false;
 
     list_declare(node_sess);
     list_init(&node_sess);
@@ -565,11 +784,27 @@ int graph_open(struct agm_meta_data_gsl *meta_data_kv,
         goto done;
     }
 
+    /* a failed key only means the graph is not cached */
+    if (AGM_GRAPH_CACHE_MAX > 0 &&
+        !graph_cache_key_init(&cache_key, meta_data_kv, sess_obj, dev_obj)) {
+        graph_obj = graph_cache_take(&cache_key);
+        if (graph_obj && !graph_cache_reuse(graph_obj, sess_obj)) {
+            graph_cache_key_free(&cache_key);
+            *gph_obj = graph_obj;
+            AGM_LOGD("reusing cached graph_handle %p\n", graph_obj->graph_handle);
+            goto done;
+        }
+        /* a graph that cannot be reset is replaced by a fresh one */
+        if (graph_obj)
+            graph_close(graph_obj);
+        cacheable = true;
+    }
+
     graph_obj = calloc (1, sizeof(struct graph_obj));
     if (graph_obj == NULL) {
         AGM_LOGE("failed to allocate graph object\n");
         ret = -ENOMEM;
-        goto done;
+        goto free_cache_key;
     }
 
     metadata_print(meta_data_kv);
@@ -705,6 +940,8 @@ no_config:
     if (ret != 0) {
        ret = ar_err_get_lnx_err_code(ret);
        AGM_LOGE("Failed to open the graph with error %d\n", ret);
+       if (ret == -ENETRESET)
+           graph_handle_ssr(NULL);
        goto free_graph_obj;
     }
 
@@ -716,6 +953,10 @@ no_config:
         goto close_graph;
     }
     graph_obj->state = OPENED;
+    if (cacheable) {
+        graph_obj->cache_key = cache_key;
+        graph_obj->cacheable = true;
+    }
     *gph_obj = graph_obj;
     AGM_LOGD("graph_handle %p\n", graph_obj->graph_handle);
 
@@ -736,6 +977,9 @@ free_graph_obj:
     }
     pthread_mutex_destroy(&graph_obj->lock);
     free(graph_obj);
+free_cache_key:
+    if (cacheable)
+        graph_cache_key_free(&cache_key);
 done:
     // free memory allocated in node sess/hw
     list_for_each_safe(node, temp_node, &node_sess) {
@@ -786,6 +1030,7 @@ int graph_close(struct graph_obj *graph_obj)
         }
         free(temp_mod);
     }
+    graph_cache_key_free(&graph_obj->cache_key);
     pthread_mutex_unlock(&graph_obj->lock);
     pthread_mutex_destroy(&graph_obj->lock);
     free(graph_obj);
@@ -793,6 +1038,63 @@ int graph_close(struct graph_obj *graph_obj)
     return ret;
 }
 
+int graph_release(struct graph_obj *graph_obj)
+{
+    struct graph_obj *evicted = NULL;
+    bool cacheable;
+
+    if (graph_obj == NULL) {
+        AGM_LOGE("invalid graph object\n");
+        return -EINVAL;
+    }
+
+    pthread_mutex_lock(&graph_obj->lock);
+    cacheable = graph_obj->cacheable && !(graph_obj->state & STARTED);
+    if (cacheable) {
+        /* no events for a session that is gone */
+        graph_obj->cb = NULL;
+        graph_obj->client_data = NULL;
+        graph_obj->sess_obj = NULL;
+    }
+    pthread_mutex_unlock(&graph_obj->lock);
+
+    if (!cacheable)
+        return graph_close(graph_obj);
+
+    pthread_mutex_lock(&graph_cache_lock);
+    list_add_head(&graph_cache, &graph_obj->cache_node);
+    if (++graph_cache_count > AGM_GRAPH_CACHE_MAX) {
+        evicted = node_to_item(list_tail(&graph_cache), struct graph_obj, cache_node);
+        list_remove(&evicted->cache_node);
+        graph_cache_count--;
+    }
+    pthread_mutex_unlock(&graph_cache_lock);
+
+    AGM_LOGD("cached graph_handle %p\n", graph_obj->graph_handle);
+    if (evicted)
+        graph_close(evicted);
+
+    return 0;
+}
+
+int graph_prewarm(struct agm_meta_data_gsl *meta_data_kv,
+                  struct session_obj *sess_obj, struct device_obj *dev_obj)
+{
+    struct graph_obj *graph_obj = NULL;
+    int ret = 0;
+
+    if (AGM_GRAPH_CACHE_MAX == 0)
+        return -ENOSYS;
+
+    ret = graph_open(meta_data_kv, sess_obj, dev_obj, &graph_obj);
+    if (ret) {
+        AGM_LOGE("graph open failed %d\n", ret);
+        return ret;
+    }
+
+    return graph_release(graph_obj);
+}
+
 int graph_prepare(struct graph_obj *graph_obj)
 {
     int ret = 0;
@@ -885,6 +1187,8 @@ force_configure:
     if (ret !=0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("graph_prepare failed %d\n", ret);
+        if (ret == -ENETRESET)
+            graph_handle_ssr(graph_obj);
         goto done;
     }
     graph_obj->state = PREPARED;
@@ -911,6 +1215,8 @@ int graph_start(struct graph_obj *graph_obj)
     if (ret !=0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("graph_start failed %d\n", ret);
+        if (ret == -ENETRESET)
+            graph_handle_ssr(graph_obj);
         goto done;
     }
     graph_obj->state = STARTED;
@@ -957,6 +1263,7 @@ int graph_stop(struct graph_obj *graph_obj,
                 AGM_LOGE("graph stop with prop failed %d\n", ret);
         }
 
+        graph_obj->cacheable = false;
         ret = gsl_ioctl(graph_obj->graph_handle, GSL_CMD_CLOSE_WITH_PROPS,
                         &gsl_cmd_prop, sizeof(struct gsl_cmd_properties));
         if (ret !=0) {
@@ -1023,6 +1330,8 @@ int graph_pause_resume(struct graph_obj *graph_obj, bool pause)
             header->param_size = 0x0;
 
             pthread_mutex_lock(&graph_obj->lock);
+            /* a soft paused graph must not be handed to the next session */
+            graph_obj->cacheable = false;
             ret = gsl_set_custom_config(graph_obj->graph_handle,
                                          payload, payload_size);
             if (ret !=0) {
@@ -1113,6 +1422,9 @@ int graph_set_config(struct graph_obj *graph_obj, void *payload,
 
     pthread_mutex_lock(&graph_obj->lock);
     AGM_LOGD("entry graph_handle %p", graph_obj->graph_handle);
+    /* module state set by this client must not leak into the next one */
+    if (!graph_config_is_idempotent(payload, payload_size))
+        graph_obj->cacheable = false;
     ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
     if (ret !=0) {
         ret = ar_err_get_lnx_err_code(ret);
@@ -1157,6 +1469,7 @@ int graph_set_config_with_tag(struct graph_obj *graph_obj,
      }
 
      pthread_mutex_lock(&graph_obj->lock);
+     graph_obj->cacheable = false;
      ret = gsl_set_config(graph_obj->graph_handle, (struct gsl_key_vector *)gkv,
                           tag_config->tag_id,
                           (struct gsl_key_vector *)&tag_config->tkv);
@@ -1181,6 +1494,8 @@ int graph_set_cal(struct graph_obj *graph_obj,
      }
 
      pthread_mutex_lock(&graph_obj->lock);
+     /* rolled back by graph_cache_reuse() */
+     graph_obj->cal_dirty = true;
      ret = gsl_set_cal(graph_obj->graph_handle,
                        (struct gsl_key_vector *)&metadata->gkv,
                        (struct gsl_key_vector *)&metadata->ckv);
@@ -1328,6 +1643,8 @@ int graph_set_acdb_param(void *payload)
     else
         ret = gsl_set_cal_data_to_acdb(&gkv, &kv, ptr_to_param, actual_size);
 
+    /* cached graphs hold the calibration they were opened with */
+    graph_cache_flush();
     return ar_err_get_lnx_err_code(ret);
 }
 
@@ -1337,12 +1654,15 @@ int graph_write(struct graph_obj *graph_obj, struct agm_buff *buffer, size_t *si
     struct gsl_buff gsl_buff = {0};
     uint32_t size_written = 0;
     uint32_t write_mod_tag = SHMEM_ENDPOINT;
+    struct agm_latency_scope latency;
 
     if (graph_obj == NULL) {
         AGM_LOGE("invalid graph object\n");
         return -EINVAL;
     }
 
+    agm_latency_begin(&latency, AGM_LATENCY_STAGE_GRAPH);
+
     /*
      *In case of non-tunnel mode session we have two shared memory endpoints
      *One for read from the graph and other for writing into the graph
@@ -1366,10 +1686,13 @@ int graph_write(struct graph_obj *graph_obj, struct agm_buff *buffer, size_t *si
     if (ret != 0) {
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("gsl_write for size %zu failed with error %d\n", *size, ret);
+        if (ret == -ENETRESET)
+            graph_handle_ssr(graph_obj);
         goto done;
     }
     *size = (size_t)size_written;
 done:
+    agm_latency_end(&latency);
     return ret;
 }
 
@@ -1414,6 +1737,8 @@ int graph_read(struct graph_obj *graph_obj, struct agm_buff *buffer, size_t *siz
         ret = ar_err_get_lnx_err_code(ret);
         AGM_LOGE("size_requested %zu size_read %d error %d\n",
                   *size, size_read, ret);
+        if (ret == -ENETRESET)
+            graph_handle_ssr(graph_obj);
     }
     *size = size_read;
     graph_obj->buf_info.timestamp = gsl_buff.timestamp;
@@ -1438,6 +1763,7 @@ int graph_add(struct graph_obj *graph_obj,
     }
 
     pthread_mutex_lock(&graph_obj->lock);
+    graph_obj->cacheable = false;
     AGM_LOGD("entry graph_handle %p\n", graph_obj->graph_handle);
 
     if (graph_obj->state < OPENED) {
@@ -1600,6 +1926,7 @@ int graph_change(struct graph_obj *graph_obj,
     }
 
     pthread_mutex_lock(&graph_obj->lock);
+    graph_obj->cacheable = false;
     AGM_LOGD("entry graph_handle %p", graph_obj->graph_handle);
 
     if (dev_obj != NULL) {
@@ -1734,6 +2061,7 @@ int graph_remove(struct graph_obj *graph_obj,
         return -EINVAL;
     }
     pthread_mutex_lock(&graph_obj->lock);
+    graph_obj->cacheable = false;
     AGM_LOGD("entry graph_handle %p\n", graph_obj->graph_handle);
 
     /**
@@ -1800,6 +2128,7 @@ int graph_register_for_events(struct graph_obj *gph_obj,
         goto done;
     }
     pthread_mutex_lock(&gph_obj->lock);
+    gph_obj->cacheable = false;
 
     if (gph_obj->graph_handle == NULL) {
         pthread_mutex_unlock(&gph_obj->lock);
@@ -2131,6 +2460,7 @@ int graph_set_gapless_metadata(struct graph_obj *graph_obj,
         goto error;
     }
     pid_is->samples_per_ch_to_remove = silence;
+    graph_obj->cacheable = false;
     ret = gsl_set_custom_config(graph_obj->graph_handle, payload, payload_size);
     if (ret !=0)
         AGM_LOGE("failed to set %d type silence with ret = %d", type, ret);
@@ -2147,6 +2477,7 @@ int graph_set_tag_data_to_acdb(
     struct agm_key_vector_gsl *tag_key_vect, uint8_t *payload,
     uint32_t payload_size)
 {
+    graph_cache_flush();
     return gsl_set_tag_data_to_acdb((struct gsl_key_vector *)graph_key_vect,
                  tag_id, (struct gsl_key_vector *)tag_key_vect,
                  payload, payload_size);
@@ -2157,6 +2488,7 @@ int graph_set_cal_data_to_acdb(
     struct agm_key_vector_gsl *cal_key_vect, uint8_t *payload,
     uint32_t payload_size)
 {
+    graph_cache_flush();
     return gsl_set_cal_data_to_acdb((struct gsl_key_vector *)graph_key_vect,
                 (struct gsl_key_vector *)cal_key_vect,
                 payload, payload_size);
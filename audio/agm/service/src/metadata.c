@@ -104,65 +104,160 @@ void metadata_print(struct agm_meta_data_gsl* metadata)
 
 }
 
-static void metadata_remove_dup(
-       struct agm_meta_data_gsl* meta_data) {
+#define KEY_TABLE_STACK_SLOTS 256
+
+static uint32_t metadata_gen;
+
+/* open addressed uint32 key table, used to dedup and look up keys */
+struct key_table {
+    uint32_t *keys;
+    uint32_t *vals;
+    bool *used;
+    uint32_t shift;
+    uint32_t mask;
+    bool heap;
+};
+
+static int key_table_init(struct key_table *tbl, size_t num,
+                          uint32_t *keys, uint32_t *vals, bool *used)
+{
+    uint32_t bits = 4;
+    size_t slots;
+
+    while (((size_t)1 << bits) < 2 * num)
+        bits++;
+    slots = (size_t)1 << bits;
+
+    tbl->shift = 32 - bits;
+    tbl->mask = slots - 1;
+    tbl->heap = slots > KEY_TABLE_STACK_SLOTS;
+    if (tbl->heap) {
+        keys = calloc(slots, sizeof(uint32_t));
+        vals = calloc(slots, sizeof(uint32_t));
+        used = calloc(slots, sizeof(bool));
+        if (!keys || !vals || !used) {
+            free(keys);
+            free(vals);
+            free(used);
+            return -ENOMEM;
+        }
+    } else {
+        memset(used, 0, slots * sizeof(bool));
+    }
+    tbl->keys = keys;
+    tbl->vals = vals;
+    tbl->used = used;
 
-    int i, j, k, count;
+    return 0;
+}
 
-    //remove duplicate gkvs
-    count = meta_data->gkv.num_kvs;
-    for (i = 0; i < count; i++) {
-        for (j = i + 1; j < count; j++) {
-            if (meta_data->gkv.kv[i].key == meta_data->gkv.kv[j].key) {
-                for (k = j; k < count-1; k++) {
-                    meta_data->gkv.kv[k].key = meta_data->gkv.kv[k + 1].key;
-                    meta_data->gkv.kv[k].value = meta_data->gkv.kv[k + 1].value;
-                }
-                count--;
-                j--;
-            }
+static void key_table_deinit(struct key_table *tbl)
+{
+    if (tbl->heap) {
+        free(tbl->keys);
+        free(tbl->vals);
+        free(tbl->used);
+    }
+}
+
+/* returns the slot of key, inserting it if absent; *found tells which */
+static uint32_t key_table_slot(struct key_table *tbl, uint32_t key, bool *found)
+{
+    uint32_t i = (key * 0x9E3779B1u) >> tbl->shift;
+
+    while (tbl->used[i]) {
+        if (tbl->keys[i] == key) {
+            *found = true;
+            return i;
         }
+        i = (i + 1) & tbl->mask;
     }
-    meta_data->gkv.num_kvs = count;
+    tbl->used[i] = true;
+    tbl->keys[i] = key;
+    *found = false;
 
-    //remove duplicate ckvs
-    count = meta_data->ckv.num_kvs;
-    for (i = 0; i < count; i++) {
-        for (j = i + 1; j < count; j++) {
-            if (meta_data->ckv.kv[i].key == meta_data->ckv.kv[j].key) {
-                for (k = j; k < count-1; k++) {
-                    meta_data->ckv.kv[k].key = meta_data->ckv.kv[k + 1].key;
-                    meta_data->ckv.kv[k].value = meta_data->ckv.kv[k + 1].value;
-                }
-                count--;
-                j--;
+    return i;
+}
+
+/*
+ * Drop later duplicates of items whose key is the first uint32 of each
+ * stride sized entry, keeping the order of first occurrences.
+ */
+static void metadata_remove_dup_items(uint32_t *items, size_t *num, size_t stride)
+{
+    uint32_t keys[KEY_TABLE_STACK_SLOTS];
+    uint32_t vals[KEY_TABLE_STACK_SLOTS];
+    bool used[KEY_TABLE_STACK_SLOTS];
+    struct key_table tbl;
+    size_t i, j, count = 0;
+    bool found;
+
+    if (*num < 2)
+        return;
+
+    if (key_table_init(&tbl, *num, keys, vals, used)) {
+        /* no memory for a table, compare against the kept items instead */
+        for (i = 0; i < *num; i++) {
+            for (j = 0; j < count; j++) {
+                if (items[j * stride] == items[i * stride])
+                    break;
             }
+            if (j == count)
+                memmove(&items[count++ * stride], &items[i * stride],
+                        stride * sizeof(uint32_t));
         }
+        *num = count;
+        return;
     }
-    meta_data->ckv.num_kvs = count;
 
-    //remove duplicate props
-    count = meta_data->sg_props.num_values;
-    for (i = 0; i < count; i++) {
-        for (j = i + 1; j < count; j++) {
-            if (meta_data->sg_props.values[i] == meta_data->sg_props.values[j]) {
-                for (k = j; k < count-1; k++) {
-                    meta_data->sg_props.values[k] =
-                        meta_data->sg_props.values[k+1];
-                }
-                count--;
-                j--;
-            }
+    for (i = 0; i < *num; i++) {
+        key_table_slot(&tbl, items[i * stride], &found);
+        if (!found) {
+            if (count != i)
+                memmove(&items[count * stride], &items[i * stride],
+                        stride * sizeof(uint32_t));
+            count++;
         }
     }
+    key_table_deinit(&tbl);
+    *num = count;
+}
+
+static void metadata_remove_dup(
+       struct agm_meta_data_gsl* meta_data) {
+    size_t count;
+
+    metadata_remove_dup_items((uint32_t *)meta_data->gkv.kv,
+                              &meta_data->gkv.num_kvs, 2);
+    metadata_remove_dup_items((uint32_t *)meta_data->ckv.kv,
+                              &meta_data->ckv.num_kvs, 2);
+
+    count = meta_data->sg_props.num_values;
+    metadata_remove_dup_items(meta_data->sg_props.values, &count, 1);
     meta_data->sg_props.num_values = count;
 
     //metadata_print(meta_data);
 }
 
+uint32_t metadata_get_generation(void)
+{
+    return __atomic_load_n(&metadata_gen, __ATOMIC_ACQUIRE);
+}
+
+static void metadata_changed(void)
+{
+    __atomic_add_fetch(&metadata_gen, 1, __ATOMIC_RELEASE);
+}
+
 void metadata_update_cal(struct agm_meta_data_gsl *meta_data,
                                      struct agm_key_vector_gsl *ckv)
 {
+    uint32_t keys[KEY_TABLE_STACK_SLOTS];
+    uint32_t vals[KEY_TABLE_STACK_SLOTS];
+    bool used[KEY_TABLE_STACK_SLOTS];
+    struct key_table tbl;
+    uint32_t slot;
+    bool found;
     int i, j;
 
     if (!meta_data || !ckv) {
@@ -181,12 +276,137 @@ void metadata_update_cal(struct agm_meta_data_gsl *meta_data,
         return;
     }
 
-    for (i = 0; i < meta_data->ckv.num_kvs; i++) {
-        for (j = 0; j < ckv->num_kvs; j++) {
-            if (meta_data->ckv.kv[i].key == ckv->kv[j].key) {
-                meta_data->ckv.kv[i].value = ckv->kv[j].value;
+    metadata_changed();
+    if (key_table_init(&tbl, ckv->num_kvs, keys, vals, used)) {
+        for (i = 0; i < meta_data->ckv.num_kvs; i++) {
+            for (j = 0; j < ckv->num_kvs; j++) {
+                if (meta_data->ckv.kv[i].key == ckv->kv[j].key) {
+                    meta_data->ckv.kv[i].value = ckv->kv[j].value;
+                }
             }
         }
+        return;
+    }
+
+    /* the last value given for a key wins */
+    for (j = 0; j < ckv->num_kvs; j++) {
+        slot = key_table_slot(&tbl, ckv->kv[j].key, &found);
+        tbl.vals[slot] = ckv->kv[j].value;
+    }
+
+    for (i = 0; i < meta_data->ckv.num_kvs; i++) {
+        slot = key_table_slot(&tbl, meta_data->ckv.kv[i].key, &found);
+        if (found)
+            meta_data->ckv.kv[i].value = tbl.vals[slot];
+    }
+    key_table_deinit(&tbl);
+}
+
+static int metadata_arena_reserve(void **array, size_t *cap, size_t num,
+                                  size_t size)
+{
+    size_t new_cap = *cap ? *cap : 16;
+    void *tmp;
+
+    if (num <= *cap)
+        return 0;
+
+    while (new_cap < num)
+        new_cap *= 2;
+
+    tmp = realloc(*array, new_cap * size);
+    if (!tmp)
+        return -ENOMEM;
+
+    *array = tmp;
+    *cap = new_cap;
+    return 0;
+}
+
+void metadata_arena_reset(struct metadata_arena *arena)
+{
+    arena->meta.gkv.num_kvs = 0;
+    arena->meta.ckv.num_kvs = 0;
+    arena->meta.sg_props.num_values = 0;
+    arena->meta.sg_props.prop_id = 0;
+    arena->generation = metadata_get_generation();
+    arena->valid = false;
+}
+
+/* append one input, merged in the order added as metadata_merge() does */
+int metadata_arena_add(struct metadata_arena *arena,
+                       struct agm_meta_data_gsl *meta)
+{
+    struct agm_meta_data_gsl *merged = &arena->meta;
+    int ret = 0;
+
+    if (!meta)
+        return 0;
+
+    ret = metadata_arena_reserve((void **)&merged->gkv.kv, &arena->gkv_cap,
+                                 merged->gkv.num_kvs + meta->gkv.num_kvs,
+                                 sizeof(struct agm_key_value));
+    if (!ret)
+        ret = metadata_arena_reserve((void **)&merged->ckv.kv, &arena->ckv_cap,
+                                     merged->ckv.num_kvs + meta->ckv.num_kvs,
+                                     sizeof(struct agm_key_value));
+    if (!ret)
+        ret = metadata_arena_reserve((void **)&merged->sg_props.values,
+                                     &arena->props_cap,
+                                     merged->sg_props.num_values +
+                                     meta->sg_props.num_values,
+                                     sizeof(uint32_t));
+    if (ret) {
+        AGM_LOGE("No memory to merge metadata\n");
+        return ret;
+    }
+
+    if (meta->gkv.kv) {
+        memcpy(&merged->gkv.kv[merged->gkv.num_kvs], meta->gkv.kv,
+               meta->gkv.num_kvs * sizeof(struct agm_key_value));
+        merged->gkv.num_kvs += meta->gkv.num_kvs;
+    }
+
+    if (meta->ckv.kv) {
+        memcpy(&merged->ckv.kv[merged->ckv.num_kvs], meta->ckv.kv,
+               meta->ckv.num_kvs * sizeof(struct agm_key_value));
+        merged->ckv.num_kvs += meta->ckv.num_kvs;
+    }
+
+    if (meta->sg_props.values) {
+        merged->sg_props.prop_id = meta->sg_props.prop_id;
+        memcpy(&merged->sg_props.values[merged->sg_props.num_values],
+               meta->sg_props.values,
+               meta->sg_props.num_values * sizeof(uint32_t));
+        merged->sg_props.num_values += meta->sg_props.num_values;
+    }
+
+    return 0;
+}
+
+int metadata_arena_finish(struct metadata_arena *arena)
+{
+    struct agm_meta_data_gsl *merged = &arena->meta;
+
+    metadata_remove_dup(merged);
+
+    if ((merged->gkv.num_kvs > MAX_KVPAIR) || (merged->ckv.num_kvs > MAX_KVPAIR)) {
+        AGM_LOGE("Num GKVs %zu Num CKVs %zu more than expected: %d",
+                 merged->gkv.num_kvs, merged->ckv.num_kvs, MAX_KVPAIR);
+        return -EINVAL;
+    }
+
+    arena->valid = true;
+    return 0;
+}
+
+void metadata_arena_free(struct metadata_arena *arena)
+{
+    if (arena) {
+        free(arena->meta.gkv.kv);
+        free(arena->meta.ckv.kv);
+        free(arena->meta.sg_props.values);
+        memset(arena, 0, sizeof(struct metadata_arena));
     }
 }
 
@@ -292,6 +512,9 @@ int metadata_copy(struct agm_meta_data_gsl *dest, uint32_t size __unused,
 
     int ret = 0;
 
+    /* callers free dest first, it changed even if nothing is copied */
+    metadata_changed();
+
     if (!metadata) {
         AGM_LOGI("NULL metadata passed, ignoring\n");
         return ret;
@@ -50,7 +50,19 @@
 static int session_close(struct session_obj *sess_obj);
 static int session_set_loopback(struct session_obj *sess_obj,
                            uint32_t session_id, bool enable);
-static pthread_mutex_t hwep_lock;
+/*
+ * Taken for reading around per endpoint configuration, and for writing
+ * by a session that spans more endpoints than a hwep_lockset can hold.
+ */
+static pthread_rwlock_t hwep_lock;
+
+#define SESSION_MAX_HWEP 16
+
+struct hwep_lockset {
+    bool exclusive;
+    uint32_t count;
+    pthread_mutex_t *locks[SESSION_MAX_HWEP];
+};
 static struct aif *aif_obj_get_from_pool(struct session_obj *sess_obj,
                                       uint32_t aif)
 {
@@ -142,36 +154,91 @@ uint32_t aif_obj_get_count_with_state(struct session_obj *sess_obj,
     return count;
 }
 
-static struct agm_meta_data_gsl* session_get_merged_metadata(struct session_obj *sess_obj)
+static int session_get_open_aifs(struct session_obj *sess_obj,
+                                 struct aif **aifs, uint32_t *num_aifs)
 {
-    struct agm_meta_data_gsl *merged = NULL;
-    struct agm_meta_data_gsl *temp = NULL;
-    enum agm_session_mode sess_mode = sess_obj->stream_config.sess_mode;
     struct listnode *node;
     struct aif *aif_node;
 
-    if (sess_mode != AGM_SESSION_NON_TUNNEL) {
-        list_for_each(node, &sess_obj->aif_pool) {
-            aif_node = node_to_item(node, struct aif, node);
-            if (aif_node->state == AIF_CLOSED) {
-                AGM_LOGD("ignore closed AIF node");
-                continue;
-            }
-            pthread_mutex_lock(&aif_node->dev_obj->lock);
-            merged = metadata_merge(4, temp, &sess_obj->sess_meta,
-                           &aif_node->sess_aif_meta, &aif_node->dev_obj->metadata);
-            pthread_mutex_unlock(&aif_node->dev_obj->lock);
-            if (temp) {
-                metadata_free(temp);
-                free(temp);
-            }
-            temp = merged;
+    *num_aifs = 0;
+    list_for_each(node, &sess_obj->aif_pool) {
+        aif_node = node_to_item(node, struct aif, node);
+        if (aif_node->state == AIF_CLOSED) {
+            AGM_LOGD("ignore closed AIF node");
+            continue;
         }
-    } else {
-        merged = &sess_obj->sess_meta;
+        if (*num_aifs == SESSION_MERGED_AIF_MAX) {
+            AGM_LOGE("more than %d open aifs for session id=%d\n",
+                     SESSION_MERGED_AIF_MAX, sess_obj->sess_id);
+            return -EINVAL;
+        }
+        aifs[(*num_aifs)++] = aif_node;
     }
 
-    return merged;
+    return 0;
+}
+
+/*
+ * Appends what session_get_merged_metadata() returns. Merging the whole
+ * list at once matches merging one aif at a time, as the repeats of the
+ * session metadata are all dropped as duplicates.
+ */
+static int session_add_merged_metadata(struct metadata_arena *arena,
+                                       struct session_obj *sess_obj,
+                                       struct aif **aifs, uint32_t num_aifs)
+{
+    uint32_t i;
+    int ret = 0;
+
+    ret = metadata_arena_add(arena, &sess_obj->sess_meta);
+    if (sess_obj->stream_config.sess_mode == AGM_SESSION_NON_TUNNEL)
+        return ret;
+
+    for (i = 0; !ret && i < num_aifs; i++) {
+        ret = metadata_arena_add(arena, &aifs[i]->sess_aif_meta);
+        if (ret)
+            break;
+        pthread_mutex_lock(&aifs[i]->dev_obj->lock);
+        ret = metadata_arena_add(arena, &aifs[i]->dev_obj->metadata);
+        pthread_mutex_unlock(&aifs[i]->dev_obj->lock);
+    }
+
+    return ret;
+}
+
+/*
+ * Returns session owned metadata, valid until the next call under the
+ * session lock. The merge is only redone when the set of open aifs
+ * changed, or some metadata was updated since the last one.
+ */
+static struct agm_meta_data_gsl* session_get_merged_metadata(struct session_obj *sess_obj)
+{
+    struct metadata_arena *arena = &sess_obj->merged_meta;
+    struct aif *aifs[SESSION_MERGED_AIF_MAX];
+    uint32_t num_aifs = 0;
+    int ret = 0;
+
+    if (sess_obj->stream_config.sess_mode == AGM_SESSION_NON_TUNNEL)
+        return &sess_obj->sess_meta;
+
+    if (session_get_open_aifs(sess_obj, aifs, &num_aifs) || num_aifs == 0)
+        return NULL;
+
+    if (arena->valid && arena->generation == metadata_get_generation() &&
+        sess_obj->merged_num_aifs == num_aifs &&
+        !memcmp(sess_obj->merged_aifs, aifs, num_aifs * sizeof(struct aif *)))
+        return &arena->meta;
+
+    metadata_arena_reset(arena);
+    ret = session_add_merged_metadata(arena, sess_obj, aifs, num_aifs);
+    if (!ret)
+        ret = metadata_arena_finish(arena);
+    if (ret)
+        return NULL;
+
+    memcpy(sess_obj->merged_aifs, aifs, num_aifs * sizeof(struct aif *));
+    sess_obj->merged_num_aifs = num_aifs;
+    return &arena->meta;
 }
 
 static struct agm_meta_data_gsl* session_get_merged_metadata_without_aif(struct session_obj *sess_obj)
@@ -209,7 +276,11 @@ static int session_pool_init()
         goto done;
     }
     list_init(&sess_pool->session_list);
-    pthread_mutex_init(&sess_pool->lock, (const pthread_mutexattr_t *) NULL);
+    for (int i = 0; i < SESSION_POOL_HASH_SIZE; i++) {
+        list_init(&sess_pool->id_hash[i]);
+        list_init(&sess_pool->hndl_hash[i]);
+    }
+    pthread_rwlock_init(&sess_pool->lock, (const pthread_rwlockattr_t *) NULL);
 
 done:
     return ret;
@@ -252,6 +323,8 @@ static void sess_obj_free(struct session_obj *sess_obj)
     aif_pool_free(sess_obj);
     session_cb_pool_free(sess_obj);
     metadata_free(&sess_obj->sess_meta);
+    metadata_arena_free(&sess_obj->scratch_meta);
+    metadata_arena_free(&sess_obj->merged_meta);
     free(sess_obj->params);
     free(sess_obj);
 }
@@ -262,7 +335,7 @@ static void session_pool_free()
     struct listnode *node, *next;
     int ret = 0;
 
-    pthread_mutex_lock(&sess_pool->lock);
+    pthread_rwlock_wrlock(&sess_pool->lock);
     list_for_each_safe(node, next, &sess_pool->session_list) {
         sess_obj = node_to_item(node, struct session_obj, node);
         pthread_mutex_lock(&sess_obj->lock);
@@ -275,9 +348,11 @@ static void session_pool_free()
 
         //cleanup aif pool from session_object
         list_remove(&sess_obj->node);
+        list_remove(&sess_obj->id_node);
+        list_remove(&sess_obj->hndl_node);
         sess_obj_free(sess_obj);
     }
-    pthread_mutex_unlock(&sess_pool->lock);
+    pthread_rwlock_unlock(&sess_pool->lock);
     free(sess_pool);
 }
 
@@ -300,20 +375,39 @@ static struct session_obj* session_obj_create(int session_id)
     return obj;
 }
 
-struct session_obj *session_obj_retrieve_from_pool(uint32_t session_id)
+static uint32_t session_id_hash(uint32_t session_id)
+{
+    return session_id % SESSION_POOL_HASH_SIZE;
+}
+
+static uint32_t session_hndl_hash(uint64_t hndl)
+{
+    /* session objects are heap allocated, skip the alignment bits */
+    return (uint32_t)((hndl >> 4) ^ (hndl >> 12)) % SESSION_POOL_HASH_SIZE;
+}
+
+/* caller must hold sess_pool->lock */
+static struct session_obj *session_pool_find(uint32_t session_id)
 {
     struct session_obj *obj = NULL;
     struct listnode *node;
 
-    pthread_mutex_lock(&sess_pool->lock);
-    list_for_each(node, &sess_pool->session_list) {
-        obj = node_to_item(node, struct session_obj, node);
+    list_for_each(node, &sess_pool->id_hash[session_id_hash(session_id)]) {
+        obj = node_to_item(node, struct session_obj, id_node);
         if (obj->sess_id == session_id)
-            break;
-        else
-            obj = NULL;
+            return obj;
     }
-    pthread_mutex_unlock(&sess_pool->lock);
+
+    return NULL;
+}
+
+struct session_obj *session_obj_retrieve_from_pool(uint32_t session_id)
+{
+    struct session_obj *obj = NULL;
+
+    pthread_rwlock_rdlock(&sess_pool->lock);
+    obj = session_pool_find(session_id);
+    pthread_rwlock_unlock(&sess_pool->lock);
 
     return obj;
 }
@@ -321,17 +415,16 @@ struct session_obj *session_obj_retrieve_from_pool(uint32_t session_id)
 struct session_obj *session_obj_get_from_pool(uint32_t session_id)
 {
     struct session_obj *obj = NULL;
-    struct listnode *node;
 
-    pthread_mutex_lock(&sess_pool->lock);
-    list_for_each(node, &sess_pool->session_list) {
-        obj = node_to_item(node, struct session_obj, node);
-        if (obj->sess_id == session_id)
-            break;
-        else
-            obj = NULL;
-    }
+    pthread_rwlock_rdlock(&sess_pool->lock);
+    obj = session_pool_find(session_id);
+    pthread_rwlock_unlock(&sess_pool->lock);
+    if (obj)
+        return obj;
 
+    pthread_rwlock_wrlock(&sess_pool->lock);
+    /* recheck, another thread may have created it meanwhile */
+    obj = session_pool_find(session_id);
     if (!obj) {
         //AGM_LOGE("Couldnt find a session object in the list,
         //                             creating one\n");
@@ -341,28 +434,33 @@ struct session_obj *session_obj_get_from_pool(uint32_t session_id)
             goto done;
         }
         list_add_tail(&sess_pool->session_list, &obj->node);
+        list_add_tail(&sess_pool->id_hash[session_id_hash(session_id)],
+                      &obj->id_node);
+        list_add_tail(&sess_pool->hndl_hash[session_hndl_hash((uint64_t)(uintptr_t)obj)],
+                      &obj->hndl_node);
     }
 
 done:
-    pthread_mutex_unlock(&sess_pool->lock);
+    pthread_rwlock_unlock(&sess_pool->lock);
     return obj;
 }
+
 int session_obj_valid_check(uint64_t hndl)
 {
-
     struct session_obj *obj = NULL;
     struct listnode *node;
+    int ret = 0;
 
-    pthread_mutex_lock(&sess_pool->lock);
-    list_for_each(node, &sess_pool->session_list) {
-        obj = node_to_item(node, struct session_obj, node);
-        if (obj == hndl) {
-            pthread_mutex_unlock(&sess_pool->lock);
-            return  1;
+    pthread_rwlock_rdlock(&sess_pool->lock);
+    list_for_each(node, &sess_pool->hndl_hash[session_hndl_hash(hndl)]) {
+        obj = node_to_item(node, struct session_obj, hndl_node);
+        if ((uint64_t)(uintptr_t)obj == hndl) {
+            ret = 1;
+            break;
         }
     }
-    pthread_mutex_unlock(&sess_pool->lock);
-    return 0;
+    pthread_rwlock_unlock(&sess_pool->lock);
+    return ret;
 }
 
 /* returns session_obj associated with session id */
@@ -388,8 +486,10 @@ static int session_set_loopback(struct session_obj *sess_obj,
     int ret = 0;
     struct session_obj *pb_obj = NULL;
     struct agm_meta_data_gsl *capture_metadata = NULL;
-    struct agm_meta_data_gsl *playback_metadata = NULL;
     struct agm_meta_data_gsl *merged_metadata = NULL;
+    struct metadata_arena *arena = &sess_obj->scratch_meta;
+    struct aif *pb_aifs[SESSION_MERGED_AIF_MAX];
+    uint32_t pb_num_aifs = 0;
 
     /*
      * 1. merged metadata of pb session + cap session
@@ -415,22 +515,29 @@ static int session_set_loopback(struct session_obj *sess_obj,
         goto done;
     }
 
-    playback_metadata = session_get_merged_metadata(pb_obj);
-    if (!playback_metadata) {
-        ret = -ENOMEM;
-        AGM_LOGE("Error:%d, merging metadata with session id=%d\n",
-                                                    ret, pb_id);
-        goto done;
-    }
-
-    merged_metadata = metadata_merge(2, capture_metadata, playback_metadata);
-    if (!merged_metadata) {
+    /*
+     * The playback session cache belongs to its own lock, so its inputs
+     * are merged straight into this session's scratch arena instead.
+     */
+    ret = session_get_open_aifs(pb_obj, pb_aifs, &pb_num_aifs);
+    if (!ret && pb_num_aifs == 0 &&
+        pb_obj->stream_config.sess_mode != AGM_SESSION_NON_TUNNEL)
         ret = -ENOMEM;
+    if (!ret) {
+        metadata_arena_reset(arena);
+        ret = metadata_arena_add(arena, capture_metadata);
+    }
+    if (!ret)
+        ret = session_add_merged_metadata(arena, pb_obj, pb_aifs, pb_num_aifs);
+    if (!ret)
+        ret = metadata_arena_finish(arena);
+    if (ret) {
         AGM_LOGE("Error:%d, merging metadata with playback"
                    "session id=%d and capture session id=%d\n",
                      ret, pb_id, sess_obj->sess_id);
         goto done;
     }
+    merged_metadata = &arena->meta;
 
     if (enable)
         ret = graph_add(sess_obj->graph, merged_metadata, NULL);
@@ -444,18 +551,6 @@ static int session_set_loopback(struct session_obj *sess_obj,
     }
 
 done:
-    if (capture_metadata) {
-        metadata_free(capture_metadata);
-        free(capture_metadata);
-    }
-    if (playback_metadata) {
-        metadata_free(playback_metadata);
-        free(playback_metadata);
-    }
-    if (merged_metadata) {
-        metadata_free(merged_metadata);
-        free(merged_metadata);
-    }
     return ret;
 }
 
@@ -518,10 +613,69 @@ done:
     return ret;
 }
 
+/*
+ * Lock the hardware endpoints the session is attached to, in address
+ * order, so sessions on disjoint endpoints configure them concurrently.
+ */
+static void session_hwep_lock(struct session_obj *sess_obj,
+                              struct hwep_lockset *set)
+{
+    struct listnode *node = NULL;
+    struct aif *aif_obj = NULL;
+    pthread_mutex_t *lock = NULL;
+    uint32_t i, j;
+
+    set->count = 0;
+    set->exclusive = false;
+    list_for_each(node, &sess_obj->aif_pool) {
+        aif_obj = node_to_item(node, struct aif, node);
+        if (!aif_obj->dev_obj)
+            continue;
+
+        lock = device_get_hwep_lock(aif_obj->dev_obj);
+        for (i = 0; i < set->count &&
+                    (uintptr_t)set->locks[i] < (uintptr_t)lock; i++)
+            ;
+        if (i < set->count && set->locks[i] == lock)
+            continue;
+
+        if (set->count == SESSION_MAX_HWEP) {
+            set->exclusive = true;
+            set->count = 0;
+            break;
+        }
+        for (j = set->count; j > i; j--)
+            set->locks[j] = set->locks[j - 1];
+        set->locks[i] = lock;
+        set->count++;
+    }
+
+    if (set->exclusive) {
+        AGM_LOGD("session id:%d spans too many endpoints, locking all\n",
+                 sess_obj->sess_id);
+        pthread_rwlock_wrlock(&hwep_lock);
+        return;
+    }
+
+    pthread_rwlock_rdlock(&hwep_lock);
+    for (i = 0; i < set->count; i++)
+        pthread_mutex_lock(set->locks[i]);
+}
+
+static void session_hwep_unlock(struct hwep_lockset *set)
+{
+    uint32_t i = set->count;
+
+    while (i > 0)
+        pthread_mutex_unlock(set->locks[--i]);
+    pthread_rwlock_unlock(&hwep_lock);
+}
+
 static int session_disconnect_aif(struct session_obj *sess_obj,
                     struct aif *aif_obj, uint32_t opened_count)
 {
     int ret = 0;
+    struct hwep_lockset hweps;
     struct agm_meta_data_gsl *merged_metadata = NULL;
     struct agm_meta_data_gsl *merged_meta_sess_aif = NULL;
     struct agm_meta_data_gsl temp = {0};
@@ -539,7 +693,7 @@ static int session_disconnect_aif(struct session_obj *sess_obj,
         goto done;
     }
 
-    pthread_mutex_lock(&hwep_lock);
+    session_hwep_lock(sess_obj, &hweps);
     if (opened_count == 1) {
         //this is SSSD condition, hence stop just the stream/stream-device,
         //merged only sess-aif, aif
@@ -552,7 +706,7 @@ static int session_disconnect_aif(struct session_obj *sess_obj,
                           audio interface id:%d \n",
                           sess_obj->sess_id, aif_obj->aif_id);
             ret = -ENOMEM;
-            pthread_mutex_unlock(&hwep_lock);
+            session_hwep_unlock(&hweps);
             goto done;
         }
 
@@ -582,7 +736,7 @@ static int session_disconnect_aif(struct session_obj *sess_obj,
         AGM_LOGE("Error:%d closing device object with id:%d \n",
             ret, aif_obj->aif_id);
     }
-    pthread_mutex_unlock(&hwep_lock);
+    session_hwep_unlock(&hweps);
 
 done:
     if (merged_meta_sess_aif) {
@@ -700,6 +854,31 @@ static int session_apply_aif_device_params(struct session_obj *sess_obj,
     return ret;
 }
 
+/* merge session, session-aif and device metadata into the scratch arena */
+static int session_merge_aif_metadata(struct session_obj *sess_obj,
+                                      struct aif *aif_obj)
+{
+    struct metadata_arena *arena = &sess_obj->scratch_meta;
+    int ret = 0;
+
+    metadata_arena_reset(arena);
+    ret = metadata_arena_add(arena, &sess_obj->sess_meta);
+    if (!ret)
+        ret = metadata_arena_add(arena, &aif_obj->sess_aif_meta);
+    if (!ret) {
+        pthread_mutex_lock(&aif_obj->dev_obj->lock);
+        ret = metadata_arena_add(arena, &aif_obj->dev_obj->metadata);
+        pthread_mutex_unlock(&aif_obj->dev_obj->lock);
+    }
+    if (!ret)
+        ret = metadata_arena_finish(arena);
+    if (ret)
+        AGM_LOGE("Error merging metadata session_id:%d aif_id:%d\n",
+            sess_obj->sess_id, aif_obj->aif_id);
+
+    return ret;
+}
+
 static int session_connect_aif(struct session_obj *sess_obj,
                                struct aif *aif_obj, uint32_t opened_count)
 {
@@ -708,16 +887,10 @@ static int session_connect_aif(struct session_obj *sess_obj,
     struct graph_obj *graph = sess_obj->graph;
 
     //step 2.a  merge metadata
-    pthread_mutex_lock(&aif_obj->dev_obj->lock);
-    merged_metadata = metadata_merge(3, &sess_obj->sess_meta,
-                         &aif_obj->sess_aif_meta, &aif_obj->dev_obj->metadata);
-    pthread_mutex_unlock(&aif_obj->dev_obj->lock);
-    if (!merged_metadata) {
-        AGM_LOGE("Error merging metadata session_id:%d aif_id:%d\n",
-            sess_obj->sess_id, aif_obj->aif_id);
-        ret = -ENOMEM;
+    ret = session_merge_aif_metadata(sess_obj, aif_obj);
+    if (ret)
         goto done;
-    }
+    merged_metadata = &sess_obj->scratch_meta.meta;
 
     ret = device_open(aif_obj->dev_obj);
     if (ret) {
@@ -823,11 +996,6 @@ close_device:
     device_close(aif_obj->dev_obj);
 
 done:
-    if (merged_metadata) {
-        metadata_free(merged_metadata);
-        free(merged_metadata);
-    }
-
     return ret;
 }
 
@@ -964,6 +1132,7 @@ done:
 static int session_prepare(struct session_obj *sess_obj)
 {
     int ret = 0;
+    struct hwep_lockset hweps;
     struct aif *aif_obj = NULL;
     enum agm_session_mode sess_mode = sess_obj->stream_config.sess_mode;
     struct listnode *node = NULL;
@@ -991,9 +1160,9 @@ static int session_prepare(struct session_obj *sess_obj)
         }
 
         if ((sess_obj->state != SESSION_STARTED)) {
-            pthread_mutex_lock(&hwep_lock);
+            session_hwep_lock(sess_obj, &hweps);
             ret = graph_prepare(sess_obj->graph);
-            pthread_mutex_unlock(&hwep_lock);
+            session_hwep_unlock(&hweps);
             if (ret) {
                 AGM_LOGE("Error:%d preparing graph\n", ret);
                 goto done;
@@ -1018,6 +1187,7 @@ done:
 static int session_start(struct session_obj *sess_obj)
 {
     int ret = 0;
+    struct hwep_lockset hweps;
     struct aif *aif_obj = NULL;
     enum direction dir = sess_obj->stream_config.dir;
     enum agm_session_mode sess_mode = sess_obj->stream_config.sess_mode;
@@ -1083,7 +1253,7 @@ static int session_start(struct session_obj *sess_obj)
             }
         }
 
-        pthread_mutex_lock(&hwep_lock);
+        session_hwep_lock(sess_obj, &hweps);
 
         //For Slimbus EP - First configure the slave ports via device_prepare/start
         //and then start the master side via graph_start.
@@ -1128,7 +1298,7 @@ static int session_start(struct session_obj *sess_obj)
             aif_obj = node_to_item(node, struct aif, node);
             if (!aif_obj) {
                 AGM_LOGE("Error:%d could not find aif node\n", ret);
-                pthread_mutex_unlock(&hwep_lock);
+                session_hwep_unlock(&hweps);
                 goto unwind;
             }
 
@@ -1140,7 +1310,7 @@ static int session_start(struct session_obj *sess_obj)
                 ret = device_prepare(aif_obj->dev_obj);
                 if (ret) {
                     AGM_LOGE("Error:%d preparing device\n", ret);
-                    pthread_mutex_unlock(&hwep_lock);
+                    session_hwep_unlock(&hweps);
                     goto unwind;
                 }
                 aif_obj->state = AIF_PREPARED;
@@ -1152,13 +1322,13 @@ static int session_start(struct session_obj *sess_obj)
                 if (ret) {
                     AGM_LOGE("Error:%d starting device id:%d\n",
                                    ret, aif_obj->aif_id);
-                    pthread_mutex_unlock(&hwep_lock);
+                    session_hwep_unlock(&hweps);
                     goto unwind;
                 }
                 aif_obj->state = AIF_STARTED;
             }
         }
-        pthread_mutex_unlock(&hwep_lock);
+        session_hwep_unlock(&hweps);
     } else {
         ret = graph_start(sess_obj->graph);
         if (ret) {
@@ -1171,7 +1341,7 @@ static int session_start(struct session_obj *sess_obj)
     goto done;
 
 unwind:
-    pthread_mutex_lock(&hwep_lock);
+    session_hwep_lock(sess_obj, &hweps);
     graph_stop(sess_obj->graph, NULL);
 device_stop:
     if (sess_mode != AGM_SESSION_NON_TUNNEL  && sess_mode != AGM_SESSION_NO_CONFIG) {
@@ -1185,7 +1355,7 @@ device_stop:
             }
         }
     }
-    pthread_mutex_unlock(&hwep_lock);
+    session_hwep_unlock(&hweps);
 done:
     return ret;
 }
@@ -1193,6 +1363,7 @@ done:
 static int session_stop(struct session_obj *sess_obj)
 {
     int ret = 0;
+    struct hwep_lockset hweps;
     struct aif *aif_obj = NULL;
     enum direction dir = sess_obj->stream_config.dir;
     enum agm_session_mode sess_mode = sess_obj->stream_config.sess_mode;
@@ -1206,12 +1377,12 @@ static int session_stop(struct session_obj *sess_obj)
     }
 
     if (sess_mode != AGM_SESSION_NON_TUNNEL  && sess_mode != AGM_SESSION_NO_CONFIG) {
-        pthread_mutex_lock(&hwep_lock);
+        session_hwep_lock(sess_obj, &hweps);
         if (dir == RX) {
             ret = graph_stop(sess_obj->graph, NULL);
             if (ret) {
                 AGM_LOGE("Error:%d stopping graph\n", ret);
-                pthread_mutex_unlock(&hwep_lock);
+                session_hwep_unlock(&hweps);
                 goto done;
             }
         }
@@ -1239,7 +1410,7 @@ static int session_stop(struct session_obj *sess_obj)
                 AGM_LOGE("Error:%d stopping graph\n", ret);
             }
         }
-        pthread_mutex_unlock(&hwep_lock);
+        session_hwep_unlock(&hweps);
     } else {
             ret = graph_stop(sess_obj->graph, NULL);
             if (ret) {
@@ -1255,6 +1426,7 @@ done:
 static int session_close(struct session_obj *sess_obj)
 {
     int ret = 0;
+    struct hwep_lockset hweps;
     struct aif *aif_obj = NULL;
     enum agm_session_mode sess_mode = sess_obj->stream_config.sess_mode;
     struct listnode *node = NULL;
@@ -1267,7 +1439,7 @@ static int session_close(struct session_obj *sess_obj)
         goto done;
     }
 
-    pthread_mutex_lock(&hwep_lock);
+    session_hwep_lock(sess_obj, &hweps);
     if (sess_obj->state == SESSION_STARTED) {
         ret = graph_stop(sess_obj->graph, NULL);
         if (ret) {
@@ -1275,7 +1447,7 @@ static int session_close(struct session_obj *sess_obj)
         }
     }
 
-    ret = graph_close(sess_obj->graph);
+    ret = graph_release(sess_obj->graph);
     if (ret) {
         AGM_LOGE("Error:%d closing graph\n", ret);
     }
@@ -1306,7 +1478,7 @@ static int session_close(struct session_obj *sess_obj)
             }
         }
     }
-    pthread_mutex_unlock(&hwep_lock);
+    session_hwep_unlock(&hweps);
     sess_obj->state = SESSION_CLOSED;
 done:
     AGM_LOGD("exit, ret %d", ret);
@@ -1343,7 +1515,7 @@ int session_obj_init()
         AGM_LOGE("Error:%d initializing session_pool\n", ret);
         goto graph_deinit;
     }
-    pthread_mutex_init(&hwep_lock, (const pthread_mutexattr_t *) NULL);
+    pthread_rwlock_init(&hwep_lock, (const pthread_rwlockattr_t *) NULL);
     goto done;
 
 graph_deinit:
@@ -2527,6 +2699,78 @@ done:
     return ret;
 }
 
+/*
+ * Open the graph the next session_obj_open() would open and leave it in
+ * the graph cache. Only sessions without a device or with a single
+ * connected device can be prewarmed.
+ */
+int session_obj_prewarm(uint32_t session_id, enum agm_session_mode sess_mode)
+{
+    struct session_obj *sess_obj = NULL;
+    struct aif *aif_obj = NULL, *temp = NULL;
+    struct listnode *node;
+    int ret = 0;
+
+    ret = session_obj_get(session_id, &sess_obj);
+    if (ret) {
+        AGM_LOGE("Error getting session object\n");
+        return ret;
+    }
+
+    pthread_mutex_lock(&sess_obj->lock);
+    if (sess_obj->state != SESSION_CLOSED) {
+        AGM_LOGE("Session already Opened, session_state:%d\n",
+                                       sess_obj->state);
+        ret = -EALREADY;
+        goto done;
+    }
+    sess_obj->stream_config.sess_mode = sess_mode;
+
+    if (sess_mode == AGM_SESSION_NON_TUNNEL || sess_mode == AGM_SESSION_NO_CONFIG) {
+        ret = graph_prewarm(&sess_obj->sess_meta, sess_obj, NULL);
+        goto done;
+    }
+
+    list_for_each(node, &sess_obj->aif_pool) {
+        temp = node_to_item(node, struct aif, node);
+        if (temp->state != AIF_OPEN)
+            continue;
+        if (aif_obj) {
+            AGM_LOGE("session:%d has more than one audio interface\n",
+                     sess_obj->sess_id);
+            ret = -EINVAL;
+            goto done;
+        }
+        aif_obj = temp;
+    }
+    if (!aif_obj) {
+        AGM_LOGE("No Audio interface(Backend) set on session(Frontend):%d\n",
+                sess_obj->sess_id);
+        ret = -EPIPE;
+        goto done;
+    }
+
+    ret = session_merge_aif_metadata(sess_obj, aif_obj);
+    if (ret)
+        goto done;
+
+    /* same order as session_connect_aif */
+    ret = device_open(aif_obj->dev_obj);
+    if (ret) {
+        AGM_LOGE("Error:%d opening device object with id:%d \n",
+            ret, aif_obj->aif_id);
+        goto done;
+    }
+    ret = graph_prewarm(&sess_obj->scratch_meta.meta, sess_obj, aif_obj->dev_obj);
+    device_close(aif_obj->dev_obj);
+
+done:
+    if (ret)
+        AGM_LOGE("Error:%d prewarming session:%d\n", ret, session_id);
+    pthread_mutex_unlock(&sess_obj->lock);
+    return ret;
+}
+
 int session_obj_eos(struct session_obj *sess_obj)
 {
     int ret = 0;
@@ -50,6 +50,11 @@ ifeq ($(strip $(AUDIO_FEATURE_ENABLED_EC_REF_CAPTURE)),true)
 LOCAL_CFLAGS += -DEC_REF_CAPTURE_ENABLED
 endif
 
+# e.g. PAL_LOG_INFO to compile out debug and verbose logs
+ifneq ($(strip $(AUDIO_FEATURE_PAL_LOG_MAX_LEVEL)),)
+LOCAL_CFLAGS += -DPAL_LOG_MAX_LEVEL=$(strip $(AUDIO_FEATURE_PAL_LOG_MAX_LEVEL))
+endif
+
 LOCAL_C_INCLUDES              += $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr/include
 LOCAL_C_INCLUDES              += $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr/techpack/audio/include
 LOCAL_ADDITIONAL_DEPENDENCIES += $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr
@@ -84,6 +89,7 @@ LOCAL_SRC_FILES := \
     device/src/HeadsetVaMic.cpp \
     device/src/RTProxy.cpp \
     device/src/SpeakerProtection.cpp \
+    device/src/SpeakerTempSampler.cpp \
     device/src/FMDevice.cpp \
     device/src/ExtEC.cpp \
     device/src/HapticsDev.cpp \
@@ -94,6 +100,7 @@ LOCAL_SRC_FILES := \
     session/src/SessionAgm.cpp \
     session/src/SessionAlsaUtils.cpp \
     session/src/SessionAlsaCompress.cpp \
+    session/src/OffloadEventLoop.cpp \
     session/src/SessionAlsaVoice.cpp \
     session/src/SoundTriggerEngine.cpp \
     session/src/SoundTriggerEngineCapi.cpp \
@@ -103,10 +110,14 @@ LOCAL_SRC_FILES := \
     session/src/ACDEngine.cpp \
     resource_manager/src/ResourceManager.cpp \
     resource_manager/src/SndCardMonitor.cpp \
+    resource_manager/src/MixerEventRouter.cpp \
     utils/src/SoundTriggerXmlParser.cpp \
     utils/src/SoundTriggerPlatformInfo.cpp \
     utils/src/ACDPlatformInfo.cpp \
     utils/src/PalRingBuffer.cpp \
+    utils/src/StreamHandleTable.cpp \
+    utils/src/PalConfigCache.cpp \
+    utils/src/PalTrace.cpp \
     utils/src/SoundTriggerUtils.cpp \
     utils/src/SignalHandler.cpp
 ifeq ($(strip $(AUDIO_FEATURE_ENABLED_EC_REF_CAPTURE)),true)
@@ -127,7 +138,8 @@ LOCAL_SHARED_LIBRARIES := \
     liblx-osal\
     libaudioroute\
     libcutils \
-    libagmclient
+    libagmclient \
+    libagm_latency
 
 #if android version is R, use qtitinyxxx headers & libs, otherwise use upstream ones
 #This assumes we would be using AR code only for Android R and subsequent versions.
@@ -38,6 +38,8 @@
 #include "Device.h"
 #include "ResourceManager.h"
 #include "PalCommon.h"
+#include "PalTrace.h"
+#include <agm/agm_latency.h>
 class Stream;
 
 /*
@@ -351,8 +353,10 @@ exit:
 
 ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *buf)
 {
+    AgmLatencyScope latency(AGM_LATENCY_STAGE_PAL);
     Stream *s = NULL;
     int status;
+    uint32_t slot = STREAM_HANDLE_INVALID_SLOT;
     std::shared_ptr<ResourceManager> rm = NULL;
 
     rm = ResourceManager::getInstance();
@@ -361,32 +365,48 @@ ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *
         status = -EINVAL;
         return status;
     }
-    rm->lockValidStreamMutex();
-    if (!stream_handle || !rm->isActiveStream(stream_handle) || !buf) {
-        rm->unlockValidStreamMutex();
+    if (!stream_handle || !buf) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
         return status;
     }
 
-    PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
-    if (0 != status) {
+    status = rm->pinActiveStream(stream_handle, &slot);
+    if (-ENOENT == status) {
+        /* handle not tracked by the lock free table, use the locked path */
+        slot = STREAM_HANDLE_INVALID_SLOT;
+        rm->lockValidStreamMutex();
+        if (!rm->isActiveStream(stream_handle)) {
+            rm->unlockValidStreamMutex();
+            status = -EINVAL;
+            PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
+            return status;
+        }
+        status = rm->increaseStreamUserCounter(
+            reinterpret_cast<Stream *>(stream_handle));
         rm->unlockValidStreamMutex();
-        PAL_ERR(LOG_TAG, "failed to increase stream user count");
+    }
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "failed to pin stream %pK status %d", stream_handle, status);
         return status;
     }
-    rm->unlockValidStreamMutex();
+
+    PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
+    s =  reinterpret_cast<Stream *>(stream_handle);
 
     status = s->write(buf);
     if (status < 0) {
         PAL_ERR(LOG_TAG, "stream write failed status %d", status);
     }
+    PAL_TRACE("handle %p size %zu status %d", stream_handle, buf->size, status);
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    if (slot != STREAM_HANDLE_INVALID_SLOT) {
+        rm->unpinActiveStream(slot);
+    } else {
+        rm->lockValidStreamMutex();
+        rm->decreaseStreamUserCounter(s);
+        rm->unlockValidStreamMutex();
+    }
 
     PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
     return status;
@@ -396,6 +416,7 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
 {
     Stream *s = NULL;
     int status;
+    uint32_t slot = STREAM_HANDLE_INVALID_SLOT;
     std::shared_ptr<ResourceManager> rm = NULL;
 
     rm = ResourceManager::getInstance();
@@ -404,32 +425,48 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
         status = -EINVAL;
         return status;
     }
-    rm->lockValidStreamMutex();
-    if (!stream_handle || !rm->isActiveStream(stream_handle) || !buf) {
-        rm->unlockValidStreamMutex();
+    if (!stream_handle || !buf) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
         return status;
     }
 
-    PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
-    if (0 != status) {
+    status = rm->pinActiveStream(stream_handle, &slot);
+    if (-ENOENT == status) {
+        /* handle not tracked by the lock free table, use the locked path */
+        slot = STREAM_HANDLE_INVALID_SLOT;
+        rm->lockValidStreamMutex();
+        if (!rm->isActiveStream(stream_handle)) {
+            rm->unlockValidStreamMutex();
+            status = -EINVAL;
+            PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
+            return status;
+        }
+        status = rm->increaseStreamUserCounter(
+            reinterpret_cast<Stream *>(stream_handle));
         rm->unlockValidStreamMutex();
-        PAL_ERR(LOG_TAG, "failed to increase stream user count");
+    }
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "failed to pin stream %pK status %d", stream_handle, status);
         return status;
     }
-    rm->unlockValidStreamMutex();
+
+    PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
+    s =  reinterpret_cast<Stream *>(stream_handle);
 
     status = s->read(buf);
     if (status < 0) {
         PAL_ERR(LOG_TAG, "stream read failed status %d", status);
     }
+    PAL_TRACE("handle %p size %zu status %d", stream_handle, buf->size, status);
 
-    rm->lockValidStreamMutex();
-    rm->decreaseStreamUserCounter(s);
-    rm->unlockValidStreamMutex();
+    if (slot != STREAM_HANDLE_INVALID_SLOT) {
+        rm->unpinActiveStream(slot);
+    } else {
+        rm->lockValidStreamMutex();
+        rm->decreaseStreamUserCounter(s);
+        rm->unlockValidStreamMutex();
+    }
     PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
     return status;
 }
@@ -44,6 +44,16 @@
 
 extern uint32_t pal_log_lvl;
 
+/*
+ * Most verbose level built in, e.g. -DPAL_LOG_MAX_LEVEL=PAL_LOG_INFO. Calls
+ * above it are compiled out along with their arguments, whatever the
+ * runtime pal_log_lvl says. Errors are always built in.
+ */
+#ifndef PAL_LOG_MAX_LEVEL
+#define PAL_LOG_MAX_LEVEL PAL_LOG_VERBOSE
+#endif
+#define PAL_LOG_BUILT_IN(lvl) ((lvl) <= PAL_LOG_MAX_LEVEL)
+
 #define PAL_FATAL(log_tag, arg,...)                                       \
     if (pal_log_lvl & PAL_LOG_ERR) {                              \
         ALOGE("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__);\
@@ -55,14 +65,14 @@ extern uint32_t pal_log_lvl;
         ALOGE("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__);\
     }
 #define PAL_DBG(log_tag,arg,...)                                           \
-    if (pal_log_lvl & PAL_LOG_DBG) {                               \
+    if (PAL_LOG_BUILT_IN(PAL_LOG_DBG) && (pal_log_lvl & PAL_LOG_DBG)) { \
         ALOGD("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__); \
     }
 #define PAL_INFO(log_tag,arg,...)                                         \
-    if (pal_log_lvl & PAL_LOG_INFO) {                             \
+    if (PAL_LOG_BUILT_IN(PAL_LOG_INFO) && (pal_log_lvl & PAL_LOG_INFO)) { \
         ALOGI("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__);\
     }
 #define PAL_VERBOSE(log_tag,arg,...)                                      \
-    if (pal_log_lvl & PAL_LOG_VERBOSE) {                          \
+    if (PAL_LOG_BUILT_IN(PAL_LOG_VERBOSE) && (pal_log_lvl & PAL_LOG_VERBOSE)) { \
         ALOGV("%s: %d: "  arg, __func__, __LINE__, ##__VA_ARGS__);\
     }
@@ -903,6 +903,7 @@ typedef enum {
     PAL_PARAM_ID_VOLUME_USING_SET_PARAM = 55,
     PAL_PARAM_ID_UHQA_FLAG = 56,
     PAL_PARAM_ID_STREAM_ATTRIBUTES = 57,
+    PAL_PARAM_ID_UIEFFECT_BATCH = 58,
 } pal_param_id_type_t;
 
 /** HDMI/DP */
@@ -1020,6 +1021,15 @@ typedef struct pal_param_device_rotation {
     pal_speaker_rotation_type    rotation_type;
 } pal_param_device_rotation_t;
 
+/* Payload For ID: PAL_PARAM_ID_UIEFFECT_BATCH
+ * Description   : several PAL_PARAM_ID_UIEFFECT parameters in one call.
+ *                 pal_param_payload whose payload is a sequence of
+ *                 pal_param_payload records, each holding one
+ *                 effect_pal_payload_t, the next record starting at the
+ *                 following 4 byte boundary. They are applied in order
+ *                 and the first failure ends the batch.
+ */
+
 /* Payload For ID: PAL_PARAM_ID_UHQA_FLAG
  * Description   : use to enable/disable USB high quality audio from userend
 */
@@ -35,6 +35,8 @@
 #include <bt_intf.h>
 #include <bt_ble.h>
 #include <vector>
+#include <map>
+#include <string>
 #include <mutex>
 #include <system/audio.h>
 
@@ -77,6 +79,34 @@ typedef uint16_t (*audio_sink_get_a2dp_latency_t)(void);
 typedef bool (*audio_is_scrambling_enabled_t)(void);
 typedef int (*audio_sink_suspend_t)(void);
 
+struct bt_codec_plugin {
+    void *handle;
+    open_fn_t open;
+    uint32_t abiVersion;
+};
+
+/*
+ * Process wide cache of the BT codec plugin libraries. Each library is
+ * opened and its entry points resolved once, then kept loaded and
+ * handed out by codec format and direction.
+ */
+class BtCodecPluginRegistry
+{
+public:
+    static BtCodecPluginRegistry *getInstance();
+    /* load every library listed in the BT codec map */
+    void preload(const std::map<std::pair<uint32_t, std::string>, std::string> &codecMap);
+    int getPlugin(uint32_t codecFormat, codec_type type,
+                  const struct bt_codec_plugin **plugin);
+private:
+    BtCodecPluginRegistry() {}
+    int loadLocked(const std::string &libPath, const struct bt_codec_plugin **plugin);
+    std::mutex mLock;
+    /* by library path, entries are never removed */
+    std::map<std::string, struct bt_codec_plugin> mLibs;
+    std::map<std::pair<uint32_t, codec_type>, const struct bt_codec_plugin *> mCodecs;
+};
+
 // Abstract base class
 class Bluetooth : public Device
 {
@@ -87,7 +117,6 @@ protected:
     struct pal_media_config    codecConfig;
     codec_format_t             codecFormat;
     void                       *codecInfo;
-    void                       *pluginHandler;
     bt_codec_t                 *pluginCodec;
     bool                       isAbrEnabled;
     bool                       isConfigured;
@@ -103,8 +132,7 @@ protected:
     std::mutex                 mAbrMutex;
     int                        totalActiveSessionRequests;
 
-    int getPluginPayload(void **handle, bt_codec_t **btCodec,
-                         bt_enc_payload_t **out_buf,
+    int getPluginPayload(bt_codec_t **btCodec, bt_enc_payload_t **out_buf,
                          codec_type codecType);
     int configureA2dpEncoderDecoder();
     int configureNrecParameters(bool isNrecEnabled);
@@ -41,6 +41,7 @@
 #include<vector>
 #include "apm_api.h"
 #include "ResourceManager.h"
+#include "SpeakerTempSampler.h"
 
 class Device;
 
@@ -119,10 +120,12 @@ protected :
     static int numberOfRequest;
     static struct pal_device_info vi_device;
     struct spDeviceInfo spDevInfo;
+    SpeakerTempSampler tempSampler;
 
 private :
     static bool isSharedBE;
     int populateSpDevInfoCreateCalThread(struct pal_device *device);
+    int initTempSampler();
 
 public:
     static std::thread mCalThread;
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SPEAKER_TEMP_SAMPLER_H
+#define SPEAKER_TEMP_SAMPLER_H
+
+#include <stdint.h>
+#include <tinyalsa/asoundlib.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* one per speaker position, see SPKR_RIGHT..SPKR_BOTTOM */
+#define SPKR_TEMP_MAX_CHANNELS 4
+/* a sample younger than this is handed out instead of reading again */
+#define SPKR_TEMP_SAMPLE_MAX_AGE_MS 500
+
+/*
+ * Reads the speaker temperature controls of one device. Control names
+ * are resolved to mixer_ctl handles once, all channels are read in one
+ * pass and the result is published as a snapshot that readers copy
+ * without taking a lock. Channels without a control read as -EINVAL.
+ */
+class SpeakerTempSampler
+{
+public:
+    SpeakerTempSampler();
+    /* resolve names on mixer, returns -ENOENT if a control is missing */
+    int init(struct mixer *mixer, const std::vector<std::string> &ctlNames);
+    bool isInitialized(struct mixer *mixer);
+    /*
+     * Copy the temperature of each channel into temps. A recent sample is
+     * copied without locking, otherwise the controls are read once for
+     * all waiting callers.
+     */
+    int sample(int *temps, int numChannels);
+    /* copy the last published sample, returns -ENODATA if there is none */
+    int getSnapshot(int *temps, int numChannels, uint64_t *tsNs);
+private:
+    void publish(const int *temps, uint64_t tsNs);
+    std::mutex sampleMutex;
+    /* written under sampleMutex once the controls are resolved */
+    std::atomic<struct mixer *> mixer_;
+    std::vector<std::string> ctlNames_;
+    struct mixer_ctl *ctls[SPKR_TEMP_MAX_CHANNELS];
+    int numChannels_;
+    /* odd while a sample is being published */
+    std::atomic<uint32_t> seq;
+    std::atomic<uint64_t> sampleTsNs;
+    std::atomic<int> sampleTemps[SPKR_TEMP_MAX_CHANNELS];
+};
+
+#endif //SPEAKER_TEMP_SAMPLER_H
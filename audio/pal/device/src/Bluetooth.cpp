@@ -133,36 +133,115 @@ bool Bluetooth::isPlaceholderEncoder()
     }
 }
 
-int Bluetooth::getPluginPayload(void **libHandle, bt_codec_t **btCodec,
-              bt_enc_payload_t **out_buf, codec_type codecType)
+BtCodecPluginRegistry *BtCodecPluginRegistry::getInstance()
 {
-    std::string lib_path;
-    open_fn_t plugin_open_fn = NULL;
-    int status = 0;
-    bt_codec_t *codec = NULL;
-    void *handle = NULL;
+    static BtCodecPluginRegistry *instance = new BtCodecPluginRegistry();
 
-    lib_path = rm->getBtCodecLib(codecFormat, (codecType == ENC ? "enc" : "dec"));
-    if (lib_path.empty()) {
-        PAL_ERR(LOG_TAG, "fail to get BT codec library");
-        return -ENOSYS;
+    return instance;
+}
+
+int BtCodecPluginRegistry::loadLocked(const std::string &libPath,
+                                      const struct bt_codec_plugin **plugin)
+{
+    std::map<std::string, struct bt_codec_plugin>::iterator iter;
+    struct bt_codec_plugin entry = {};
+    abi_version_fn_t abi_version_fn = NULL;
+
+    iter = mLibs.find(libPath);
+    if (iter != mLibs.end()) {
+        *plugin = &iter->second;
+        return 0;
     }
 
-    handle = dlopen(lib_path.c_str(), RTLD_NOW);
-    if (handle == NULL) {
-        PAL_ERR(LOG_TAG, "failed to dlopen lib %s", lib_path.c_str());
+    entry.handle = dlopen(libPath.c_str(), RTLD_NOW);
+    if (entry.handle == NULL) {
+        PAL_ERR(LOG_TAG, "failed to dlopen lib %s", libPath.c_str());
         return -EINVAL;
     }
 
     dlerror();
-    plugin_open_fn = (open_fn_t)dlsym(handle, "plugin_open");
-    if (!plugin_open_fn) {
+    entry.open = (open_fn_t)dlsym(entry.handle, "plugin_open");
+    if (!entry.open) {
         PAL_ERR(LOG_TAG, "dlsym to open fn failed, err = '%s'", dlerror());
-        status = -EINVAL;
         goto error;
     }
 
-    status = plugin_open_fn(&codec, codecFormat, codecType);
+    /* plugins built before the version was introduced do not export it */
+    abi_version_fn = (abi_version_fn_t)dlsym(entry.handle, "plugin_abi_version");
+    entry.abiVersion = abi_version_fn ? abi_version_fn() : BT_CODEC_PLUGIN_ABI_VERSION;
+    if (entry.abiVersion != BT_CODEC_PLUGIN_ABI_VERSION) {
+        PAL_ERR(LOG_TAG, "lib %s abi version %u, expected %u", libPath.c_str(),
+                entry.abiVersion, BT_CODEC_PLUGIN_ABI_VERSION);
+        goto error;
+    }
+
+    PAL_DBG(LOG_TAG, "loaded lib %s abi version %u", libPath.c_str(), entry.abiVersion);
+    *plugin = &(mLibs[libPath] = entry);
+    return 0;
+
+error:
+    dlclose(entry.handle);
+    return -EINVAL;
+}
+
+void BtCodecPluginRegistry::preload(
+        const std::map<std::pair<uint32_t, std::string>, std::string> &codecMap)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    const struct bt_codec_plugin *plugin = NULL;
+    codec_type type;
+
+    for (auto &codec : codecMap) {
+        type = (codec.first.second == "enc") ? ENC : DEC;
+        if (loadLocked(codec.second, &plugin))
+            continue;
+        mCodecs[std::make_pair(codec.first.first, type)] = plugin;
+    }
+    PAL_INFO(LOG_TAG, "preloaded %zu BT codec libs for %zu codecs",
+             mLibs.size(), mCodecs.size());
+}
+
+int BtCodecPluginRegistry::getPlugin(uint32_t codecFormat, codec_type type,
+                                     const struct bt_codec_plugin **plugin)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    std::map<std::pair<uint32_t, codec_type>, const struct bt_codec_plugin *>::iterator iter;
+    std::string lib_path;
+    int status = 0;
+
+    iter = mCodecs.find(std::make_pair(codecFormat, type));
+    if (iter != mCodecs.end()) {
+        *plugin = iter->second;
+        return 0;
+    }
+
+    /* not preloaded or failed to load before, try again */
+    lib_path = ResourceManager::getBtCodecLib(codecFormat, (type == ENC ? "enc" : "dec"));
+    if (lib_path.empty()) {
+        PAL_ERR(LOG_TAG, "fail to get BT codec library");
+        return -ENOSYS;
+    }
+
+    status = loadLocked(lib_path, plugin);
+    if (!status)
+        mCodecs[std::make_pair(codecFormat, type)] = *plugin;
+
+    return status;
+}
+
+int Bluetooth::getPluginPayload(bt_codec_t **btCodec, bt_enc_payload_t **out_buf,
+                                codec_type codecType)
+{
+    const struct bt_codec_plugin *plugin = NULL;
+    int status = 0;
+    bt_codec_t *codec = NULL;
+
+    status = BtCodecPluginRegistry::getInstance()->getPlugin(codecFormat, codecType,
+                                                             &plugin);
+    if (status)
+        return status;
+
+    status = plugin->open(&codec, codecFormat, codecType);
     if (status) {
         PAL_ERR(LOG_TAG, "failed to open plugin %d", status);
         goto error;
@@ -174,15 +253,11 @@ int Bluetooth::getPluginPayload(void **libHandle, bt_codec_t **btCodec,
         goto error;
     }
     *btCodec = codec;
-    *libHandle = handle;
     goto done;
 
 error:
     if (codec)
         codec->close_plugin(codec);
-
-    if (handle)
-        dlclose(handle);
 done:
     return status;
 }
@@ -224,7 +299,7 @@ int Bluetooth::configureA2dpEncoderDecoder()
     /* Retrieve plugin library from resource manager.
      * Map to interested symbols.
      */
-    status = getPluginPayload(&pluginHandler, &pluginCodec, &out_buf, codecType);
+    status = getPluginPayload(&pluginCodec, &out_buf, codecType);
     if (status) {
         PAL_ERR(LOG_TAG, "failed to payload from plugin");
         goto error;
@@ -661,7 +736,6 @@ void Bluetooth::startAbr()
     std::ostringstream disconnectCtrlName;
     unsigned int flags;
     uint32_t codecTagId = 0, miid = 0;
-    void *pluginLibHandle = NULL;
     bt_codec_t *codec = NULL;
     bt_enc_payload_t *out_buf = NULL;
     custom_block_t *blk = NULL;
@@ -801,7 +875,7 @@ void Bluetooth::startAbr()
             goto disconnect_fe;
         }
 
-        ret = getPluginPayload(&pluginLibHandle, &codec, &out_buf, (codecType == DEC ? ENC : DEC));
+        ret = getPluginPayload(&codec, &out_buf, (codecType == DEC ? ENC : DEC));
         if (ret) {
             PAL_ERR(LOG_TAG, "getPluginPayload failed");
             goto disconnect_fe;
@@ -822,7 +896,6 @@ void Bluetooth::startAbr()
                   (uint32_t *)blk->payload, blk->payload_sz, miid, blk->param_id);
 
         codec->close_plugin(codec);
-        dlclose(pluginLibHandle);
 
         if (!paramData) {
             PAL_ERR(LOG_TAG, "Failed to populateAPMHeader");
@@ -907,7 +980,7 @@ void Bluetooth::startAbr()
                 goto disconnect_fe;
             }
 
-            ret = getPluginPayload(&pluginLibHandle, &codec, &out_buf, (codecType == DEC ? ENC : DEC));
+            ret = getPluginPayload(&codec, &out_buf, (codecType == DEC ? ENC : DEC));
             if (ret) {
                 PAL_ERR(LOG_TAG, "getPluginPayload failed");
                 goto disconnect_fe;
@@ -937,7 +1010,6 @@ void Bluetooth::startAbr()
             }
 
             codec->close_plugin(codec);
-            dlclose(pluginLibHandle);
 
             if (fbDevice.id == PAL_DEVICE_IN_BLUETOOTH_SCO_HEADSET) {
                 /* COP v2 DEPACKETIZER Module Configuration */
@@ -1259,7 +1331,6 @@ BtA2dp::BtA2dp(struct pal_device *device, std::shared_ptr<ResourceManager> Rm)
 {
     a2dpRole = (device->id == PAL_DEVICE_IN_BLUETOOTH_A2DP) ? SINK : SOURCE;
     codecType = (device->id == PAL_DEVICE_IN_BLUETOOTH_A2DP) ? DEC : ENC;
-    pluginHandler = NULL;
     pluginCodec = NULL;
 
     init();
@@ -1609,10 +1680,6 @@ int BtA2dp::stopPlayback()
             pluginCodec->close_plugin(pluginCodec);
             pluginCodec = NULL;
         }
-        if (pluginHandler) {
-            dlclose(pluginHandler);
-            pluginHandler = NULL;
-        }
     }
 
     PAL_DBG(LOG_TAG, "Stop A2DP playback, total active sessions :%d",
@@ -1774,10 +1841,6 @@ int BtA2dp::stopCapture()
             pluginCodec->close_plugin(pluginCodec);
             pluginCodec = NULL;
         }
-        if (pluginHandler) {
-            dlclose(pluginHandler);
-            pluginHandler = NULL;
-        }
     }
     PAL_DBG(LOG_TAG, "Stop A2DP capture, total active sessions :%d",
             totalActiveSessionRequests);
@@ -2025,7 +2088,6 @@ BtSco::BtSco(struct pal_device *device, std::shared_ptr<ResourceManager> Rm)
     : Bluetooth(device, Rm)
 {
     codecType = (device->id == PAL_DEVICE_OUT_BLUETOOTH_SCO) ? ENC : DEC;
-    pluginHandler = NULL;
     pluginCodec = NULL;
 }
 
@@ -2298,10 +2360,6 @@ int BtSco::stop()
         pluginCodec->close_plugin(pluginCodec);
         pluginCodec = NULL;
     }
-    if (pluginHandler) {
-        dlclose(pluginHandler);
-        pluginHandler = NULL;
-    }
 
     Device::stop_l();
     if (isAbrEnabled == false)
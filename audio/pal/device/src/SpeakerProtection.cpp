@@ -290,33 +290,57 @@ int SpeakerProtection::getCpsDevNumber(std::string mixer_name)
     return status;
 }
 
-int SpeakerProtection::getSpeakerTemperature(int spkr_pos)
+/* Resolve the temperature controls of this device once per mixer */
+int SpeakerProtection::initTempSampler()
 {
-    struct mixer_ctl *ctl;
+    std::vector<std::string> ctlNames;
     std::string mixer_ctl_name;
-    int status = 0;
-    /**
-     * It is assumed that for Mono speakers only right speaker will be there.
-     * Thus we will get the Temperature just for right speaker.
-     * TODO: Get the channel from RM.xml
-     */
-    PAL_DBG(LOG_TAG, "Enter Speaker Get Temperature %d", spkr_pos);
-    mixer_ctl_name = rm->getSpkrTempCtrl(spkr_pos);
-    if (mixer_ctl_name.empty()) {
-        PAL_DBG(LOG_TAG, "Using default mixer control");
-        mixer_ctl_name = getDefaultSpkrTempCtrl(spkr_pos);
+    int i;
+
+    if (tempSampler.isInitialized(hwMixer))
+        return 0;
+
+    if (ResourceManager::isSpeakerHandsetProtectionSeparate) {
+        ctlNames = rm->getDeviceTempCtrl(mDeviceAttr.id);
+        if (ctlNames.empty()) {
+            PAL_ERR(LOG_TAG, "map not found fallback to v2");
+            return -EINVAL;
+        }
+        if (ctlNames.size() > (size_t)spDevInfo.numChannels)
+            ctlNames.resize(spDevInfo.numChannels);
+    } else {
+        /**
+         * It is assumed that for Mono speakers only right speaker will be there.
+         * Thus we will get the Temperature just for right speaker.
+         * TODO: Get the channel from RM.xml
+         */
+        for (i = 0; i < numberOfChannels; i++) {
+            mixer_ctl_name = rm->getSpkrTempCtrl(i);
+            if (mixer_ctl_name.empty()) {
+                PAL_DBG(LOG_TAG, "Using default mixer control");
+                mixer_ctl_name = getDefaultSpkrTempCtrl(i);
+            }
+            ctlNames.push_back(mixer_ctl_name);
+        }
     }
 
     PAL_DBG(LOG_TAG, "audio_mixer %pK", hwMixer);
+    return tempSampler.init(hwMixer, ctlNames);
+}
 
-    ctl = mixer_get_ctl_by_name(hwMixer, mixer_ctl_name.c_str());
-    if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_ctl_name.c_str());
-        status = -EINVAL;
-        return status;
-    }
+int SpeakerProtection::getSpeakerTemperature(int spkr_pos)
+{
+    int temps[SPKR_TEMP_MAX_CHANNELS];
+    int status = 0;
 
-    status = mixer_ctl_get_value(ctl, 0);
+    PAL_DBG(LOG_TAG, "Enter Speaker Get Temperature %d", spkr_pos);
+    if (spkr_pos < 0 || spkr_pos >= SPKR_TEMP_MAX_CHANNELS)
+        return -EINVAL;
+
+    initTempSampler();
+    status = tempSampler.sample(temps, spkr_pos + 1);
+    if (!status)
+        status = temps[spkr_pos];
 
     PAL_DBG(LOG_TAG, "Exiting Speaker Get Temperature %d", status);
 
@@ -1792,49 +1816,33 @@ void SpeakerProtection::spkrCalibrationThreadV2()
 int SpeakerProtection::getDeviceTemperatureList()
 {
     int i = 0;
-    int value;
-    //int status = 0;
-    struct mixer_ctl *ctl;
-    std::string mixer_ctl_name;
-    std::vector<std::string> temp_ctrls;
+    int status = 0;
     PAL_DBG(LOG_TAG, "Enter Speaker Get Temperature List");
 
     /* Get the  mixer controls for temperature based on the device id */
-
-    temp_ctrls = rm->getDeviceTempCtrl(mDeviceAttr.id);
-    if (temp_ctrls.empty()) {
-        PAL_ERR(LOG_TAG,"map not found fallback to v2");
-        /* TODO: Assume handset is not present and call default temperature function */
-        return -EINVAL;
-    }
+    status = initTempSampler();
+    if (status == -EINVAL)
+        return status;
 
     /*
      * Number of temperature values would be number of speakers associated
-     * with that device.
-     * Traverse over the vector for num of channels and for each channel
-     * store the value in temperature list.
+     * with that device, all of them are read in one pass.
      */
+    status = tempSampler.sample(spDevInfo.deviceTempList, spDevInfo.numChannels);
+    if (status) {
+        PAL_ERR(LOG_TAG, "Failed to sample device temperature, status %d", status);
+        return -EINVAL;
+    }
 
     for(i = 0; i < spDevInfo.numChannels; i++) {
-        PAL_ERR(LOG_TAG, "audio_mixer %pK", hwMixer);
-        mixer_ctl_name = temp_ctrls[i];
-        ctl = mixer_get_ctl_by_name(hwMixer, mixer_ctl_name.c_str());
-        if(!ctl) {
-            PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n",
-                    mixer_ctl_name.c_str());
-            return -EINVAL;
-        }
-
-        value = mixer_ctl_get_value(ctl, 0);
-        PAL_INFO(LOG_TAG, "Device Get Temperature %s  %d",mixer_ctl_name.c_str(),
-                                                                           value);
-        if ((value == -EINVAL) ||
-            (value > TZ_TEMP_MAX_THRESHOLD) ||
-            (value < TZ_TEMP_MIN_THRESHOLD)) {
+        PAL_INFO(LOG_TAG, "Device Get Temperature channel %d  %d", i,
+                 spDevInfo.deviceTempList[i]);
+        if ((spDevInfo.deviceTempList[i] == -EINVAL) ||
+            (spDevInfo.deviceTempList[i] > TZ_TEMP_MAX_THRESHOLD) ||
+            (spDevInfo.deviceTempList[i] < TZ_TEMP_MIN_THRESHOLD)) {
             PAL_ERR(LOG_TAG, "Device Temperature out of range or invalid");
             return -EINVAL;
         }
-        spDevInfo.deviceTempList[i] = value;
         /* Convert to Q6 format */
         spDevInfo.deviceTempList[i] *= (1 << 6);
     }
@@ -1852,14 +1860,15 @@ int SpeakerProtection::getDeviceTemperatureList()
 void SpeakerProtection::getSpeakerTemperatureList()
 {
     int i = 0;
-    int value;
     PAL_DBG(LOG_TAG, "Enter Speaker Get Temperature List");
 
-    for(i = 0; i < numberOfChannels; i++) {
-         value = getSpeakerTemperature(i);
-         PAL_DBG(LOG_TAG, "Temperature %d ", value);
-         spkerTempList[i] = value;
+    initTempSampler();
+    if (tempSampler.sample(spkerTempList, numberOfChannels)) {
+        for(i = 0; i < numberOfChannels; i++)
+            spkerTempList[i] = -EINVAL;
     }
+    for(i = 0; i < numberOfChannels; i++)
+        PAL_DBG(LOG_TAG, "Temperature %d ", spkerTempList[i]);
     PAL_DBG(LOG_TAG, "Exit Speaker Get Temperature List");
 }
 
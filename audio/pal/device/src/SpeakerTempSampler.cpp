@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: SpeakerTempSampler"
+
+#include "SpeakerTempSampler.h"
+#include "PalCommon.h"
+#include <errno.h>
+#include <time.h>
+
+static uint64_t getBootTimeNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+SpeakerTempSampler::SpeakerTempSampler()
+    : mixer_(nullptr), numChannels_(0), seq(0), sampleTsNs(0)
+{
+    int i;
+
+    for (i = 0; i < SPKR_TEMP_MAX_CHANNELS; i++) {
+        ctls[i] = nullptr;
+        sampleTemps[i].store(-EINVAL, std::memory_order_relaxed);
+    }
+}
+
+int SpeakerTempSampler::init(struct mixer *mixer,
+                             const std::vector<std::string> &ctlNames)
+{
+    std::lock_guard<std::mutex> lock(sampleMutex);
+    int invalid[SPKR_TEMP_MAX_CHANNELS];
+    int status = 0;
+    int i;
+
+    if (!mixer || ctlNames.empty()) {
+        PAL_ERR(LOG_TAG, "invalid mixer %pK or no controls", mixer);
+        return -EINVAL;
+    }
+    if (ctlNames.size() > SPKR_TEMP_MAX_CHANNELS) {
+        PAL_ERR(LOG_TAG, "%zu controls, max %d", ctlNames.size(),
+                SPKR_TEMP_MAX_CHANNELS);
+        return -EINVAL;
+    }
+
+    numChannels_ = ctlNames.size();
+    for (i = 0; i < numChannels_; i++) {
+        ctls[i] = mixer_get_ctl_by_name(mixer, ctlNames[i].c_str());
+        if (!ctls[i]) {
+            PAL_ERR(LOG_TAG, "Invalid mixer control: %s", ctlNames[i].c_str());
+            status = -ENOENT;
+        }
+    }
+    ctlNames_ = ctlNames;
+    /* old samples may belong to other controls */
+    for (i = 0; i < SPKR_TEMP_MAX_CHANNELS; i++)
+        invalid[i] = -EINVAL;
+    publish(invalid, 0);
+    mixer_.store(mixer, std::memory_order_release);
+    PAL_DBG(LOG_TAG, "resolved %d temperature controls, status %d",
+            numChannels_, status);
+
+    return status;
+}
+
+bool SpeakerTempSampler::isInitialized(struct mixer *mixer)
+{
+    struct mixer *cur = mixer_.load(std::memory_order_acquire);
+
+    return cur && cur == mixer;
+}
+
+void SpeakerTempSampler::publish(const int *temps, uint64_t tsNs)
+{
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    int i;
+
+    seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (i = 0; i < SPKR_TEMP_MAX_CHANNELS; i++)
+        sampleTemps[i].store(temps[i], std::memory_order_relaxed);
+    sampleTsNs.store(tsNs, std::memory_order_relaxed);
+    seq.store(s + 2, std::memory_order_release);
+}
+
+int SpeakerTempSampler::getSnapshot(int *temps, int numChannels, uint64_t *tsNs)
+{
+    int snap[SPKR_TEMP_MAX_CHANNELS];
+    uint64_t ts;
+    uint32_t s1, s2;
+    int i;
+
+    if (numChannels > SPKR_TEMP_MAX_CHANNELS)
+        return -EINVAL;
+
+    do {
+        s1 = seq.load(std::memory_order_acquire);
+        for (i = 0; i < SPKR_TEMP_MAX_CHANNELS; i++)
+            snap[i] = sampleTemps[i].load(std::memory_order_relaxed);
+        ts = sampleTsNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        s2 = seq.load(std::memory_order_relaxed);
+    } while ((s1 & 1) || s1 != s2);
+
+    if (!ts)
+        return -ENODATA;
+
+    for (i = 0; i < numChannels; i++)
+        temps[i] = snap[i];
+    if (tsNs)
+        *tsNs = ts;
+
+    return 0;
+}
+
+int SpeakerTempSampler::sample(int *temps, int numChannels)
+{
+    int values[SPKR_TEMP_MAX_CHANNELS];
+    uint64_t now, ts;
+    int i;
+
+    if (numChannels > SPKR_TEMP_MAX_CHANNELS)
+        return -EINVAL;
+
+    /* a recent sample is copied without taking the lock */
+    if (!getSnapshot(temps, numChannels, &ts) &&
+        getBootTimeNs() - ts < SPKR_TEMP_SAMPLE_MAX_AGE_MS * 1000000ULL)
+        return 0;
+
+    /* a caller that waited here usually finds the sample it needs */
+    std::lock_guard<std::mutex> lock(sampleMutex);
+
+    if (!mixer_.load(std::memory_order_relaxed))
+        return -EINVAL;
+
+    now = getBootTimeNs();
+    ts = sampleTsNs.load(std::memory_order_relaxed);
+    if (ts && now - ts < SPKR_TEMP_SAMPLE_MAX_AGE_MS * 1000000ULL)
+        return getSnapshot(temps, numChannels, NULL);
+
+    for (i = 0; i < SPKR_TEMP_MAX_CHANNELS; i++) {
+        if (i < numChannels_ && ctls[i])
+            values[i] = mixer_ctl_get_value(ctls[i], 0);
+        else
+            values[i] = -EINVAL;
+    }
+    publish(values, now);
+
+    for (i = 0; i < numChannels; i++)
+        temps[i] = values[i];
+
+    return 0;
+}
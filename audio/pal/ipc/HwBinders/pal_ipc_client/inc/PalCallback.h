@@ -30,6 +30,7 @@
 #pragma once
 
 #include <vendor/qti/hardware/pal/1.0/IPALCallback.h>
+#include <vendor/qti/hardware/pal/1.1/types.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include "PalApi.h"
@@ -58,6 +59,8 @@ using PalParamPayload = ::vendor::qti::hardware::pal::V1_0::PalParamPayload;
 using PalEventReadWriteDonePayload =
                      ::vendor::qti::hardware::pal::V1_0::PalEventReadWriteDonePayload;
 using IPALCallback = ::vendor::qti::hardware::pal::V1_0::IPALCallback;
+using PalShmemRingConfig = ::vendor::qti::hardware::pal::V1_1::PalShmemRingConfig;
+using PalShmemBuffer = ::vendor::qti::hardware::pal::V1_1::PalShmemBuffer;
 using android::hardware::hidl_handle;
 using android::hardware::hidl_memory;
 
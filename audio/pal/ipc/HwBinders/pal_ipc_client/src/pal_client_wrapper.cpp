@@ -29,22 +29,71 @@
 
 #define LOG_TAG "pal_client_wrapper"
 #include <vendor/qti/hardware/pal/1.0/IPAL.h>
+#include <vendor/qti/hardware/pal/1.1/IPAL.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <log/log.h>
+#include <cutils/ashmem.h>
+#include <sys/mman.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
 #include "PalApi.h"
 #include "inc/PalCallback.h"
 
 using android::hardware::Return;
 using android::hardware::hidl_vec;
 using vendor::qti::hardware::pal::V1_0::IPAL;
+using IPAL_V1_1 = vendor::qti::hardware::pal::V1_1::IPAL;
 
 using vendor::qti::hardware::pal::V1_0::implementation::PalCallback;
 using android::sp;
 
+#define PAL_SHMEM_RING_MAX_SLOTS 4
+#define PAL_SHMEM_ALIGN(x) (((x) + 63) & ~63)
+
+/*
+ * Client end of the buffer ring mapped with ipc_pal_stream_map_shmem_ring,
+ * reads and writes copy into a slot and pass only its descriptor.
+ */
+struct pal_shmem_ring {
+    int fd = -1;
+    uint8_t *base = nullptr;
+    size_t size = 0;
+    uint32_t slot_count = 0;
+    uint32_t slot_size = 0;
+    uint32_t metadata_size = 0;
+    std::atomic<uint32_t> next_slot{0};
+
+    ~pal_shmem_ring()
+    {
+        if (base)
+            munmap(base, size);
+        if (fd >= 0)
+            close(fd);
+    }
+    uint8_t *payload(uint32_t slot)
+    {
+        return base + (size_t)slot * (slot_size + metadata_size);
+    }
+    uint8_t *metadata(uint32_t slot)
+    {
+        return payload(slot) + slot_size;
+    }
+};
+
+struct pal_client_stream {
+    uint32_t flags;
+    std::shared_ptr<pal_shmem_ring> ring;
+};
+
 bool pal_server_died = false;
 android::sp<IPAL> pal_client = NULL;
+android::sp<IPAL_V1_1> pal_shmem_client = NULL;
 sp<server_death_notifier> Server_death_notifier = NULL;
+std::map<pal_stream_handle_t *, pal_client_stream> pal_client_streams;
+std::mutex pal_client_streams_lock;
 
 std::mutex gLock;
 
@@ -71,11 +120,178 @@ android::sp<IPAL> get_pal_server() {
             pal_client->linkToDeath(Server_death_notifier, 0);
             ALOGE("palclient linked to death server death \n", __func__);
         }
+        /* servers without the 1.1 interface only take buffers by value */
+        pal_shmem_client = IPAL_V1_1::castFrom(pal_client);
     }
 exit:
     return pal_client ;
 }
 
+static android::sp<IPAL_V1_1> get_pal_shmem_server()
+{
+    if (get_pal_server() == nullptr)
+        return nullptr;
+    std::lock_guard<std::mutex> guard(gLock);
+    return pal_shmem_client;
+}
+
+static std::shared_ptr<pal_shmem_ring> pal_shmem_ring_get(pal_stream_handle_t *stream_handle)
+{
+    std::lock_guard<std::mutex> lock(pal_client_streams_lock);
+    auto it = pal_client_streams.find(stream_handle);
+
+    return it != pal_client_streams.end() ? it->second.ring : nullptr;
+}
+
+/* size the ring after the buffer config, streams on extern memory need none */
+static void pal_shmem_ring_setup(pal_stream_handle_t *stream_handle,
+                                 pal_buffer_config_t *in_buff_cfg,
+                                 pal_buffer_config_t *out_buff_cfg)
+{
+    android::sp<IPAL_V1_1> pal_client = get_pal_shmem_server();
+    std::shared_ptr<pal_shmem_ring> ring;
+    PalShmemRingConfig config = {};
+    pal_buffer_config_t *cfgs[] = {in_buff_cfg, out_buff_cfg};
+    native_handle_t *ringHidlHandle = nullptr;
+    uint32_t count = 1;
+    void *base;
+    int32_t ret;
+
+    if (pal_client == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(pal_client_streams_lock);
+        auto it = pal_client_streams.find(stream_handle);
+        if (it == pal_client_streams.end() ||
+                (it->second.flags & PAL_STREAM_FLAG_EXTERN_MEM))
+            return;
+    }
+
+    for (auto cfg : cfgs) {
+        if (!cfg)
+            continue;
+        config.slotSize = std::max(config.slotSize, (uint32_t)cfg->buf_size);
+        config.metadataSize = std::max(config.metadataSize,
+                                       (uint32_t)cfg->max_metadata_size);
+        count = std::max(count, (uint32_t)cfg->buf_count);
+    }
+    if (!config.slotSize)
+        return;
+    config.slotCount = std::min(count, (uint32_t)PAL_SHMEM_RING_MAX_SLOTS);
+    config.slotSize = PAL_SHMEM_ALIGN(config.slotSize);
+    config.metadataSize = PAL_SHMEM_ALIGN(config.metadataSize);
+
+    ring = std::make_shared<pal_shmem_ring>();
+    ring->size = (size_t)(config.slotSize + config.metadataSize) * config.slotCount;
+    ring->fd = ashmem_create_region("pal_shmem_ring", ring->size);
+    if (ring->fd < 0) {
+        ALOGE("%s: ashmem of %zu bytes failed %d", __func__, ring->size, ring->fd);
+        return;
+    }
+    base = mmap(NULL, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("%s: mmap of %zu bytes failed %d", __func__, ring->size, errno);
+        return;
+    }
+    ring->base = (uint8_t *)base;
+    ring->slot_count = config.slotCount;
+    ring->slot_size = config.slotSize;
+    ring->metadata_size = config.metadataSize;
+
+    ringHidlHandle = native_handle_create(1, 0);
+    if (!ringHidlHandle) {
+        ALOGE("%s:%d Failed to create ringHidlHandle", __func__, __LINE__);
+        return;
+    }
+    ringHidlHandle->data[0] = ring->fd;
+    ret = pal_client->ipc_pal_stream_map_shmem_ring((PalStreamHandle)stream_handle,
+                          hidl_memory("ashmem", hidl_handle(ringHidlHandle), ring->size),
+                          config);
+    native_handle_delete(ringHidlHandle);
+    if (ret) {
+        ALOGE("%s: server did not map the ring %d, buffers go by value", __func__, ret);
+        return;
+    }
+
+    ALOGD("%s: handle %pK slots %d size %d metadata %d", __func__, stream_handle,
+          config.slotCount, config.slotSize, config.metadataSize);
+    std::lock_guard<std::mutex> lock(pal_client_streams_lock);
+    auto it = pal_client_streams.find(stream_handle);
+    if (it != pal_client_streams.end())
+        it->second.ring = ring;
+}
+
+static ssize_t pal_shmem_ring_write(const std::shared_ptr<pal_shmem_ring>& ring,
+                                    pal_stream_handle_t *stream_handle,
+                                    struct pal_buffer *buf)
+{
+    android::sp<IPAL_V1_1> pal_client = get_pal_shmem_server();
+    PalShmemBuffer buff = {};
+    uint32_t slot = ring->next_slot++ % ring->slot_count;
+
+    if (pal_client == nullptr)
+        return -EINVAL;
+
+    if (buf->size)
+        memcpy(ring->payload(slot), buf->buffer, buf->size);
+    if ((buf->metadata_size > 0) && buf->metadata) {
+        memcpy(ring->metadata(slot), buf->metadata, buf->metadata_size);
+        buff.metadataSz = buf->metadata_size;
+    }
+    buff.slot = slot;
+    buff.size = buf->size;
+    buff.offset = buf->offset;
+    buff.flags = buf->flags;
+    if (buf->ts) {
+        buff.timeStamp.tvSec = buf->ts->tv_sec;
+        buff.timeStamp.tvNSec = buf->ts->tv_nsec;
+    }
+    return pal_client->ipc_pal_stream_write_shmem((PalStreamHandle)stream_handle, buff);
+}
+
+static ssize_t pal_shmem_ring_read(const std::shared_ptr<pal_shmem_ring>& ring,
+                                   pal_stream_handle_t *stream_handle,
+                                   struct pal_buffer *buf)
+{
+    android::sp<IPAL_V1_1> pal_client = get_pal_shmem_server();
+    PalShmemBuffer buff = {};
+    uint32_t slot = ring->next_slot++ % ring->slot_count;
+    int ret = -EINVAL;
+
+    if (pal_client == nullptr)
+        return ret;
+
+    buff.slot = slot;
+    buff.size = buf->size;
+    if ((buf->metadata_size > 0) && buf->metadata)
+        buff.metadataSz = buf->metadata_size;
+
+    pal_client->ipc_pal_stream_read_shmem((PalStreamHandle)stream_handle, buff,
+           [&](int32_t ret_, const PalShmemBuffer& ret_buff)
+              {
+                  if (ret_ > 0) {
+                      if (ret_buff.slot != slot || ret_buff.size > buf->size) {
+                          ALOGE("ret slot %d sz %d does not match request slot %d sz %d",
+                                 ret_buff.slot, ret_buff.size, slot, buf->size);
+                          ret_ = -ENOMEM;
+                      } else {
+                          memcpy(buf->buffer, ring->payload(slot), ret_buff.size);
+                          if (buff.metadataSz)
+                              memcpy(buf->metadata, ring->metadata(slot),
+                                     std::min(ret_buff.metadataSz, buff.metadataSz));
+                          if (buf->ts) {
+                              buf->ts->tv_sec = ret_buff.timeStamp.tvSec;
+                              buf->ts->tv_nsec = ret_buff.timeStamp.tvNSec;
+                          }
+                          buf->flags = ret_buff.flags;
+                      }
+                  }
+                  ret = ret_;
+              });
+    return ret;
+}
+
 int32_t pal_init(void)
 {
    if (pal_client == NULL)
@@ -285,6 +501,10 @@ int32_t pal_stream_open(struct pal_stream_attributes *attr,
                                                *stream_handle = (uint64_t *)streamHandleRet;
                                           }
                                          );
+        if (!ret) {
+            std::lock_guard<std::mutex> lock(pal_client_streams_lock);
+            pal_client_streams[*stream_handle] = {(uint32_t)attr->flags, nullptr};
+        }
     }
     return ret;
 }
@@ -299,6 +519,10 @@ int32_t pal_stream_close(pal_stream_handle_t *stream_handle)
         if (pal_client == nullptr)
             return -EINVAL;
 
+        {
+            std::lock_guard<std::mutex> lock(pal_client_streams_lock);
+            pal_client_streams.erase(stream_handle);
+        }
         return pal_client->ipc_pal_stream_close((PalStreamHandle)stream_handle);
     }
     return -EINVAL;
@@ -442,6 +666,8 @@ int32_t pal_stream_set_buffer_size(pal_stream_handle_t *stream_handle,
                                 }
                                 ret = ret_;
                            });
+        if (!ret)
+            pal_shmem_ring_setup(stream_handle, in_buff_cfg, out_buff_cfg);
     }
     return ret;
 }
@@ -459,8 +685,13 @@ ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *
         if (pal_client == nullptr)
             return ret;
 
+        std::shared_ptr<pal_shmem_ring> ring = pal_shmem_ring_get(stream_handle);
+        if (ring && buf->buffer && buf->size <= ring->slot_size &&
+                buf->metadata_size <= ring->metadata_size)
+            return pal_shmem_ring_write(ring, stream_handle, buf);
+
         hidl_vec<PalBuffer> buf_hidl;
-        buf_hidl.resize(sizeof(struct pal_buffer));
+        buf_hidl.resize(1);
         PalBuffer *palBuff = buf_hidl.data();
         native_handle_t *allocHidlHandle = nullptr;
         allocHidlHandle = native_handle_create(1, 1);
@@ -511,8 +742,13 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
         if (pal_client == nullptr)
             return ret;
 
+        std::shared_ptr<pal_shmem_ring> ring = pal_shmem_ring_get(stream_handle);
+        if (ring && buf->buffer && buf->size <= ring->slot_size &&
+                buf->metadata_size <= ring->metadata_size)
+            return pal_shmem_ring_read(ring, stream_handle, buf);
+
         hidl_vec<PalBuffer> buf_hidl;
-        buf_hidl.resize(sizeof(struct pal_buffer));
+        buf_hidl.resize(1);
         PalBuffer *palBuff = buf_hidl.data();
         native_handle_t *allocHidlHandle = nullptr;
         allocHidlHandle = native_handle_create(1, 1);
@@ -33,9 +33,13 @@
 
 #include <vendor/qti/hardware/pal/1.0/IPALCallback.h>
 #include <vendor/qti/hardware/pal/1.0/IPAL.h>
+#include <vendor/qti/hardware/pal/1.1/IPAL.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <utils/RefBase.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <memory>
 #include <mutex>
 #include "PalApi.h"
 #include<log/log.h>
@@ -56,10 +60,57 @@ using ::android::hardware::hidl_vec;
 using ::android::hardware::Return;
 using ::android::hardware::Void;
 using IPALCallback = ::vendor::qti::hardware::pal::V1_0::IPALCallback;
+using PalShmemRingConfig = ::vendor::qti::hardware::pal::V1_1::PalShmemRingConfig;
+using PalShmemBuffer = ::vendor::qti::hardware::pal::V1_1::PalShmemBuffer;
 using ::android::sp;
 
 class PalClientDeathRecipient;
 
+/*
+ * Buffer ring allocated by the client and mapped with
+ * ipc_pal_stream_map_shmem_ring. Each slot holds slotSize payload bytes
+ * followed by metadataSize metadata bytes.
+ */
+struct ShmemRing {
+    int fd;
+    uint8_t *base;
+    size_t size;
+    uint32_t slotCount;
+    uint32_t slotSize;
+    uint32_t metadataSize;
+
+    ShmemRing()
+    {
+        fd = -1;
+        base = nullptr;
+        size = 0;
+        slotCount = 0;
+        slotSize = 0;
+        metadataSize = 0;
+    }
+    ~ShmemRing()
+    {
+        if (base)
+            munmap(base, size);
+        if (fd >= 0)
+            close(fd);
+    }
+    bool isValid(const PalShmemBuffer& buff)
+    {
+        return buff.slot < slotCount && buff.offset <= slotSize &&
+               buff.size <= slotSize - buff.offset &&
+               buff.metadataSz <= metadataSize;
+    }
+    uint8_t *payload(uint32_t slot)
+    {
+        return base + (size_t)slot * (slotSize + metadataSize);
+    }
+    uint8_t *metadata(uint32_t slot)
+    {
+        return payload(slot) + slotSize;
+    }
+};
+
 
 class SrvrClbk : public ::android::RefBase {
     public :
@@ -69,6 +120,7 @@ class SrvrClbk : public ::android::RefBase {
     int pid_;
     bool client_died;
     std::vector<std::pair<int, int>> sharedMemFdList;
+    std::shared_ptr<ShmemRing> shmemRing;
 
     SrvrClbk()
     {
@@ -105,7 +157,8 @@ struct client_info {
     std::mutex mActiveSessionsLock;
 };
 
-struct PAL : public IPAL /*, public android::hardware::hidl_death_recipient*/{
+struct PAL : public ::vendor::qti::hardware::pal::V1_1::IPAL
+            /*, public android::hardware::hidl_death_recipient*/{
     public:
     PAL()
     {
@@ -192,12 +245,22 @@ struct PAL : public IPAL /*, public android::hardware::hidl_death_recipient*/{
     Return<void>ipc_pal_stream_get_tags_with_module_info(const uint64_t streamHandle,
                                      uint32_t size,
                                      ipc_pal_stream_get_tags_with_module_info_cb _hidl_cb) override;
+    Return<int32_t> ipc_pal_stream_map_shmem_ring(const uint64_t streamHandle,
+                                    const hidl_memory& ring,
+                                    const PalShmemRingConfig& config) override;
+    Return<int32_t> ipc_pal_stream_write_shmem(const uint64_t streamHandle,
+                                    const PalShmemBuffer& buffer) override;
+    Return<void> ipc_pal_stream_read_shmem(const uint64_t streamHandle,
+                                    const PalShmemBuffer& buffer,
+                                    ipc_pal_stream_read_shmem_cb _hidl_cb) override;
     sp<PalClientDeathRecipient> mDeathRecipient;
     std::vector<std::shared_ptr<client_info>> mPalClients;
 private:
     static PAL* sInstance;
     int find_dup_fd_from_input_fd(const uint64_t streamHandle, int input_fd, int *dup_fd);
     void add_input_and_dup_fd(const uint64_t streamHandle, int input_fd, int dup_fd);
+    bool set_shmem_ring(const uint64_t streamHandle, std::shared_ptr<ShmemRing> ring);
+    std::shared_ptr<ShmemRing> get_shmem_ring(const uint64_t streamHandle);
 };
 
 class PalClientDeathRecipient : public android::hardware::hidl_death_recipient
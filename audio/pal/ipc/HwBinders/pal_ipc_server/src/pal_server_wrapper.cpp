@@ -34,6 +34,8 @@
 #define LOG_TAG "pal_server_wrapper"
 #include "inc/pal_server_wrapper.h"
 #include <hwbinder/IPCThreadState.h>
+#include <cutils/ashmem.h>
+#include <limits.h>
 
 #define MAX_CACHE_SIZE 64
 
@@ -75,6 +77,7 @@ void PalClientDeathRecipient::serviceDied(uint64_t cookie,
                        close(sItr->callback_binder->sharedMemFdList[i].second);
                    }
                    sItr->callback_binder->sharedMemFdList.clear();
+                   sItr->callback_binder->shmemRing.reset();
                    sItr->callback_binder.clear();
                 }
                 client->mActiveSessions.clear();
@@ -106,6 +109,34 @@ void PAL::add_input_and_dup_fd(const uint64_t streamHandle, int input_fd, int du
     }
 }
 
+bool PAL::set_shmem_ring(const uint64_t streamHandle, std::shared_ptr<ShmemRing> ring)
+{
+    for (auto& s: mPalClients) {
+        std::lock_guard<std::mutex> lock(s->mActiveSessionsLock);
+        for (int i = 0; i < s->mActiveSessions.size(); i++) {
+            session_info session = s->mActiveSessions[i];
+            if (session.session_handle == streamHandle && session.callback_binder) {
+                session.callback_binder->shmemRing = ring;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+std::shared_ptr<ShmemRing> PAL::get_shmem_ring(const uint64_t streamHandle)
+{
+    for (auto& s: mPalClients) {
+        std::lock_guard<std::mutex> lock(s->mActiveSessionsLock);
+        for (int i = 0; i < s->mActiveSessions.size(); i++) {
+            session_info session = s->mActiveSessions[i];
+            if (session.session_handle == streamHandle && session.callback_binder)
+                return session.callback_binder->shmemRing;
+        }
+    }
+    return nullptr;
+}
+
 
 static void printFdList(const std::vector<std::pair<int, int>> &list, const char * caller) {
     if (list.size() > 0 ) {
@@ -193,7 +224,7 @@ static int32_t pal_callback(pal_stream_handle_t *stream_handle,
             }
         }
 
-        rwDonePayloadHidl.resize(sizeof(struct pal_event_read_write_done_payload));
+        rwDonePayloadHidl.resize(1);
         rwDonePayload =(PalEventReadWriteDonePayload *)rwDonePayloadHidl.data();
         rwDonePayload->tag = rw_done_payload->tag;
         rwDonePayload->status = rw_done_payload->status;
@@ -485,6 +516,7 @@ Return<int32_t> PAL::ipc_pal_stream_close(const uint64_t streamHandle)
                         }
                         ALOGV("Closing the session %pK", streamHandle);
                         sItr->callback_binder->sharedMemFdList.clear();
+                        sItr->callback_binder->shmemRing.reset();
                         sItr->callback_binder.clear();
                         break;
                     }
@@ -671,7 +703,7 @@ Return<void> PAL::ipc_pal_stream_read(const uint64_t streamHandle,
 
     ret = pal_stream_read((pal_stream_handle_t *)streamHandle, &buf);
     if (ret > 0) {
-        outBuff_hidl.resize(sizeof(struct pal_buffer));
+        outBuff_hidl.resize(1);
         outBuff_hidl.data()->size = (uint32_t)buf.size;
         outBuff_hidl.data()->offset = (uint32_t)buf.offset;
         outBuff_hidl.data()->buffer.resize(buf.size);
@@ -696,6 +728,131 @@ exit:
     return Void();
 }
 
+Return<int32_t> PAL::ipc_pal_stream_map_shmem_ring(const uint64_t streamHandle,
+                                                   const hidl_memory& ring_hidl,
+                                                   const PalShmemRingConfig& config)
+{
+    const native_handle *handle = ring_hidl.handle();
+    std::shared_ptr<ShmemRing> ring;
+    size_t slotSize;
+    int regionSize;
+    void *base;
+
+    if (!handle || handle->numFds < 1 || !config.slotCount || !config.slotSize) {
+        ALOGE("%s: invalid ring, slots %d size %d", __func__, config.slotCount,
+              config.slotSize);
+        return -EINVAL;
+    }
+    slotSize = (size_t)config.slotSize + config.metadataSize;
+    if (config.slotCount > SIZE_MAX / slotSize ||
+            slotSize * config.slotCount != ring_hidl.size()) {
+        ALOGE("%s: ring size %lld does not hold %d slots of %zu bytes", __func__,
+              (long long)ring_hidl.size(), config.slotCount, slotSize);
+        return -EINVAL;
+    }
+
+    ring = std::make_shared<ShmemRing>();
+    ring->fd = dup(handle->data[0]);
+    if (ring->fd < 0) {
+        ALOGE("%s: dup failed %d", __func__, errno);
+        return -errno;
+    }
+    /* the declared size is the client's word, map no more than the region holds */
+    regionSize = ashmem_get_size_region(ring->fd);
+    if (regionSize < 0 || (uint64_t)regionSize < ring_hidl.size()) {
+        ALOGE("%s: region of %d bytes, %lld declared", __func__, regionSize,
+              (long long)ring_hidl.size());
+        return -EINVAL;
+    }
+    base = mmap(NULL, ring_hidl.size(), PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (base == MAP_FAILED) {
+        ALOGE("%s: mmap of %lld bytes failed %d", __func__, (long long)ring_hidl.size(),
+              errno);
+        return -ENOMEM;
+    }
+    ring->base = (uint8_t *)base;
+    ring->size = ring_hidl.size();
+    ring->slotCount = config.slotCount;
+    ring->slotSize = config.slotSize;
+    ring->metadataSize = config.metadataSize;
+
+    if (!set_shmem_ring(streamHandle, ring)) {
+        ALOGE("%s: no session for handle %pK", __func__, streamHandle);
+        return -EINVAL;
+    }
+    ALOGD("%s: handle %pK slots %d size %d metadata %d", __func__, streamHandle,
+          config.slotCount, config.slotSize, config.metadataSize);
+    return 0;
+}
+
+Return<int32_t> PAL::ipc_pal_stream_write_shmem(const uint64_t streamHandle,
+                                                const PalShmemBuffer& buff)
+{
+    std::shared_ptr<ShmemRing> ring = get_shmem_ring(streamHandle);
+    struct pal_buffer buf = {0};
+    struct timespec ts;
+
+    if (!ring || !ring->isValid(buff)) {
+        ALOGE("%s: invalid slot %d size %d for handle %pK", __func__, buff.slot,
+              buff.size, streamHandle);
+        return -EINVAL;
+    }
+
+    /* the client filled the slot, PAL reads straight out of the ring */
+    ts.tv_sec = buff.timeStamp.tvSec;
+    ts.tv_nsec = buff.timeStamp.tvNSec;
+    buf.buffer = ring->payload(buff.slot);
+    buf.size = (size_t)buff.size;
+    buf.offset = (size_t)buff.offset;
+    buf.ts = &ts;
+    buf.flags = buff.flags;
+    if (buff.metadataSz) {
+        buf.metadata_size = buff.metadataSz;
+        buf.metadata = ring->metadata(buff.slot);
+    }
+    ALOGV("%s: slot %d sz %d", __func__, buff.slot, buff.size);
+    return pal_stream_write((pal_stream_handle_t *)streamHandle, &buf);
+}
+
+Return<void> PAL::ipc_pal_stream_read_shmem(const uint64_t streamHandle,
+                                            const PalShmemBuffer& inBuff,
+                                            ipc_pal_stream_read_shmem_cb _hidl_cb)
+{
+    std::shared_ptr<ShmemRing> ring = get_shmem_ring(streamHandle);
+    struct pal_buffer buf = {0};
+    struct timespec ts = {0};
+    PalShmemBuffer outBuff = {};
+    int32_t ret;
+
+    if (!ring || !ring->isValid(inBuff)) {
+        ALOGE("%s: invalid slot %d size %d for handle %pK", __func__, inBuff.slot,
+              inBuff.size, streamHandle);
+        _hidl_cb(-EINVAL, outBuff);
+        return Void();
+    }
+
+    buf.buffer = ring->payload(inBuff.slot);
+    buf.size = (size_t)inBuff.size;
+    buf.ts = &ts;
+    if (inBuff.metadataSz) {
+        buf.metadata_size = inBuff.metadataSz;
+        buf.metadata = ring->metadata(inBuff.slot);
+    }
+
+    ret = pal_stream_read((pal_stream_handle_t *)streamHandle, &buf);
+    if (ret > 0) {
+        outBuff.slot = inBuff.slot;
+        outBuff.size = (uint32_t)buf.size;
+        outBuff.offset = (uint32_t)buf.offset;
+        outBuff.timeStamp.tvSec = ts.tv_sec;
+        outBuff.timeStamp.tvNSec = ts.tv_nsec;
+        outBuff.flags = buf.flags;
+        outBuff.metadataSz = buf.metadata_size;
+    }
+    _hidl_cb(ret, outBuff);
+    return Void();
+}
+
 Return<int32_t> PAL::ipc_pal_stream_set_param(const uint64_t streamHandle, uint32_t paramId,
                                         const hidl_vec<PalParamPayload>& paramPayload)
 {
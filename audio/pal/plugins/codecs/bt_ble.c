@@ -325,6 +325,12 @@ void bt_ble_close(bt_codec_t *codec)
     free(codec);
 }
 
+__attribute__ ((visibility ("default")))
+uint32_t plugin_abi_version(void)
+{
+    return BT_CODEC_PLUGIN_ABI_VERSION;
+}
+
 __attribute__ ((visibility ("default")))
 int plugin_open(bt_codec_t **codec, uint32_t codecFmt, codec_type direction)
 {
@@ -118,4 +118,11 @@ struct bt_codec_library_s {
 typedef int (*config_fn_t) (bt_codec_t *codec, void *src, void **dst);
 typedef int (*open_fn_t) (bt_codec_t **codec, uint32_t codecFmt, codec_type direction);
 
+/*
+ * Plugins export plugin_abi_version() returning the version they were
+ * built against. Bump it when bt_codec_t or open_fn_t change.
+ */
+#define BT_CODEC_PLUGIN_ABI_VERSION 1
+typedef uint32_t (*abi_version_fn_t) (void);
+
 #endif /* _BT_PLUGIN_INTF_H_ */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef MIXER_EVENT_ROUTER_H
+#define MIXER_EVENT_ROUTER_H
+
+#include <stdint.h>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "OffloadEventLoop.h"
+
+/* subscribes to every event id of a control */
+#define MIXER_EVENT_ID_ANY UINT32_MAX
+/* events waiting for one subscriber, newer ones are dropped beyond this */
+#define MIXER_EVENT_QUEUE_SIZE 8
+
+typedef void (*mixer_event_callback)(uint64_t hdl, uint32_t event_id, void *event_data,
+                                     uint32_t event_size);
+
+struct MixerEvent {
+    uint32_t eventId;
+    void *buf;          /* owned, released with free() after delivery */
+    void *payload;      /* points into buf */
+    uint32_t size;
+};
+
+struct MixerEventSubscriber {
+    MixerEventSubscriber(mixer_event_callback cb, uint64_t cookie,
+                         offload_cmd_handler handler);
+    mixer_event_callback cb;
+    uint64_t cookie;
+    std::mutex lock;
+    MixerEvent events[MIXER_EVENT_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t count;
+    bool closed;
+    OffloadStrand strand;
+};
+
+/*
+ * Routes the events read by the mixer event thread to the subscribers
+ * of a (control id, event id) pair. The control id is the PCM or
+ * compress device id in the "<PCM|COMPRESS><id> event" control name.
+ *
+ * Lookups take only the router lock, never the ResourceManager one.
+ * Each subscriber has a bounded queue drained on its own strand of the
+ * OffloadEventLoop pool, so the callbacks of one subscriber run in
+ * order while a slow subscriber does not hold back the others or the
+ * mixer event thread. Once unsubscribe returns the callback will not
+ * be called again, but one already running is not waited for: callers
+ * unsubscribe from close paths holding locks their callback takes, as
+ * SoundTriggerEngineGsl does with its mutex_. The subscriber stays on
+ * retired_ until its strand goes idle.
+ */
+class MixerEventRouter
+{
+public:
+    MixerEventRouter() {}
+    ~MixerEventRouter();
+    /* replaces the subscriber already registered for the pair */
+    int subscribe(int ctlId, uint32_t eventId, mixer_event_callback cb, uint64_t cookie);
+    int unsubscribe(int ctlId, uint32_t eventId, mixer_event_callback cb);
+    /*
+     * Queue an event to its subscriber, which then owns buf. Returns
+     * -ENOENT without a subscriber and -ENOSPC when its queue is full,
+     * buf stays with the caller in both cases.
+     */
+    int dispatch(int ctlId, uint32_t eventId, void *buf, void *payload, uint32_t size);
+private:
+    static uint64_t key(int ctlId, uint32_t eventId)
+    {
+        return ((uint64_t)(uint32_t)ctlId << 32) | eventId;
+    }
+    static void deliver(void *ctx, int cmd);
+    void retire(std::shared_ptr<MixerEventSubscriber> sub);
+    void reapRetired();
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<MixerEventSubscriber>> subscribers_;
+    /* unsubscribed, released on a later call once their strand is idle */
+    std::vector<std::shared_ptr<MixerEventSubscriber>> retired_;
+};
+
+#endif //MIXER_EVENT_ROUTER_H
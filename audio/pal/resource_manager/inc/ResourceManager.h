@@ -69,6 +69,7 @@
 #include <iostream>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <string>
 #include "audio_route/audio_route.h"
 #include <tinyalsa/asoundlib.h>
@@ -87,6 +88,8 @@
 #include "ACDPlatformInfo.h"
 #include "ContextManager.h"
 #include "SignalHandler.h"
+#include "StreamHandleTable.h"
+#include "MixerEventRouter.h"
 #include <fstream>
 
 typedef enum {
@@ -110,6 +113,15 @@ typedef enum {
 #define AUDIO_PARAMETER_KEY_UPD_DEDICATED_BE "upd_dedicated_be"
 #define AUDIO_PARAMETER_KEY_DUAL_MONO "dual_mono"
 #define AUDIO_PARAMETER_KEY_SIGNAL_HANDLER "signal_handler"
+#define AUDIO_PARAMETER_KEY_PAL_TRACE "pal_trace"
+#define AUDIO_PARAMETER_KEY_PAL_TRACE_DUMP "pal_trace_dump"
+#define AUDIO_PARAMETER_KEY_PAL_LATENCY "pal_latency"
+#define AUDIO_PARAMETER_KEY_PAL_LATENCY_DUMP "pal_latency_dump"
+#if defined(FEATURE_IPQ_OPENWRT) || defined(LINUX_ENABLED)
+#define PAL_LATENCY_DUMP_PATH "/var/cache/audio/pal_latency.txt"
+#else
+#define PAL_LATENCY_DUMP_PATH "/data/vendor/audio/pal_latency.txt"
+#endif
 #define MAX_PCM_NAME_SIZE 50
 #define MAX_STREAM_INSTANCES (sizeof(uint64_t) << 3)
 #define MIN_USECASE_PRIORITY 0xFFFFFFFF
@@ -239,6 +251,29 @@ typedef enum {
     SIDETONE_SW,
 } sidetone_mode_t;
 
+/* Active stream registry buckets, in the order getActiveStream_l merges them */
+typedef enum {
+    ACTIVE_STREAM_LL = 0,
+    ACTIVE_STREAM_ULL,
+    ACTIVE_STREAM_ULLA,
+    ACTIVE_STREAM_DB,
+    ACTIVE_STREAM_RAW,
+    ACTIVE_STREAM_COMP,
+    ACTIVE_STREAM_ST,
+    ACTIVE_STREAM_ACD,
+    ACTIVE_STREAM_PO,
+    ACTIVE_STREAM_PROXY,
+    ACTIVE_STREAM_INCALL_RECORD,
+    ACTIVE_STREAM_NON_TUNNEL,
+    ACTIVE_STREAM_INCALL_MUSIC,
+    ACTIVE_STREAM_HAPTICS,
+    ACTIVE_STREAM_ULTRASOUND,
+    ACTIVE_STREAM_SENSOR_PCM_DATA,
+    ACTIVE_STREAM_VOICE_REC,
+    ACTIVE_STREAM_CONTEXT_PROXY,
+    ACTIVE_STREAM_BUCKET_MAX,
+} active_stream_bucket_t;
+
 typedef enum {
     AUDIO_BIT_WIDTH_8 = 8,
     AUDIO_BIT_WIDTH_DEFAULT_16 = 16,
@@ -458,6 +493,9 @@ private:
     void onChargingStateChange();
     void onVUIStreamRegistered();
     void onVUIStreamDeregistered();
+    static int getStreamBucket(pal_stream_type_t type);
+    void addToStreamRegistry(Stream *s, pal_stream_type_t type);
+    void removeFromStreamRegistry(Stream *s, pal_stream_type_t type);
 protected:
     std::list <Stream*> mActiveStreams;
     std::list <StreamPCM*> active_streams_ll;
@@ -478,10 +516,14 @@ protected:
     std::list <StreamUltraSound*> active_streams_ultrasound;
     std::list <StreamSensorPCMData*> active_streams_sensor_pcm_data;
     std::list <StreamContextProxy*> active_streams_context_proxy;
+    /* flat view of the typed lists above, updated on register/deregister */
+    std::vector <Stream*> mStreamRegistry[ACTIVE_STREAM_BUCKET_MAX];
+    size_t mStreamRegistryCount = 0;
     std::vector <std::pair<std::shared_ptr<Device>, Stream*>> active_devices;
     std::vector <std::shared_ptr<Device>> plugin_devices_;
     std::vector <pal_device_id_t> avail_devices_;
     std::map<Stream*, std::pair<uint32_t, bool>> mActiveStreamUserCounter;
+    StreamHandleTable mStreamHandles;
     bool bOverwriteFlag;
     bool screen_state_ = true;
     bool charging_state_;
@@ -553,7 +595,7 @@ protected:
     std::vector<std::pair<std::string, InstanceListNode_t>> STInstancesLists;
     uint64_t stream_instances[PAL_STREAM_MAX];
     uint64_t in_stream_instances[PAL_STREAM_MAX];
-    static int mixerEventRegisterCount;
+    static std::atomic<int> mixerEventRegisterCount;
     static int concurrencyEnableCount;
     static int concurrencyDisableCount;
     static int ACDConcurrencyEnableCount;
@@ -565,7 +607,7 @@ protected:
     static int wake_unlock_fd;
     static uint32_t wake_lock_cnt;
     static bool lpi_logging_;
-    std::map<int, std::pair<session_callback, uint64_t>> mixerEventCallbackMap;
+    MixerEventRouter mixerEventRouter;
     static std::thread mixerEventTread;
     std::shared_ptr<CaptureProfile> SoundTriggerCaptureProfile;
     ResourceManager();
@@ -665,6 +707,8 @@ public:
     int decreaseStreamUserCounter(Stream* s);
     int getStreamUserCounter(Stream *s);
     int printStreamUserCounter(Stream *s);
+    int pinActiveStream(pal_stream_handle_t *handle, uint32_t *slot);
+    void unpinActiveStream(uint32_t slot);
     int registerDevice(std::shared_ptr<Device> d, Stream *s);
     int deregisterDevice(std::shared_ptr<Device> d, Stream *s);
     int registerDevice_l(std::shared_ptr<Device> d, Stream *s);
@@ -850,6 +894,8 @@ public:
     static int setUpdDedicatedBeEnableParam(struct str_parms *parms,char *value, int len);
     static int setDualMonoEnableParam(struct str_parms *parms,char *value, int len);
     static int setSignalHandlerEnableParam(struct str_parms *parms,char *value, int len);
+    static int setPalTraceParams(struct str_parms *parms, char *value, int len);
+    static int setLatencyTraceParams(struct str_parms *parms, char *value, int len);
     static bool isLpiLoggingEnabled();
     static void processConfigParams(const XML_Char **attr);
     static bool isValidDevId(int deviceId);
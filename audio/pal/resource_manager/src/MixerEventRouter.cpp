@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: MixerEventRouter"
+
+#include "MixerEventRouter.h"
+#include "PalCommon.h"
+#include <errno.h>
+#include <stdlib.h>
+
+MixerEventSubscriber::MixerEventSubscriber(mixer_event_callback c, uint64_t ck,
+                                           offload_cmd_handler handler)
+    : cb(c), cookie(ck), head(0), count(0), closed(false), strand(handler, this)
+{
+}
+
+MixerEventRouter::~MixerEventRouter()
+{
+    std::vector<std::shared_ptr<MixerEventSubscriber>> subs;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto &it : subscribers_)
+            subs.push_back(it.second);
+        subscribers_.clear();
+    }
+    for (auto &sub : subs)
+        retire(sub);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subs.swap(retired_);
+    }
+    /* nothing can hold a lock a callback waits for at teardown */
+    for (auto &sub : subs)
+        OffloadEventLoop::getInstance()->flush(&sub->strand);
+}
+
+/* runs on a worker of the OffloadEventLoop, one event per posted cmd */
+void MixerEventRouter::deliver(void *ctx, int cmd __unused)
+{
+    MixerEventSubscriber *sub = (MixerEventSubscriber *)ctx;
+    MixerEvent ev;
+
+    {
+        std::lock_guard<std::mutex> lock(sub->lock);
+        if (!sub->count)
+            return;
+        ev = sub->events[sub->head];
+        sub->head = (sub->head + 1) % MIXER_EVENT_QUEUE_SIZE;
+        sub->count--;
+        if (sub->closed) {
+            free(ev.buf);
+            return;
+        }
+    }
+
+    sub->cb(sub->cookie, ev.eventId, ev.payload, ev.size);
+    free(ev.buf);
+}
+
+/*
+ * Stop deliveries without waiting for the running one, the caller may
+ * hold a lock the callback is blocked on. The subscriber is parked on
+ * retired_ until its strand goes idle.
+ */
+void MixerEventRouter::retire(std::shared_ptr<MixerEventSubscriber> sub)
+{
+    {
+        std::lock_guard<std::mutex> lock(sub->lock);
+        sub->closed = true;
+        for (; sub->count; sub->count--) {
+            free(sub->events[sub->head].buf);
+            sub->head = (sub->head + 1) % MIXER_EVENT_QUEUE_SIZE;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    retired_.push_back(sub);
+}
+
+/* release the retired subscribers whose strand went idle, keep the rest */
+void MixerEventRouter::reapRetired()
+{
+    /* released after the router lock */
+    std::vector<std::shared_ptr<MixerEventSubscriber>> done;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = retired_.begin(); it != retired_.end();) {
+        if (!OffloadEventLoop::getInstance()->isIdle(&(*it)->strand)) {
+            it++;
+            continue;
+        }
+        done.push_back(*it);
+        it = retired_.erase(it);
+    }
+}
+
+int MixerEventRouter::subscribe(int ctlId, uint32_t eventId, mixer_event_callback cb,
+                                uint64_t cookie)
+{
+    std::shared_ptr<MixerEventSubscriber> sub;
+    std::shared_ptr<MixerEventSubscriber> old;
+
+    if (!cb) {
+        PAL_ERR(LOG_TAG, "Invalid callback");
+        return -EINVAL;
+    }
+    try {
+        sub = std::make_shared<MixerEventSubscriber>(cb, cookie, deliver);
+    } catch (const std::bad_alloc &e) {
+        PAL_ERR(LOG_TAG, "failed to allocate subscriber");
+        return -ENOMEM;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = subscribers_.find(key(ctlId, eventId));
+        if (it != subscribers_.end()) {
+            PAL_DBG(LOG_TAG, "callback exists for id %d event %x, overwrite",
+                    ctlId, eventId);
+            old = it->second;
+            it->second = sub;
+        } else {
+            subscribers_.emplace(key(ctlId, eventId), sub);
+        }
+    }
+    if (old)
+        retire(old);
+    reapRetired();
+
+    return 0;
+}
+
+int MixerEventRouter::unsubscribe(int ctlId, uint32_t eventId, mixer_event_callback cb)
+{
+    std::shared_ptr<MixerEventSubscriber> sub;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = subscribers_.find(key(ctlId, eventId));
+        if (it == subscribers_.end()) {
+            PAL_ERR(LOG_TAG, "No callback found for id %d event %x", ctlId, eventId);
+            return -ENOENT;
+        }
+        if (it->second->cb != cb) {
+            PAL_ERR(LOG_TAG, "No matching callback found for id %d event %x",
+                    ctlId, eventId);
+            return -EINVAL;
+        }
+        sub = it->second;
+        subscribers_.erase(it);
+    }
+    retire(sub);
+    reapRetired();
+
+    return 0;
+}
+
+int MixerEventRouter::dispatch(int ctlId, uint32_t eventId, void *buf, void *payload,
+                               uint32_t size)
+{
+    std::shared_ptr<MixerEventSubscriber> sub;
+    MixerEvent *ev = nullptr;
+    int status = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = subscribers_.find(key(ctlId, eventId));
+        if (it == subscribers_.end())
+            it = subscribers_.find(key(ctlId, MIXER_EVENT_ID_ANY));
+        if (it == subscribers_.end())
+            return -ENOENT;
+        sub = it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(sub->lock);
+    if (sub->closed)
+        return -ENOENT;
+    if (sub->count == MIXER_EVENT_QUEUE_SIZE) {
+        PAL_ERR(LOG_TAG, "queue of id %d full, dropping event %x", ctlId, eventId);
+        return -ENOSPC;
+    }
+    ev = &sub->events[(sub->head + sub->count) % MIXER_EVENT_QUEUE_SIZE];
+    ev->eventId = eventId;
+    ev->buf = buf;
+    ev->payload = payload;
+    ev->size = size;
+    sub->count++;
+    /* the strand holds more cmds than the queue holds events */
+    status = OffloadEventLoop::getInstance()->post(&sub->strand, 0);
+    if (status)
+        sub->count--;
+
+    return status;
+}
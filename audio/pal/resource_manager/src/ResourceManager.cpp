@@ -77,6 +77,7 @@
 #include "gsl_intf.h"
 #include "Headphone.h"
 #include "PayloadBuilder.h"
+#include "SessionAlsaUtils.h"
 #include "Bluetooth.h"
 #include "SpeakerMic.h"
 #include "Speaker.h"
@@ -88,7 +89,9 @@
 #include "Handset.h"
 #include "SndCardMonitor.h"
 #include "UltrasoundDevice.h"
+#include "PalTrace.h"
 #include <agm/agm_api.h>
+#include <agm/agm_latency.h>
 #include <cutils/properties.h>
 #include <unistd.h>
 #include <dlfcn.h>
@@ -452,7 +455,7 @@ std::condition_variable ResourceManager::cv;
 std::thread ResourceManager::workerThread;
 std::thread ResourceManager::mixerEventTread;
 bool ResourceManager::mixerClosed = false;
-int ResourceManager::mixerEventRegisterCount = 0;
+std::atomic<int> ResourceManager::mixerEventRegisterCount(0);
 int ResourceManager::concurrencyEnableCount = 0;
 int ResourceManager::concurrencyDisableCount = 0;
 int ResourceManager::ACDConcurrencyEnableCount = 0;
@@ -719,6 +722,9 @@ ResourceManager::ResourceManager()
         throw std::runtime_error("error in resource xml parsing");
     }
 
+    /* keep BT codec switches free of dlopen */
+    BtCodecPluginRegistry::getInstance()->preload(btCodecMap);
+
     if (isHifiFilterEnabled)
         audio_route_apply_and_update_path(audio_route, "hifi-filter-coefficients");
 
@@ -1039,6 +1045,8 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
             mActiveStreamMutex.lock();
             rm->cardState = state;
             if (state != prevState) {
+                /* controls are re-registered by the card after SSR */
+                SessionAlsaUtils::invalidateMixerControlCache();
                 if (rm->globalCb) {
                     PAL_DBG(LOG_TAG, "Notifying client about sound card state %d global cb %pK",
                                       rm->cardState, rm->globalCb);
@@ -2631,6 +2639,8 @@ int ResourceManager::registerStream(Stream *s)
             break;
     }
     mActiveStreams.push_back(s);
+    if (!ret)
+        addToStreamRegistry(s, type);
 
 #if 0
     s->getStreamAttributes(&incomingStreamAttr);
@@ -2808,6 +2818,7 @@ int ResourceManager::deregisterStream(Stream *s)
     }
 
     deregisterstream(s, mActiveStreams);
+    removeFromStreamRegistry(s, type);
     mValidStreamMutex.unlock();
     mActiveStreamMutex.unlock();
 exit:
@@ -2815,6 +2826,83 @@ exit:
     return ret;
 }
 
+int ResourceManager::getStreamBucket(pal_stream_type_t type)
+{
+    switch (type) {
+        case PAL_STREAM_LOW_LATENCY:
+        case PAL_STREAM_VOIP_RX:
+        case PAL_STREAM_VOIP_TX:
+        case PAL_STREAM_VOICE_CALL:
+            return ACTIVE_STREAM_LL;
+        case PAL_STREAM_PCM_OFFLOAD:
+        case PAL_STREAM_LOOPBACK:
+            return ACTIVE_STREAM_PO;
+        case PAL_STREAM_DEEP_BUFFER:
+            return ACTIVE_STREAM_DB;
+        case PAL_STREAM_COMPRESSED:
+            return ACTIVE_STREAM_COMP;
+        case PAL_STREAM_GENERIC:
+            return ACTIVE_STREAM_ULLA;
+        case PAL_STREAM_VOICE_UI:
+            return ACTIVE_STREAM_ST;
+        case PAL_STREAM_ULTRA_LOW_LATENCY:
+            return ACTIVE_STREAM_ULL;
+        case PAL_STREAM_PROXY:
+            return ACTIVE_STREAM_PROXY;
+        case PAL_STREAM_VOICE_CALL_MUSIC:
+            return ACTIVE_STREAM_INCALL_MUSIC;
+        case PAL_STREAM_VOICE_CALL_RECORD:
+            return ACTIVE_STREAM_INCALL_RECORD;
+        case PAL_STREAM_NON_TUNNEL:
+            return ACTIVE_STREAM_NON_TUNNEL;
+        case PAL_STREAM_HAPTICS:
+            return ACTIVE_STREAM_HAPTICS;
+        case PAL_STREAM_ACD:
+            return ACTIVE_STREAM_ACD;
+        case PAL_STREAM_ULTRASOUND:
+            return ACTIVE_STREAM_ULTRASOUND;
+        case PAL_STREAM_RAW:
+            return ACTIVE_STREAM_RAW;
+        case PAL_STREAM_SENSOR_PCM_DATA:
+            return ACTIVE_STREAM_SENSOR_PCM_DATA;
+        case PAL_STREAM_CONTEXT_PROXY:
+            return ACTIVE_STREAM_CONTEXT_PROXY;
+        case PAL_STREAM_VOICE_RECOGNITION:
+            return ACTIVE_STREAM_VOICE_REC;
+        default:
+            return -EINVAL;
+    }
+}
+
+/* caller must hold mActiveStreamMutex and mValidStreamMutex */
+void ResourceManager::addToStreamRegistry(Stream *s, pal_stream_type_t type)
+{
+    int bucket = getStreamBucket(type);
+
+    if (bucket < 0)
+        return;
+
+    mStreamRegistry[bucket].push_back(s);
+    mStreamRegistryCount++;
+}
+
+/* caller must hold mActiveStreamMutex and mValidStreamMutex */
+void ResourceManager::removeFromStreamRegistry(Stream *s, pal_stream_type_t type)
+{
+    int bucket = getStreamBucket(type);
+
+    if (bucket < 0)
+        return;
+
+    std::vector<Stream*> &streams = mStreamRegistry[bucket];
+    auto iter = std::find(streams.begin(), streams.end(), s);
+    if (iter != streams.end()) {
+        /* keep registration order, getActiveStream_l callers rely on it */
+        streams.erase(iter);
+        mStreamRegistryCount--;
+    }
+}
+
 template <class T>
 bool isStreamActive(T s, std::list<T> &streams)
 {
@@ -2845,6 +2933,7 @@ int ResourceManager::initStreamUserCounter(Stream *s)
     lockValidStreamMutex();
     mActiveStreamUserCounter.insert(std::make_pair(s, std::make_pair(0, true)));
     s->initStreamSmph();
+    mStreamHandles.add(s);
     unlockValidStreamMutex();
     return 0;
 }
@@ -2852,6 +2941,9 @@ int ResourceManager::initStreamUserCounter(Stream *s)
 int ResourceManager::deactivateStreamUserCounter(Stream *s)
 {
     std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
+
+    /* fail new data path pins and wait for in-flight reads/writes */
+    mStreamHandles.deactivate(s);
     lockValidStreamMutex();
     printStreamUserCounter(s);
     it = mActiveStreamUserCounter.find(s);
@@ -2874,6 +2966,7 @@ int ResourceManager::eraseStreamUserCounter(Stream *s)
 {
     std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
     lockValidStreamMutex();
+    mStreamHandles.remove(s);
     it = mActiveStreamUserCounter.find(s);
     if (it != mActiveStreamUserCounter.end()) {
         mActiveStreamUserCounter.erase(it);
@@ -2946,6 +3039,21 @@ int ResourceManager::getStreamUserCounter(Stream *s)
     }
 }
 
+/*
+ * Data path variant of isActiveStream + increaseStreamUserCounter, takes no
+ * lock. Returns -ENOENT if the handle is not tracked by the handle table,
+ * callers then fall back to the locked path.
+ */
+int ResourceManager::pinActiveStream(pal_stream_handle_t *handle, uint32_t *slot)
+{
+    return mStreamHandles.pin(handle, slot);
+}
+
+void ResourceManager::unpinActiveStream(uint32_t slot)
+{
+    mStreamHandles.unpin(slot);
+}
+
 int ResourceManager::printStreamUserCounter(Stream *s)
 {
     std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
@@ -4082,60 +4190,46 @@ std::shared_ptr<CaptureProfile> ResourceManager::GetSoundTriggerCaptureProfile()
 
 /* NOTE: there should be only one callback for each pcm id
  * so when new different callback register with same pcm id
- * older one will be overwritten
+ * older one will be overwritten. The router has its own lock,
+ * mResourceManagerMutex is not taken here or on dispatch.
  */
 int ResourceManager::registerMixerEventCallback(const std::vector<int> &DevIds,
                                                 session_callback callback,
                                                 uint64_t cookie,
                                                 bool is_register) {
     int status = 0;
-    std::map<int, std::pair<session_callback, uint64_t>>::iterator it;
 
     if (!callback || DevIds.size() <= 0) {
         PAL_ERR(LOG_TAG, "Invalid callback or pcm ids");
         return -EINVAL;
     }
 
-    mResourceManagerMutex.lock();
     if (mixerEventRegisterCount == 0 && !is_register) {
         PAL_ERR(LOG_TAG, "Cannot deregister unregistered callback");
-        mResourceManagerMutex.unlock();
         return -EINVAL;
     }
 
     if (is_register) {
         for (int i = 0; i < DevIds.size(); i++) {
-            it = mixerEventCallbackMap.find(DevIds[i]);
-            if (it != mixerEventCallbackMap.end()) {
-                PAL_DBG(LOG_TAG, "callback exists for pcm id %d, overwrite",
+            status = mixerEventRouter.subscribe(DevIds[i], MIXER_EVENT_ID_ANY,
+                                                callback, cookie);
+            if (status) {
+                PAL_ERR(LOG_TAG, "Failed to register callback for pcm id %d",
                     DevIds[i]);
-                mixerEventCallbackMap.erase(it);
+                for (int j = 0; j < i; j++)
+                    mixerEventRouter.unsubscribe(DevIds[j], MIXER_EVENT_ID_ANY,
+                                                 callback);
+                return status;
             }
-            mixerEventCallbackMap.insert(std::make_pair(DevIds[i],
-                std::make_pair(callback, cookie)));
-
         }
         mixerEventRegisterCount++;
     } else {
-        for (int i = 0; i < DevIds.size(); i++) {
-            it = mixerEventCallbackMap.find(DevIds[i]);
-            if (it != mixerEventCallbackMap.end()) {
-                PAL_DBG(LOG_TAG, "callback found for pcm id %d, remove",
-                    DevIds[i]);
-                if (callback == it->second.first) {
-                    mixerEventCallbackMap.erase(it);
-                } else {
-                    PAL_ERR(LOG_TAG, "No matching callback found for pcm id %d",
-                        DevIds[i]);
-                }
-            } else {
-                PAL_ERR(LOG_TAG, "No callback found for pcm id %d", DevIds[i]);
-            }
-        }
+        /* a missing or different callback is logged by the router */
+        for (int i = 0; i < DevIds.size(); i++)
+            mixerEventRouter.unsubscribe(DevIds[i], MIXER_EVENT_ID_ANY, callback);
         mixerEventRegisterCount--;
     }
 
-    mResourceManagerMutex.unlock();
     return status;
 }
 
@@ -4186,8 +4280,6 @@ void ResourceManager::mixerEventWaitThreadLoop(
 int ResourceManager::handleMixerEvent(struct mixer *mixer, char *mixer_str) {
     int status = 0;
     int pcm_id = 0;
-    uint64_t cookie = 0;
-    session_callback session_cb = nullptr;
     std::string event_str(mixer_str);
     // TODO: hard code in common defs
     std::string pcm_prefix = "PCM";
@@ -4200,7 +4292,6 @@ int ResourceManager::handleMixerEvent(struct mixer *mixer, char *mixer_str) {
     char *buf = nullptr;
     unsigned int num_values;
     struct agm_event_cb_params *params = nullptr;
-    std::map<int, std::pair<session_callback, uint64_t>>::iterator it;
 
     PAL_DBG(LOG_TAG, "Enter");
     ctl = mixer_get_ctl_by_name(mixer, mixer_str);
@@ -4261,22 +4352,18 @@ int ResourceManager::handleMixerEvent(struct mixer *mixer, char *mixer_str) {
     length = suffix_idx - prefix_idx;
     pcm_id = std::stoi(event_str.substr(prefix_idx, length));
 
-    // acquire callback/cookie with pcm dev id
-    it = mixerEventCallbackMap.find(pcm_id);
-    if (it != mixerEventCallbackMap.end()) {
-        session_cb = it->second.first;
-        cookie = it->second.second;
-    }
-
-    if (!session_cb) {
-        status = -EINVAL;
+    // queue to the subscriber of pcm dev id, it owns buf from here on
+    status = mixerEventRouter.dispatch(pcm_id, params->event_id, buf,
+                                       (void *)params->event_payload,
+                                       params->event_payload_size);
+    if (status == -ENOENT) {
         PAL_ERR(LOG_TAG, "Invalid session callback");
+        status = -EINVAL;
+        goto exit;
+    } else if (status) {
         goto exit;
     }
-
-    // callback
-    session_cb(cookie, params->event_id, (void *)params->event_payload,
-                 params->event_payload_size);
+    buf = nullptr;
 
 exit:
     if (buf)
@@ -5010,51 +5097,23 @@ void ResourceManager::getHigherPriorityActiveStreams(const int inComingStreamPri
 #endif
 
 
-template <class T>
-void getActiveStreams(std::shared_ptr<Device> d, std::vector<Stream*> &activestreams,
-                      std::list<T> sourcestreams)
-{
-    for (typename std::list<T>::iterator iter = sourcestreams.begin();
-                 iter != sourcestreams.end(); iter++) {
-        std::vector <std::shared_ptr<Device>> devices;
-        (*iter)->getAssociatedDevices(devices);
-        if (d == NULL) {
-             if((*iter)->isAlive() && !devices.empty())
-                activestreams.push_back(*iter);
-        } else {
-            typename std::vector<std::shared_ptr<Device>>::iterator result =
-                     std::find(devices.begin(), devices.end(), d);
-            if ((result != devices.end()) && (*iter)->isAlive())
-                activestreams.push_back(*iter);
-        }
-    }
-}
-
 int ResourceManager::getActiveStream_l(std::vector<Stream*> &activestreams,
                                        std::shared_ptr<Device> d)
 {
     int ret = 0;
 
     activestreams.clear();
+    activestreams.reserve(mStreamRegistryCount);
 
-    // merge all types of active streams into activestreams
-    getActiveStreams(d, activestreams, active_streams_ll);
-    getActiveStreams(d, activestreams, active_streams_ull);
-    getActiveStreams(d, activestreams, active_streams_ulla);
-    getActiveStreams(d, activestreams, active_streams_db);
-    getActiveStreams(d, activestreams, active_streams_raw);
-    getActiveStreams(d, activestreams, active_streams_comp);
-    getActiveStreams(d, activestreams, active_streams_st);
-    getActiveStreams(d, activestreams, active_streams_acd);
-    getActiveStreams(d, activestreams, active_streams_po);
-    getActiveStreams(d, activestreams, active_streams_proxy);
-    getActiveStreams(d, activestreams, active_streams_incall_record);
-    getActiveStreams(d, activestreams, active_streams_non_tunnel);
-    getActiveStreams(d, activestreams, active_streams_incall_music);
-    getActiveStreams(d, activestreams, active_streams_haptics);
-    getActiveStreams(d, activestreams, active_streams_ultrasound);
-    getActiveStreams(d, activestreams, active_streams_sensor_pcm_data);
-    getActiveStreams(d, activestreams, active_streams_voice_rec);
+    // walk the registry in merge order, context proxy streams are not reported
+    for (int bucket = ACTIVE_STREAM_LL; bucket < ACTIVE_STREAM_CONTEXT_PROXY; bucket++) {
+        for (Stream *s : mStreamRegistry[bucket]) {
+            if (!s->isAlive())
+                continue;
+            if (d ? s->isAssociatedWith(d) : s->hasAssociatedDevices())
+                activestreams.push_back(s);
+        }
+    }
 
     if (activestreams.empty()) {
         ret = -ENOENT;
@@ -5080,23 +5139,6 @@ int ResourceManager::getActiveStream(std::vector<Stream*> &activestreams,
     return ret;
 }
 
-template <class T>
-void getOrphanStreams(std::vector<Stream*> &orphanstreams,
-                      std::vector<Stream*> &retrystreams,
-                      std::list<T> sourcestreams)
-{
-    for (typename std::list<T>::iterator iter = sourcestreams.begin();
-                 iter != sourcestreams.end(); iter++) {
-        std::vector <std::shared_ptr<Device>> devices;
-        (*iter)->getAssociatedDevices(devices);
-        if (devices.empty())
-            orphanstreams.push_back(*iter);
-
-        if ((*iter)->suspendedDevIds.size() > 0)
-            retrystreams.push_back(*iter);
-    }
-}
-
 int ResourceManager::getOrphanStream_l(std::vector<Stream*> &orphanstreams,
                                        std::vector<Stream*> &retrystreams)
 {
@@ -5105,20 +5147,22 @@ int ResourceManager::getOrphanStream_l(std::vector<Stream*> &orphanstreams,
     orphanstreams.clear();
     retrystreams.clear();
 
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_ll);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_ull);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_ulla);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_db);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_comp);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_st);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_acd);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_po);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_proxy);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_incall_record);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_non_tunnel);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_incall_music);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_haptics);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_ultrasound);
+    for (int bucket = ACTIVE_STREAM_LL; bucket < ACTIVE_STREAM_BUCKET_MAX; bucket++) {
+        // these stream types are not restored on device reconnect
+        if (bucket == ACTIVE_STREAM_RAW ||
+            bucket == ACTIVE_STREAM_SENSOR_PCM_DATA ||
+            bucket == ACTIVE_STREAM_VOICE_REC ||
+            bucket == ACTIVE_STREAM_CONTEXT_PROXY)
+            continue;
+
+        for (Stream *s : mStreamRegistry[bucket]) {
+            if (!s->hasAssociatedDevices())
+                orphanstreams.push_back(s);
+
+            if (s->suspendedDevIds.size() > 0)
+                retrystreams.push_back(s);
+        }
+    }
 
     if (orphanstreams.empty() && retrystreams.empty()) {
         ret = -ENOENT;
@@ -5707,6 +5751,7 @@ void ResourceManager::deinit()
     card_status_t state = CARD_STATUS_NONE;
 
     mixerClosed = true;
+    SessionAlsaUtils::invalidateMixerControlCache();
     mixer_close(audio_virt_mixer);
     mixer_close(audio_hw_mixer);
     if (audio_route) {
@@ -7202,6 +7247,8 @@ int ResourceManager::setConfigParams(struct str_parms *parms)
 
     /* Not checking return value as this is optional */
     setLpiLoggingParams(parms, value, len);
+    setPalTraceParams(parms, value, len);
+    setLatencyTraceParams(parms, value, len);
 
 exit:
     PAL_DBG(LOG_TAG,"Exit, status %d", ret);
@@ -7248,6 +7295,67 @@ int ResourceManager::setLoggingLevelParams(struct str_parms *parms,
     return ret;
 }
 
+int ResourceManager::setPalTraceParams(struct str_parms *parms,
+                                       char *value, int len)
+{
+    int ret = -EINVAL;
+
+    if (!value || !parms)
+        return ret;
+
+    ret = str_parms_get_str(parms, AUDIO_PARAMETER_KEY_PAL_TRACE,
+                                value, len);
+    if (ret >= 0) {
+        PalTrace::setEnabled(!strncmp(value, "true", sizeof("true")));
+        ret = 0;
+    }
+
+    if (str_parms_get_str(parms, AUDIO_PARAMETER_KEY_PAL_TRACE_DUMP,
+                              value, len) >= 0 &&
+        !strncmp(value, "true", sizeof("true")))
+        ret = PalTrace::dump(PAL_TRACE_DUMP_PATH);
+
+    return ret;
+}
+
+/*
+ * pal_latency=true|false switches the buffer latency histograms of
+ * every layer, pal_latency_dump=true writes them to PAL_LATENCY_DUMP_PATH.
+ */
+int ResourceManager::setLatencyTraceParams(struct str_parms *parms,
+                                           char *value, int len)
+{
+    int ret = -EINVAL;
+    int fd = -1;
+
+    if (!value || !parms)
+        return ret;
+
+    ret = str_parms_get_str(parms, AUDIO_PARAMETER_KEY_PAL_LATENCY,
+                                value, len);
+    if (ret >= 0) {
+        ret = agm_latency_set_enabled(!strncmp(value, "true", sizeof("true")));
+        PAL_INFO(LOG_TAG, "latency tracing set to %s, ret %d", value, ret);
+    }
+
+    if (str_parms_get_str(parms, AUDIO_PARAMETER_KEY_PAL_LATENCY_DUMP,
+                              value, len) >= 0 &&
+        !strncmp(value, "true", sizeof("true"))) {
+        fd = ::open(PAL_LATENCY_DUMP_PATH, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+        if (fd < 0) {
+            ret = -errno;
+            PAL_ERR(LOG_TAG, "cannot create %s, ret %d", PAL_LATENCY_DUMP_PATH, ret);
+            return ret;
+        }
+        ret = agm_latency_dump(fd);
+        if (ret)
+            PAL_ERR(LOG_TAG, "latency dump failed, ret %d", ret);
+        ::close(fd);
+    }
+
+    return ret;
+}
+
 int ResourceManager::setContextManagerEnableParam(struct str_parms *parms,
                                           char *value, int len)
 {
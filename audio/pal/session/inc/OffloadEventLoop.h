@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef OFFLOAD_EVENT_LOOP_H
+#define OFFLOAD_EVENT_LOOP_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <mutex>
+
+/* commands a strand can queue without waiting, power of two */
+#define OFFLOAD_STRAND_QUEUE_SIZE 16
+/* idle workers kept around for the next request */
+#define OFFLOAD_LOOP_MIN_IDLE_WORKERS 1
+#define OFFLOAD_LOOP_IDLE_TIMEOUT_MS 2000
+
+typedef void (*offload_cmd_handler)(void *ctx, int cmd);
+
+/*
+ * Per session command queue. Commands of one strand run in order and
+ * never concurrently, commands of different strands run in parallel.
+ * The queue is a fixed ring, posting does not allocate.
+ */
+struct OffloadStrand {
+    OffloadStrand(offload_cmd_handler h, void *c)
+        : handler(h), ctx(c), head(0), count(0), scheduled(false), next(nullptr) {}
+    offload_cmd_handler handler;
+    void *ctx;
+    int cmds[OFFLOAD_STRAND_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t count;
+    /* on the ready list or being run by a worker */
+    bool scheduled;
+    OffloadStrand *next;
+    std::condition_variable idle;
+};
+
+/*
+ * Runs the blocking compress calls (wait, drain, partial drain) of all
+ * compress offload sessions on one shared pool of workers instead of a
+ * thread per session. The compress devices are plugin backed and block
+ * on condition variables rather than on pollable fds, so a worker is
+ * busy for the length of one call. Workers are added while every worker
+ * is busy and retire after OFFLOAD_LOOP_IDLE_TIMEOUT_MS without work.
+ * MixerEventRouter delivers mixer events on strands of the same pool.
+ */
+class OffloadEventLoop
+{
+public:
+    static OffloadEventLoop *getInstance();
+    /* returns -ENOSPC if the strand queue is full */
+    int post(OffloadStrand *strand, int cmd);
+    /* wait for the queued and running commands of strand to finish */
+    void flush(OffloadStrand *strand);
+    /* no command queued or running, the strand may be released */
+    bool isIdle(OffloadStrand *strand);
+private:
+    OffloadEventLoop();
+    void workerLoop();
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    OffloadStrand *readyHead_;
+    OffloadStrand *readyTail_;
+    uint32_t numReady_;
+    uint32_t numWorkers_;
+    uint32_t numIdle_;
+};
+
+#endif //OFFLOAD_EVENT_LOOP_H
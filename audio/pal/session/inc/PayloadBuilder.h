@@ -43,6 +43,7 @@
 #include <algorithm>
 #include <expat.h>
 #include <map>
+#include <unordered_map>
 #include <regex>
 #include <sstream>
 #include "Stream.h"
@@ -149,6 +150,21 @@ struct allKVs {
     std::vector<kvInfo> keys_values;
 };
 
+/* KV tables compiled into kvIndex, see PayloadBuilder::buildKVIndex */
+typedef enum {
+    KV_TABLE_STREAMS = 0,
+    KV_TABLE_STREAMPPS,
+    KV_TABLE_DEVICES,
+    KV_TABLE_DEVICEPPS,
+    KV_TABLE_MAX,
+} kv_table_t;
+
+/* bump whenever the layout written by PayloadBuilder::storeKVCache changes */
+#define KV_CACHE_VERSION 1
+
+/* entries with more selectors than this are resolved by a linear scan */
+#define KV_INDEX_MAX_SELECTORS 8
+
 typedef enum {
     TAG_USECASEXML_ROOT,
     TAG_STREAM_SEL,
@@ -182,6 +198,13 @@ protected:
    static std::vector<allKVs> all_streampps;
    static std::vector<allKVs> all_devices;
    static std::vector<allKVs> all_devicepps;
+   /* interned selector values, used to build compact index keys */
+   static std::unordered_map<std::string, uint32_t> selectorValueIds;
+   /* (table, type, selector subset) -> kv pairs of each matching allKVs entry */
+   static std::unordered_map<std::string, std::vector<const std::vector<kvPairs> *>> kvIndex;
+   /* (table, type) combinations which could not be indexed */
+   static std::set<std::pair<int32_t, uint32_t>> kvIndexFallback;
+   static bool kvIndexReady;
 
 public:
     void payloadUsbAudioConfig(uint8_t** payload, size_t* size,
@@ -286,6 +309,17 @@ public:
     static bool findKVs(std::vector<std::pair<selector_type_t, std::string>>
         &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
         std::vector<std::pair<int32_t, int32_t>> &keyVector);
+    static bool scanKVs(std::vector<std::pair<selector_type_t, std::string>>
+        &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
+        std::vector<std::pair<int32_t, int32_t>> &keyVector);
+    static void buildKVIndex();
+    static int loadKVCache(const char *path, uint64_t srcHash, uint64_t srcSize);
+    static void storeKVCache(const char *path, uint64_t srcHash, uint64_t srcSize);
+    static void indexKVTable(int32_t table, std::vector<allKVs> &any_type);
+    static int32_t getKVTable(std::vector<allKVs> &any_type);
+    static bool getKVIndexKey(int32_t table, uint32_t type,
+        std::vector<std::pair<selector_type_t, std::string>> &selector_pairs,
+        bool intern, std::string &key);
     static std::string removeSpaces(const std::string& str);
     static std::vector<std::string> splitStrings(const std::string& str);
     static int getBtDeviceKV(int dev_id, std::vector<std::pair<int, int>> &deviceKV,
@@ -40,6 +40,7 @@
 #include <deque>
 #include "PalAudioRoute.h"
 #include "PalCommon.h"
+#include "OffloadEventLoop.h"
 #include <tinyalsa/asoundlib.h>
 #include <condition_variable>
 #include <sound/compress_params.h>
@@ -51,7 +52,6 @@ class Stream;
 class Session;
 
 enum {
-    OFFLOAD_CMD_EXIT,               /* exit compress offload thread loop*/
     OFFLOAD_CMD_DRAIN,              /* send a full drain request to DSP */
     OFFLOAD_CMD_PARTIAL_DRAIN,      /* send a partial drain request to DSP */
     OFFLOAD_CMD_WAIT_FOR_BUFFER,    /* wait for buffer released by DSP */
@@ -76,12 +76,6 @@ enum {
 #define PAL_SND_PROFILE_WMA10_LOSSLESS SND_AUDIOMODE_WMAPRO_LEVELM2
 #endif
 
-struct offload_msg {
-    offload_msg(int c)
-        :cmd(c) {}
-    int cmd; /**< command */
-};
-
 class SessionAlsaCompress : public Session
 {
 private:
@@ -92,13 +86,15 @@ private:
     struct snd_codec codec;
     //  unsigned int compressDevId;
     std::vector<int> compressDevIds;
-    std::unique_ptr<std::thread> worker_thread;
-    std::queue<std::shared_ptr<offload_msg>> msg_queue_;
+    /* offload commands, run on the shared OffloadEventLoop */
+    OffloadStrand offloadStrand;
+    bool offloadStrandActive;
+    /* only accessed from offloadStrand commands */
+    bool isDrainCalled;
     size_t compress_cap_buf_size;
     std::vector<std::pair<std::string, int>> freeDeviceMetadata;
 
-    std::condition_variable cv_; /* used to wait for incoming requests */
-    std::mutex cv_mutex_; /* mutex used in conjunction with above cv */
+    int postOffloadCmd(int cmd);
     void getSndCodecParam(struct snd_codec &codec, struct pal_stream_attributes &sAttr);
     int getSndCodecId(pal_audio_fmt_t fmt);
     int setCustomFormatParam(pal_audio_fmt_t audio_fmt);
@@ -142,7 +138,7 @@ public:
     int read(Stream *s, int tag, struct pal_buffer *buf, int * size) override;
     int write(Stream *s, int tag, struct pal_buffer *buf, int * size, int flag) override;
     int setECRef(Stream *s, std::shared_ptr<Device> rx_dev, bool is_enable) override;
-    static void offloadThreadLoop(SessionAlsaCompress *ob);
+    static void offloadCmdHandler(void *ctx, int cmd);
     int registerCallBack(session_callback cb, uint64_t cookie);
     int drain(pal_drain_type_t type);
     int flush();
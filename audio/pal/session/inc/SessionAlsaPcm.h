@@ -46,6 +46,22 @@
 class Stream;
 class Session;
 
+/*
+ * Data path settings of one direction, resolved when the session starts
+ * so that read() and write() do not look them up per buffer.
+ */
+struct pcm_io_desc {
+    bool valid;
+    /* mmap use case, ADM focus is held around every transfer */
+    bool useAdm;
+    size_t chunkSize;
+    uint32_t frameSize;
+    uint32_t sampleRate;
+    long chunkNs;
+    int (*writeFn)(struct pcm *pcm, const void *data, unsigned int count);
+    int (*readFn)(struct pcm *pcm, void *data, unsigned int count);
+};
+
 class SessionAlsaPcm : public Session
 {
 private:
@@ -71,6 +87,10 @@ private:
     uint32_t svaMiid;
     static std::mutex pcmLpmRefCntMtx;
     static int pcmLpmRefCnt;
+    struct pcm_io_desc writeDesc;
+    struct pcm_io_desc readDesc;
+    int updateIoDesc(Stream *s);
+    void resetIoDesc();
 public:
 
     SessionAlsaPcm(std::shared_ptr<ResourceManager> Rm);
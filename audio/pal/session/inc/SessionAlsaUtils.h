@@ -40,6 +40,10 @@
 
 #include <tinyalsa/asoundlib.h>
 #include <sound/asound.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 
 class Stream;
@@ -77,6 +81,33 @@ enum BeCtrlsIndex {
     BE_MAX_NUM_MIXER_CONTROLS,
 };
 
+/*
+ * Collects writes to virtual mixer controls and applies them in order
+ * with a single write to the AGM plugin batch control. Without that
+ * control, or if a write cannot be batched, commit() falls back to
+ * writing the controls one at a time. Either way every write is tried,
+ * so teardown sequences complete, and commit() returns the first error.
+ */
+class MixerTransaction
+{
+public:
+    MixerTransaction();
+    void setEnum(struct mixer_ctl *ctl, const char *value);
+    void setArray(struct mixer_ctl *ctl, const void *data, size_t size);
+    /* applies and clears the queued writes, a no-op if there are none */
+    int commit(struct mixer *mixer);
+private:
+    struct Write {
+        struct mixer_ctl *ctl;
+        std::string value;   /* enum string */
+        size_t offset;       /* of the array value in batch_ */
+        size_t size;
+    };
+    void addRecord(struct mixer_ctl *ctl, const void *data, size_t size);
+    std::vector<Write> writes_;
+    std::vector<uint8_t> batch_;
+    bool batchable_;
+};
 
 class SessionAlsaUtils
 {
@@ -87,8 +118,15 @@ private:
     static struct mixer_ctl *getBeMixerControl(struct mixer *am, std::string beName,
         uint32_t idx);
     static struct mixer_ctl *getStaticMixerControl(struct mixer *am, std::string name);
+    /* resolved mixer controls per mixer, keyed by full control name */
+    static std::mutex mixerCtlCacheMutex;
+    static std::unordered_map<struct mixer *,
+        std::unordered_map<std::string, struct mixer_ctl *>> mixerCtlCache;
 public:
     ~SessionAlsaUtils();
+    static struct mixer_ctl *getMixerControl(struct mixer *am, const std::string &name);
+    static struct mixer_ctl *getMixerControl(struct mixer *am, const char *name);
+    static void invalidateMixerControlCache(struct mixer *am = nullptr);
     static bool isRxDevice(uint32_t devId);
     static int setMixerCtlData(struct mixer_ctl *ctl, MixerCtlType id, void *data, int size);
     static int getTagMetadata(int32_t tagsent, std::vector <std::pair<int, int>> &tkv, struct agm_tag_config *tagConfig);
@@ -99,6 +99,7 @@ class SoundTriggerEngineCapi : public SoundTriggerEngine {
     int32_t StopSoundEngine();
     int32_t StartKeywordDetection();
     int32_t StartUserVerification();
+    int32_t PrepareWorkBuffers(size_t input_size);
     static void BufferThreadLoop(SoundTriggerEngineCapi *capi_engine);
 
     std::string lib_name_;
@@ -131,6 +132,15 @@ class SoundTriggerEngineCapi : public SoundTriggerEngine {
     int32_t detection_state_;
     stage2_uv_wrapper_scratch_param_t in_model_buffer_param_;
     stage2_uv_wrapper_scratch_param_t scratch_param_;
+
+    /* second stage work buffers, reused across detections */
+    char *process_input_buff_;
+    size_t process_input_buff_size_;
+    capi_v2_stream_data_t stream_input_;
+    capi_v2_buf_t stream_input_buf_;
+    sva_result_t kw_result_;
+    stage2_uv_wrapper_result uv_result_;
+    stage2_uv_wrapper_stage1_uv_score_t uv_score_;
 };
 #endif  // SOUNDTRIGGERENGINECAPI_H
 
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: OffloadEventLoop"
+
+#include "OffloadEventLoop.h"
+#include "PalCommon.h"
+#include <errno.h>
+#include <chrono>
+#include <system_error>
+#include <thread>
+
+OffloadEventLoop *OffloadEventLoop::getInstance()
+{
+    /* never destroyed, detached workers may still be waiting on it at exit */
+    static OffloadEventLoop *instance = new OffloadEventLoop();
+
+    return instance;
+}
+
+OffloadEventLoop::OffloadEventLoop()
+    : readyHead_(nullptr), readyTail_(nullptr), numReady_(0), numWorkers_(0),
+      numIdle_(0)
+{
+}
+
+int OffloadEventLoop::post(OffloadStrand *strand, int cmd)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (strand->count == OFFLOAD_STRAND_QUEUE_SIZE) {
+        PAL_ERR(LOG_TAG, "strand %pK queue full, dropping cmd %d", strand, cmd);
+        return -ENOSPC;
+    }
+    strand->cmds[(strand->head + strand->count) & (OFFLOAD_STRAND_QUEUE_SIZE - 1)] = cmd;
+    strand->count++;
+    if (strand->scheduled)
+        return 0;
+
+    strand->scheduled = true;
+    strand->next = nullptr;
+    if (readyTail_)
+        readyTail_->next = strand;
+    else
+        readyHead_ = strand;
+    readyTail_ = strand;
+    numReady_++;
+
+    /* every ready strand needs a worker of its own, one may block for long */
+    if (numReady_ <= numIdle_) {
+        cv_.notify_one();
+        return 0;
+    }
+    try {
+        std::thread(&OffloadEventLoop::workerLoop, this).detach();
+        numWorkers_++;
+        PAL_DBG(LOG_TAG, "started worker, %u workers", numWorkers_);
+    } catch (const std::system_error &e) {
+        /* a busy worker picks the strand up once it is done */
+        PAL_ERR(LOG_TAG, "failed to start worker: %s", e.what());
+    }
+
+    return 0;
+}
+
+void OffloadEventLoop::flush(OffloadStrand *strand)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    strand->idle.wait(lock, [strand] { return !strand->scheduled; });
+}
+
+bool OffloadEventLoop::isIdle(OffloadStrand *strand)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return !strand->scheduled;
+}
+
+void OffloadEventLoop::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    OffloadStrand *strand = nullptr;
+    std::cv_status status;
+    int cmd;
+
+    while (1) {
+        while (!readyHead_) {
+            numIdle_++;
+            status = cv_.wait_for(lock,
+                    std::chrono::milliseconds(OFFLOAD_LOOP_IDLE_TIMEOUT_MS));
+            numIdle_--;
+            if (!readyHead_ && status == std::cv_status::timeout &&
+                numIdle_ >= OFFLOAD_LOOP_MIN_IDLE_WORKERS) {
+                numWorkers_--;
+                PAL_DBG(LOG_TAG, "worker retired, %u workers", numWorkers_);
+                return;
+            }
+        }
+
+        strand = readyHead_;
+        readyHead_ = strand->next;
+        if (!readyHead_)
+            readyTail_ = nullptr;
+        numReady_--;
+
+        while (strand->count) {
+            cmd = strand->cmds[strand->head];
+            strand->head = (strand->head + 1) & (OFFLOAD_STRAND_QUEUE_SIZE - 1);
+            strand->count--;
+            lock.unlock();
+            strand->handler(strand->ctx, cmd);
+            lock.lock();
+        }
+        strand->scheduled = false;
+        strand->idle.notify_all();
+    }
+}
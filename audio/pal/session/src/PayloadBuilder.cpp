@@ -34,6 +34,7 @@
 #define LOG_TAG "PAL: PayloadBuilder"
 #include "ResourceManager.h"
 #include "PayloadBuilder.h"
+#include "PalConfigCache.h"
 #include "SessionGsl.h"
 #include "StreamSoundTrigger.h"
 #include "spr_api.h"
@@ -52,6 +53,8 @@
 #endif
 
 #define USECASE_ARRAX_XML_FILE "/vendor/etc/usecaseKvManager_arrax.xml"
+#define USECASE_CACHE_FILE PAL_CONFIG_CACHE_DIR "/usecaseKvManager.bin"
+#define USECASE_ARRAX_CACHE_FILE PAL_CONFIG_CACHE_DIR "/usecaseKvManager_arrax.bin"
 #define PARAM_ID_CHMIXER_COEFF 0x0800101F
 #define CUSTOM_STEREO_NUM_OUT_CH 0x0002
 #define CUSTOM_STEREO_NUM_IN_CH 0x0002
@@ -170,6 +173,11 @@ std::vector<allKVs> PayloadBuilder::all_streams;
 std::vector<allKVs> PayloadBuilder::all_streampps;
 std::vector<allKVs> PayloadBuilder::all_devices;
 std::vector<allKVs> PayloadBuilder::all_devicepps;
+std::unordered_map<std::string, uint32_t> PayloadBuilder::selectorValueIds;
+std::unordered_map<std::string, std::vector<const std::vector<kvPairs> *>>
+    PayloadBuilder::kvIndex;
+std::set<std::pair<int32_t, uint32_t>> PayloadBuilder::kvIndexFallback;
+bool PayloadBuilder::kvIndexReady = false;
 
 template <typename T>
 void PayloadBuilder::populateChannelMap(T pcmChannel, uint8_t numChannel)
@@ -857,20 +865,36 @@ int PayloadBuilder::init()
     int ret = 0;
     int bytes_read;
     void *buf = NULL;
+    const char *xmlFile = USECASE_XML_FILE;
+    const char *cacheFile = USECASE_CACHE_FILE;
+    uint64_t xmlHash = 0;
+    uint64_t xmlSize = 0;
+    bool cacheable = false;
     struct user_xml_data tag_data;
     memset(&tag_data, 0, sizeof(tag_data));
+    kvIndexReady = false;
+    kvIndex.clear();
+    kvIndexFallback.clear();
+    selectorValueIds.clear();
     all_streams.clear();
     all_streampps.clear();
     all_devices.clear();
     all_devicepps.clear();
 
     if (getSocId() == ARRAX_SOC_ID) {
-        PAL_INFO(LOG_TAG, "XML parsing started %s", USECASE_ARRAX_XML_FILE);
-        file = fopen(USECASE_ARRAX_XML_FILE, "r");
-    } else {
-        PAL_INFO(LOG_TAG, "XML parsing started %s", USECASE_XML_FILE);
-        file = fopen(USECASE_XML_FILE, "r");
+        xmlFile = USECASE_ARRAX_XML_FILE;
+        cacheFile = USECASE_ARRAX_CACHE_FILE;
     }
+
+    cacheable = !PalConfigCache::hashFile(xmlFile, &xmlHash, &xmlSize);
+    if (cacheable && !loadKVCache(cacheFile, xmlHash, xmlSize)) {
+        PAL_INFO(LOG_TAG, "loaded %s from %s", xmlFile, cacheFile);
+        buildKVIndex();
+        goto done;
+    }
+
+    PAL_INFO(LOG_TAG, "XML parsing started %s", xmlFile);
+    file = fopen(xmlFile, "r");
     if (!file) {
         PAL_ERR(LOG_TAG, "Failed to open xml");
         ret = -EINVAL;
@@ -910,6 +934,10 @@ int PayloadBuilder::init()
             break;
     }
 
+    buildKVIndex();
+    if (cacheable)
+        storeKVCache(cacheFile, xmlHash, xmlSize);
+
 freeParser:
     XML_ParserFree(parser);
 closeFile:
@@ -918,6 +946,226 @@ done:
     return ret;
 }
 
+/*
+ * Cache payload, per table in kv_table_t order:
+ * count, then per allKVs: id_type[], then per kvInfo: selector_names[],
+ * selector_pairs[] as (type, value), kv_pairs[] as (key, value).
+ * Every array is prefixed with its length.
+ */
+void PayloadBuilder::storeKVCache(const char *path, uint64_t srcHash, uint64_t srcSize)
+{
+    PalConfigCacheWriter writer;
+    std::vector<allKVs> *kvCacheTables[KV_TABLE_MAX] =
+        {&all_streams, &all_streampps, &all_devices, &all_devicepps};
+
+    for (int32_t t = 0; t < KV_TABLE_MAX; t++) {
+        writer.putU32(kvCacheTables[t]->size());
+        for (auto &kvs : *kvCacheTables[t]) {
+            writer.putU32(kvs.id_type.size());
+            for (auto id : kvs.id_type)
+                writer.putU32(id);
+            writer.putU32(kvs.keys_values.size());
+            for (auto &info : kvs.keys_values) {
+                writer.putU32(info.selector_names.size());
+                for (auto &name : info.selector_names)
+                    writer.putString(name);
+                writer.putU32(info.selector_pairs.size());
+                for (auto &sel : info.selector_pairs) {
+                    writer.putU32(sel.first);
+                    writer.putString(sel.second);
+                }
+                writer.putU32(info.kv_pairs.size());
+                for (auto &kv : info.kv_pairs) {
+                    writer.putU32(kv.key);
+                    writer.putU32(kv.value);
+                }
+            }
+        }
+    }
+
+    /* a missing cache only costs the next boot a parse */
+    writer.commit(path, KV_CACHE_VERSION, srcHash, srcSize);
+}
+
+int PayloadBuilder::loadKVCache(const char *path, uint64_t srcHash, uint64_t srcSize)
+{
+    PalConfigCacheReader reader;
+    std::vector<allKVs> *kvCacheTables[KV_TABLE_MAX] =
+        {&all_streams, &all_streampps, &all_devices, &all_devicepps};
+    uint32_t count, n, m, value;
+    int ret = 0;
+
+    ret = reader.open(path, KV_CACHE_VERSION, srcHash, srcSize);
+    if (ret)
+        return ret;
+
+    for (int32_t t = 0; t < KV_TABLE_MAX; t++) {
+        std::vector<allKVs> &table = *kvCacheTables[t];
+
+        if (!reader.getU32(&count))
+            goto corrupt;
+        table.resize(count);
+        for (auto &kvs : table) {
+            if (!reader.getU32(&n))
+                goto corrupt;
+            kvs.id_type.resize(n);
+            for (auto &id : kvs.id_type) {
+                if (!reader.getU32(&value))
+                    goto corrupt;
+                id = value;
+            }
+            if (!reader.getU32(&n))
+                goto corrupt;
+            kvs.keys_values.resize(n);
+            for (auto &info : kvs.keys_values) {
+                if (!reader.getU32(&m))
+                    goto corrupt;
+                info.selector_names.resize(m);
+                for (auto &name : info.selector_names) {
+                    if (!reader.getString(name))
+                        goto corrupt;
+                }
+                if (!reader.getU32(&m))
+                    goto corrupt;
+                info.selector_pairs.resize(m);
+                for (auto &sel : info.selector_pairs) {
+                    if (!reader.getU32(&value) || !reader.getString(sel.second))
+                        goto corrupt;
+                    sel.first = (selector_type_t)value;
+                }
+                if (!reader.getU32(&m))
+                    goto corrupt;
+                info.kv_pairs.resize(m);
+                for (auto &kv : info.kv_pairs) {
+                    if (!reader.getU32(&kv.key) || !reader.getU32(&kv.value))
+                        goto corrupt;
+                }
+            }
+        }
+    }
+
+    if (reader.atEnd())
+        return 0;
+
+corrupt:
+    PAL_ERR(LOG_TAG, "malformed kv cache %s, falling back to xml", path);
+    for (int32_t t = 0; t < KV_TABLE_MAX; t++)
+        kvCacheTables[t]->clear();
+    return -EINVAL;
+}
+
+int32_t PayloadBuilder::getKVTable(std::vector<allKVs> &any_type)
+{
+    if (&any_type == &all_streams)
+        return KV_TABLE_STREAMS;
+    if (&any_type == &all_streampps)
+        return KV_TABLE_STREAMPPS;
+    if (&any_type == &all_devices)
+        return KV_TABLE_DEVICES;
+    if (&any_type == &all_devicepps)
+        return KV_TABLE_DEVICEPPS;
+    return -EINVAL;
+}
+
+/*
+ * Index key is the table, the stream type/device id and the sorted,
+ * de-duplicated (selector, interned value) tuple packed into a string.
+ * Returns false if a selector value was never seen in the xml, in which
+ * case nothing can match.
+ */
+bool PayloadBuilder::getKVIndexKey(int32_t table, uint32_t type,
+    std::vector<std::pair<selector_type_t, std::string>> &selector_pairs,
+    bool intern, std::string &key)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> ids;
+    uint32_t id = 0;
+
+    for (auto &pair : selector_pairs) {
+        auto it = selectorValueIds.find(pair.second);
+        if (it != selectorValueIds.end()) {
+            id = it->second;
+        } else if (intern) {
+            id = selectorValueIds.size();
+            selectorValueIds[pair.second] = id;
+        } else {
+            return false;
+        }
+        ids.push_back(std::make_pair((uint32_t)pair.first, id));
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    key.clear();
+    key.reserve(sizeof(table) + sizeof(type) + ids.size() * 2 * sizeof(uint32_t));
+    key.append((const char *)&table, sizeof(table));
+    key.append((const char *)&type, sizeof(type));
+    for (auto &p : ids) {
+        key.append((const char *)&p.first, sizeof(p.first));
+        key.append((const char *)&p.second, sizeof(p.second));
+    }
+    return true;
+}
+
+/*
+ * findKVs matches the first entry (in ascending selector count order) of
+ * each allKVs block whose selectors are a superset of the requested ones,
+ * or an entry without selectors when none are requested. Compile that
+ * into a hash keyed on every selector subset of every entry so a lookup
+ * is a single probe.
+ */
+void PayloadBuilder::indexKVTable(int32_t table, std::vector<allKVs> &any_type)
+{
+    std::string key;
+    std::vector<std::pair<selector_type_t, std::string>> subset;
+
+    for (auto &kvs : any_type) {
+        std::set<std::string> matched;
+
+        for (auto &info : kvs.keys_values) {
+            std::vector<std::pair<selector_type_t, std::string>> sels =
+                info.selector_pairs;
+
+            std::sort(sels.begin(), sels.end());
+            sels.erase(std::unique(sels.begin(), sels.end()), sels.end());
+            for (auto type : kvs.id_type) {
+                if (sels.size() > KV_INDEX_MAX_SELECTORS) {
+                    PAL_INFO(LOG_TAG, "too many selectors for type %d, not indexed",
+                        type);
+                    kvIndexFallback.insert(std::make_pair(table, (uint32_t)type));
+                    continue;
+                }
+                /* mask 0 (no selectors) only matches entries without selectors */
+                for (uint32_t mask = sels.empty() ? 0 : 1;
+                     mask < (1u << sels.size()); mask++) {
+                    subset.clear();
+                    for (uint32_t b = 0; b < sels.size(); b++) {
+                        if (mask & (1u << b))
+                            subset.push_back(sels[b]);
+                    }
+                    getKVIndexKey(table, type, subset, true, key);
+                    if (matched.insert(key).second)
+                        kvIndex[key].push_back(&info.kv_pairs);
+                }
+            }
+        }
+    }
+}
+
+void PayloadBuilder::buildKVIndex()
+{
+    kvIndex.clear();
+    kvIndexFallback.clear();
+    selectorValueIds.clear();
+
+    indexKVTable(KV_TABLE_STREAMS, all_streams);
+    indexKVTable(KV_TABLE_STREAMPPS, all_streampps);
+    indexKVTable(KV_TABLE_DEVICES, all_devices);
+    indexKVTable(KV_TABLE_DEVICEPPS, all_devicepps);
+    kvIndexReady = true;
+    PAL_INFO(LOG_TAG, "KV index built, %zu keys, %zu selector values",
+        kvIndex.size(), selectorValueIds.size());
+}
+
 void PayloadBuilder::payloadTimestamp(std::shared_ptr<std::vector<uint8_t>>& payload,
                                       size_t *size, uint32_t moduleId)
 {
@@ -2245,6 +2493,35 @@ exit:
 bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>>
     &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
     std::vector<std::pair<int, int>> &keyVector)
+{
+    int32_t table = getKVTable(any_type);
+    std::string key;
+    bool found = false;
+
+    if (!kvIndexReady || table < 0 ||
+        kvIndexFallback.count(std::make_pair(table, type)))
+        return scanKVs(filled_selector_pairs, type, any_type, keyVector);
+
+    if (!getKVIndexKey(table, type, filled_selector_pairs, false, key))
+        return found;
+
+    auto it = kvIndex.find(key);
+    if (it == kvIndex.end())
+        return found;
+
+    for (auto kv_pairs : it->second) {
+        for (auto &kv : *kv_pairs) {
+            keyVector.push_back(std::make_pair(kv.key, kv.value));
+            PAL_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n", kv.key, kv.value);
+        }
+        found = true;
+    }
+    return found;
+}
+
+bool PayloadBuilder::scanKVs(std::vector<std::pair<selector_type_t, std::string>>
+    &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
+    std::vector<std::pair<int, int>> &keyVector)
 {
     bool found = false;
 
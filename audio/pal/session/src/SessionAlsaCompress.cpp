@@ -586,88 +586,72 @@ int SessionAlsaCompress::setCustomFormatParam(pal_audio_fmt_t audio_fmt)
     return status;
 }
 
-void SessionAlsaCompress::offloadThreadLoop(SessionAlsaCompress* compressObj)
+int SessionAlsaCompress::postOffloadCmd(int cmd)
 {
-    std::shared_ptr<offload_msg> msg;
+    return OffloadEventLoop::getInstance()->post(&offloadStrand, cmd);
+}
+
+void SessionAlsaCompress::offloadCmdHandler(void *ctx, int cmd)
+{
+    SessionAlsaCompress *compressObj = (SessionAlsaCompress *)ctx;
     uint32_t event_id = 0;
     int ret = 0;
-    bool is_drain_called = false;
-    std::unique_lock<std::mutex> lock(compressObj->cv_mutex_);
-
-    while (1) {
-        if (compressObj->msg_queue_.empty())
-            compressObj->cv_.wait(lock);  /* wait for incoming requests */
-
-        if (!compressObj->msg_queue_.empty()) {
-            msg = compressObj->msg_queue_.front();
-            compressObj->msg_queue_.pop();
-            lock.unlock();
-
-            if (msg && msg->cmd == OFFLOAD_CMD_EXIT)
-                break; // exit the thread
-
-            if (msg && msg->cmd == OFFLOAD_CMD_WAIT_FOR_BUFFER) {
-                if (compressObj->rm->cardState == CARD_STATUS_ONLINE) {
-                    PAL_VERBOSE(LOG_TAG, "calling compress_wait");
-                    ret = compress_wait(compressObj->compress, -1);
-                    PAL_VERBOSE(LOG_TAG, "out of compress_wait, ret %d", ret);
-                    event_id = PAL_STREAM_CBK_EVENT_WRITE_READY;
-                }
-            } else if (msg && msg->cmd == OFFLOAD_CMD_DRAIN) {
-                if (!is_drain_called) {
-                    PAL_INFO(LOG_TAG, "calling compress_drain");
-                    if (compressObj->rm->cardState == CARD_STATUS_ONLINE &&
-                        compressObj->compress != NULL) {
-                         ret = compress_drain(compressObj->compress);
-                         PAL_INFO(LOG_TAG, "out of compress_drain, ret %d", ret);
-                    }
-                }
-                if (ret == -ENETRESET) {
-                    PAL_ERR(LOG_TAG, "Block drain ready event during SSR");
-                    lock.lock();
-                    continue;
+
+    if (cmd == OFFLOAD_CMD_WAIT_FOR_BUFFER) {
+        if (compressObj->rm->cardState == CARD_STATUS_ONLINE) {
+            PAL_VERBOSE(LOG_TAG, "calling compress_wait");
+            ret = compress_wait(compressObj->compress, -1);
+            PAL_VERBOSE(LOG_TAG, "out of compress_wait, ret %d", ret);
+            event_id = PAL_STREAM_CBK_EVENT_WRITE_READY;
+        }
+    } else if (cmd == OFFLOAD_CMD_DRAIN) {
+        if (!compressObj->isDrainCalled) {
+            PAL_INFO(LOG_TAG, "calling compress_drain");
+            if (compressObj->rm->cardState == CARD_STATUS_ONLINE &&
+                compressObj->compress != NULL) {
+                 ret = compress_drain(compressObj->compress);
+                 PAL_INFO(LOG_TAG, "out of compress_drain, ret %d", ret);
+            }
+        }
+        if (ret == -ENETRESET) {
+            PAL_ERR(LOG_TAG, "Block drain ready event during SSR");
+            return;
+        }
+        compressObj->isDrainCalled = false;
+        event_id = PAL_STREAM_CBK_EVENT_DRAIN_READY;
+    } else if (cmd == OFFLOAD_CMD_PARTIAL_DRAIN) {
+        if (compressObj->rm->cardState == CARD_STATUS_ONLINE) {
+            if (compressObj->isGaplessFmt) {
+                PAL_DBG(LOG_TAG, "calling partial compress_drain");
+                ret = compress_next_track(compressObj->compress);
+                PAL_INFO(LOG_TAG, "out of compress next track, ret %d", ret);
+                if (ret == 0) {
+                    ret = compress_partial_drain(compressObj->compress);
+                    PAL_INFO(LOG_TAG, "out of partial compress_drain, ret %d", ret);
                 }
-                is_drain_called = false;
+                event_id = PAL_STREAM_CBK_EVENT_PARTIAL_DRAIN_READY;
+            } else {
+                PAL_DBG(LOG_TAG, "calling compress_drain");
+                ret = compress_drain(compressObj->compress);
+                PAL_INFO(LOG_TAG, "out of compress_drain, ret %d", ret);
+                compressObj->isDrainCalled = true;
                 event_id = PAL_STREAM_CBK_EVENT_DRAIN_READY;
-            } else if (msg && msg->cmd == OFFLOAD_CMD_PARTIAL_DRAIN) {
-                if (compressObj->rm->cardState == CARD_STATUS_ONLINE) {
-                    if (compressObj->isGaplessFmt) {
-                        PAL_DBG(LOG_TAG, "calling partial compress_drain");
-                        ret = compress_next_track(compressObj->compress);
-                        PAL_INFO(LOG_TAG, "out of compress next track, ret %d", ret);
-                        if (ret == 0) {
-                            ret = compress_partial_drain(compressObj->compress);
-                            PAL_INFO(LOG_TAG, "out of partial compress_drain, ret %d", ret);
-                        }
-                        event_id = PAL_STREAM_CBK_EVENT_PARTIAL_DRAIN_READY;
-                    } else {
-                        PAL_DBG(LOG_TAG, "calling compress_drain");
-                        ret = compress_drain(compressObj->compress);
-                        PAL_INFO(LOG_TAG, "out of compress_drain, ret %d", ret);
-                        is_drain_called = true;
-                        event_id = PAL_STREAM_CBK_EVENT_DRAIN_READY;
-                    }
-                }
-                if (ret == -ENETRESET) {
-                    PAL_ERR(LOG_TAG, "Block drain ready event during SSR");
-                    lock.lock();
-                    continue;
-                }
-            }  else if (msg && msg->cmd == OFFLOAD_CMD_ERROR) {
-                PAL_ERR(LOG_TAG, "Sending error to PAL client");
-                event_id = PAL_STREAM_CBK_EVENT_ERROR;
             }
-            if (compressObj->sessionCb)
-                compressObj->sessionCb(compressObj->cbCookie, event_id, NULL, 0);
-
-            lock.lock();
         }
-
+        if (ret == -ENETRESET) {
+            PAL_ERR(LOG_TAG, "Block drain ready event during SSR");
+            return;
+        }
+    } else if (cmd == OFFLOAD_CMD_ERROR) {
+        PAL_ERR(LOG_TAG, "Sending error to PAL client");
+        event_id = PAL_STREAM_CBK_EVENT_ERROR;
     }
-    PAL_DBG(LOG_TAG, "exit offloadThreadLoop");
+    if (compressObj->sessionCb)
+        compressObj->sessionCb(compressObj->cbCookie, event_id, NULL, 0);
 }
 
 SessionAlsaCompress::SessionAlsaCompress(std::shared_ptr<ResourceManager> Rm)
+    : offloadStrand(offloadCmdHandler, this)
 {
     rm = Rm;
     builder = new PayloadBuilder();
@@ -687,6 +671,8 @@ SessionAlsaCompress::SessionAlsaCompress(std::shared_ptr<ResourceManager> Rm)
     capture_started = false;
     playback_paused = false;
     capture_paused = false;
+    offloadStrandActive = false;
+    isDrainCalled = false;
     streamHandle = NULL;
     ecRefDevId = PAL_DEVICE_OUT_MIN;
 }
@@ -947,7 +933,7 @@ int SessionAlsaCompress::setTKV(Stream * s __unused, configType type, effect_pal
                 goto exit;
             }
             tagCntrlName<<stream<<compressDevIds.at(0)<<" "<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -1020,7 +1006,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, uint32_t tag1,
                 goto exit;
             }
             tagCntrlName << stream << compressDevIds.at(0) << " " << setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -1082,7 +1068,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
     if (compressDevIds.size() > 0)
         beCntrlName<<stream<<compressDevIds.at(0)<<" "<<setBEControl;
 
-    ctl = mixer_get_ctl_by_name(mixer, beCntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(mixer, beCntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", beCntrlName.str().data());
         return -ENOENT;
@@ -1118,7 +1104,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
             }
             //TODO: how to get the id '5'
             tagCntrlName<<stream<<compressDevIds.at(0)<<" "<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 return -ENOENT;
@@ -1157,7 +1143,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
             status = SessionAlsaUtils::getCalMetadata(ckv, calConfig);
             //TODO: how to get the id '0'
             calCntrlName<<stream<<compressDevIds.at(0)<<" "<<setCalibrationControl;
-            ctl = mixer_get_ctl_by_name(mixer, calCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, calCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", calCntrlName.str().data());
                 return -ENOENT;
@@ -1256,8 +1242,9 @@ int SessionAlsaCompress::start(Stream * s)
 
     switch (sAttr.direction) {
         case PAL_AUDIO_OUTPUT:
-            /** create an offload thread for posting callbacks */
-            worker_thread = std::make_unique<std::thread>(offloadThreadLoop, this);
+            /** callbacks are posted from the shared offload event loop */
+            offloadStrandActive = true;
+            isDrainCalled = false;
             compress_config.fragment_size = out_buf_size;
             compress_config.fragments = out_buf_count;
             compress_config.codec = &codec;
@@ -1582,26 +1569,14 @@ int SessionAlsaCompress::close(Stream * s)
     }
     if (compress) {
         compress_close(compress);
-        if (rm->cardState == CARD_STATUS_OFFLINE) {
-            std::shared_ptr<offload_msg> msg = std::make_shared<offload_msg>(OFFLOAD_CMD_ERROR);
-            std::lock_guard<std::mutex> lock(cv_mutex_);
-            msg_queue_.push(msg);
-            cv_.notify_all();
-        }
-        {
-            std::shared_ptr<offload_msg> msg = std::make_shared<offload_msg>(OFFLOAD_CMD_EXIT);
-            std::lock_guard<std::mutex> lock(cv_mutex_);
-            msg_queue_.push(msg);
-            cv_.notify_all();
-        }
-
-        /* wait for handler to exit */
-        worker_thread->join();
-        worker_thread.reset(NULL);
+        if (rm->cardState == CARD_STATUS_OFFLINE)
+            postOffloadCmd(OFFLOAD_CMD_ERROR);
 
-        /* empty the pending messages in queue */
-        while (!msg_queue_.empty())
-            msg_queue_.pop();
+        /* wait for the queued commands to run */
+        if (offloadStrandActive) {
+            OffloadEventLoop::getInstance()->flush(&offloadStrand);
+            offloadStrandActive = false;
+        }
     }
     PAL_DBG(LOG_TAG, "out of compress close");
 
@@ -1722,11 +1697,7 @@ int SessionAlsaCompress::write(Stream *s __unused, int tag __unused, struct pal_
 
     if (bytes_written >= 0 && bytes_written < (ssize_t)buf->size && non_blocking) {
         PAL_DBG(LOG_TAG, "No space available in compress driver, post msg to cb thread");
-        std::shared_ptr<offload_msg> msg = std::make_shared<offload_msg>(OFFLOAD_CMD_WAIT_FOR_BUFFER);
-        std::lock_guard<std::mutex> lock(cv_mutex_);
-        msg_queue_.push(msg);
-
-        cv_.notify_all();
+        postOffloadCmd(OFFLOAD_CMD_WAIT_FOR_BUFFER);
     }
 
     if (!playback_started && bytes_written > 0) {
@@ -1764,7 +1735,7 @@ struct mixer_ctl* SessionAlsaCompress::getFEMixerCtl(const char *controlName, in
 
     *device = compressDevIds.at(0);
     CntrlName << "COMPRESS" << compressDevIds.at(0) << " " << controlName;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return nullptr;
@@ -2000,7 +1971,7 @@ int SessionAlsaCompress::flush()
 
 int SessionAlsaCompress::drain(pal_drain_type_t type)
 {
-    std::shared_ptr<offload_msg> msg;
+    int status = 0;
 
     if (!compress) {
        PAL_ERR(LOG_TAG, "compress is invalid");
@@ -2011,29 +1982,23 @@ int SessionAlsaCompress::drain(pal_drain_type_t type)
 
     switch (type) {
     case PAL_DRAIN:
-    {
-        msg = std::make_shared<offload_msg>(OFFLOAD_CMD_DRAIN);
-        std::lock_guard<std::mutex> drain_lock(cv_mutex_);
-        msg_queue_.push(msg);
-        cv_.notify_all();
-    }
-    break;
+        status = postOffloadCmd(OFFLOAD_CMD_DRAIN);
+        break;
 
     case PAL_DRAIN_PARTIAL:
-    {
-        msg = std::make_shared<offload_msg>(OFFLOAD_CMD_PARTIAL_DRAIN);
-        std::lock_guard<std::mutex> partial_lock(cv_mutex_);
-        msg_queue_.push(msg);
-        cv_.notify_all();
-    }
-    break;
+        status = postOffloadCmd(OFFLOAD_CMD_PARTIAL_DRAIN);
+        break;
 
     default:
         PAL_ERR(LOG_TAG, "invalid drain type = %d", type);
         return -EINVAL;
     }
 
-    return 0;
+    /* a dropped drain never raises DRAIN_READY, let the client know */
+    if (status)
+        PAL_ERR(LOG_TAG, "failed to queue drain type %d, status %d", type, status);
+
+    return status;
 }
 
 int SessionAlsaCompress::getParameters(Stream *s __unused, int tagId __unused, uint32_t param_id __unused, void **payload __unused)
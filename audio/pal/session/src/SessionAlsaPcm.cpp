@@ -68,9 +68,11 @@
 #include "SessionAlsaUtils.h"
 #include "Stream.h"
 #include "ResourceManager.h"
+#include "PalTrace.h"
 #include "detection_cmn_api.h"
 #include "acd_api.h"
 #include <agm/agm_api.h>
+#include <agm/agm_latency.h>
 #include <asps/asps_acm_api.h>
 #include <sstream>
 #include <string>
@@ -103,6 +105,7 @@ SessionAlsaPcm::SessionAlsaPcm(std::shared_ptr<ResourceManager> Rm)
    mState = SESSION_IDLE;
    ecRefDevId = PAL_DEVICE_OUT_MIN;
    streamHandle = NULL;
+   resetIoDesc();
 }
 
 SessionAlsaPcm::~SessionAlsaPcm()
@@ -304,7 +307,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, uint32_t tag1,
                 status = -EINVAL;
                 goto exit;
             }
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 return -ENOENT;
@@ -344,7 +347,7 @@ struct mixer_ctl* SessionAlsaPcm::getFEMixerCtl(const char *controlName, int *de
 
     *device = pcmDevIds.at(0);
     CntrlName << "PCM" <<pcmDevIds.at(0) << " " << controlName;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return nullptr;
@@ -481,7 +484,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
                 beCntrlName << stream << pcmDevIds.at(0) << " " << setBEControl;
         }
 
-        ctl = mixer_get_ctl_by_name(mixer, beCntrlName.str().data());
+        ctl = SessionAlsaUtils::getMixerControl(mixer, beCntrlName.str().data());
         if (!ctl) {
             PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", beCntrlName.str().data());
             return -ENOENT;
@@ -532,7 +535,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
                 goto exit;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -582,7 +585,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
                 goto exit;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, calCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, calCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", calCntrlName.str().data());
                 status = -ENOENT;
@@ -699,7 +702,7 @@ int SessionAlsaPcm::setTKV(Stream * s, configType type, effect_pal_payload_t *ef
                 goto exit;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -1398,6 +1401,9 @@ pcm_start:
         }
     }
 
+    /* rebuilt on every start, buffer sizes and format may have changed */
+    if (pcm)
+        updateIoDesc(s);
     mState = SESSION_STARTED;
 
 exit:
@@ -1486,6 +1492,7 @@ int SessionAlsaPcm::stop(Stream * s)
             break;
     }
    rm->voteSleepMonitor(s, false);
+    resetIoDesc();
     mState = SESSION_STOPPED;
 
     if (sAttr.type == PAL_STREAM_VOICE_UI) {
@@ -1711,6 +1718,7 @@ int SessionAlsaPcm::close(Stream * s)
             break;
     }
     frontEndIdAllocated = false;
+    resetIoDesc();
     mState = SESSION_IDLE;
 
     if (sAttr.type == PAL_STREAM_VOICE_UI ||
@@ -1886,40 +1894,95 @@ int SessionAlsaPcm::connectSessionDevice(Stream* streamHandle, pal_stream_type_t
     return status;
 }
 
-int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, int * size)
+static void initIoDesc(struct pcm_io_desc *desc, struct pcm *pcm, size_t chunkSize,
+                       uint32_t sampleRate, bool isMmap)
+{
+    desc->useAdm = isMmap;
+    desc->chunkSize = chunkSize;
+    desc->frameSize = pcm_frames_to_bytes(pcm, 1);
+    desc->sampleRate = sampleRate;
+    desc->chunkNs = 0;
+    if (desc->frameSize && sampleRate)
+        desc->chunkNs = (chunkSize / desc->frameSize) * 1000000000LL / sampleRate;
+    desc->writeFn = isMmap ? pcm_mmap_write : pcm_write;
+    desc->readFn = isMmap ? pcm_mmap_read : pcm_read;
+    desc->valid = (chunkSize != 0);
+}
+
+static long ioDescBytesToNs(const struct pcm_io_desc *desc, uint32_t bytes)
+{
+    if (bytes == desc->chunkSize)
+        return desc->chunkNs;
+    if (!desc->frameSize || !desc->sampleRate)
+        return 0;
+    return (bytes / desc->frameSize) * 1000000000LL / desc->sampleRate;
+}
+
+int SessionAlsaPcm::updateIoDesc(Stream *s)
 {
-    int status = 0, bytesRead = 0, bytesToRead = 0, offset = 0, pcmReadSize = 0;
     struct pal_stream_attributes sAttr;
+    bool isMmap = false;
+    int status = 0;
 
-    PAL_VERBOSE(LOG_TAG, "Enter")
+    resetIoDesc();
+    if (!pcm) {
+        PAL_ERR(LOG_TAG, "PCM is NULL");
+        return -EINVAL;
+    }
     status = s->getStreamAttributes(&sAttr);
     if (status != 0) {
         PAL_ERR(LOG_TAG, "stream get attributes failed");
         return status;
     }
+
+    isMmap = SessionAlsaUtils::isMmapUsecase(sAttr);
+    initIoDesc(&writeDesc, pcm, out_buf_size, sAttr.out_media_config.sample_rate, isMmap);
+    initIoDesc(&readDesc, pcm, in_buf_size, sAttr.in_media_config.sample_rate, isMmap);
+    PAL_DBG(LOG_TAG, "mmap %d out chunk %zu in chunk %zu frame size %u", isMmap,
+            writeDesc.chunkSize, readDesc.chunkSize, writeDesc.frameSize);
+
+    return 0;
+}
+
+void SessionAlsaPcm::resetIoDesc()
+{
+    memset(&writeDesc, 0, sizeof(writeDesc));
+    memset(&readDesc, 0, sizeof(readDesc));
+}
+
+int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, int * size)
+{
+    int status = 0, bytesRead = 0, bytesToRead = 0, offset = 0, pcmReadSize = 0;
+    void *data = nullptr;
+
+    PAL_VERBOSE(LOG_TAG, "Enter")
+    if (!readDesc.valid) {
+        status = updateIoDesc(s);
+        if (status != 0)
+            return status;
+        if (!readDesc.valid) {
+            PAL_ERR(LOG_TAG, "no read buffer size");
+            return -EINVAL;
+        }
+    }
+
     while (1) {
         offset = bytesRead + buf->offset;
         bytesToRead = buf->size - offset;
         if (!bytesToRead)
             break;
-        if ((bytesToRead / in_buf_size) >= 1)
-            pcmReadSize = in_buf_size;
+        if ((bytesToRead / readDesc.chunkSize) >= 1)
+            pcmReadSize = readDesc.chunkSize;
         else
             pcmReadSize = bytesToRead;
-        void *data = buf->buffer;
-        data = static_cast<char*>(data) + offset;
+        data = static_cast<char*>(buf->buffer) + offset;
 
-        if(SessionAlsaUtils::isMmapUsecase(sAttr))
-        {
-            long ns = 0;
-            if (sAttr.in_media_config.sample_rate)
-                ns = pcm_bytes_to_frames(pcm, pcmReadSize)*1000000000LL/
-                    sAttr.in_media_config.sample_rate;
-            requestAdmFocus(s, ns);
-            status =  pcm_mmap_read(pcm, data,  pcmReadSize);
+        if (readDesc.useAdm) {
+            requestAdmFocus(s, ioDescBytesToNs(&readDesc, pcmReadSize));
+            status = readDesc.readFn(pcm, data, pcmReadSize);
             releaseAdmFocus(s);
         } else {
-            status =  pcm_read(pcm, data,  pcmReadSize);
+            status = readDesc.readFn(pcm, data, pcmReadSize);
         }
 
         if ((0 != status) || (pcmReadSize == 0)) {
@@ -1932,57 +1995,49 @@ int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, in
 
     *size = bytesRead;
     PAL_VERBOSE(LOG_TAG, "exit bytesRead:%d status:%d ", bytesRead, status);
+    PAL_TRACE("pcm %p read %d status %d", pcm, bytesRead, status);
     return status;
 }
 
 int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size,
                           int flag)
 {
+    AgmLatencyScope latency(AGM_LATENCY_STAGE_SESSION);
     int status = 0, bytesWritten = 0, bytesRemaining = 0, offset = 0;
     uint32_t sizeWritten = 0;
-    struct pal_stream_attributes sAttr;
-
+    void *data = nullptr;
 
     PAL_VERBOSE(LOG_TAG, "Enter buf:%p tag:%d flag:%d", buf, tag, flag);
 
-    status = s->getStreamAttributes(&sAttr);
-    if (status != 0) {
-        PAL_ERR(LOG_TAG, "stream get attributes failed");
-        return status;
-    }
-
     if (pcm == NULL) {
         PAL_ERR(LOG_TAG, "PCM is NULL");
         return -EINVAL;
     }
 
-    void *data = nullptr;
+    if (!writeDesc.valid) {
+        status = updateIoDesc(s);
+        if (status != 0)
+            return status;
+        if (!writeDesc.valid) {
+            PAL_ERR(LOG_TAG, "no write buffer size");
+            return -EINVAL;
+        }
+    }
 
     bytesRemaining = buf->size;
 
-    while ((bytesRemaining / out_buf_size) > 1) {
+    while ((bytesRemaining / writeDesc.chunkSize) > 1) {
         offset = bytesWritten + buf->offset;
-        data = buf->buffer;
-        data = static_cast<char *>(data) + offset;
-        sizeWritten = out_buf_size;  //initialize 0
-
-        if (!pcm) {
-            PAL_ERR(LOG_TAG, "pcm is NULL");
-            status = -EINVAL;
-            goto exit;
-        }
+        data = static_cast<char *>(buf->buffer) + offset;
+        sizeWritten = writeDesc.chunkSize;
 
-        if (SessionAlsaUtils::isMmapUsecase(sAttr)) {
-            long ns = 0;
-            if (sAttr.out_media_config.sample_rate)
-                ns = pcm_bytes_to_frames(pcm, sizeWritten)*1000000000LL/
-                    sAttr.out_media_config.sample_rate;
-            PAL_DBG(LOG_TAG, "1.bufsize:%u ns:%ld", sizeWritten, ns);
-            requestAdmFocus(s, ns);
-            status =  pcm_mmap_write(pcm, data,  sizeWritten);
+        if (writeDesc.useAdm) {
+            PAL_VERBOSE(LOG_TAG, "1.bufsize:%u ns:%ld", sizeWritten, writeDesc.chunkNs);
+            requestAdmFocus(s, writeDesc.chunkNs);
+            status = writeDesc.writeFn(pcm, data, sizeWritten);
             releaseAdmFocus(s);
         } else {
-            status =  pcm_write(pcm, data,  sizeWritten);
+            status = writeDesc.writeFn(pcm, data, sizeWritten);
         }
 
         if (0 != status) {
@@ -1994,24 +2049,15 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
     }
     offset = bytesWritten + buf->offset;
     sizeWritten = bytesRemaining;
-    data = buf->buffer;
+    data = static_cast<char *>(buf->buffer) + offset;
 
-    if (!pcm) {
-        PAL_ERR(LOG_TAG, "pcm is NULL");
-        status = -EINVAL;
-        goto exit;
-    }
-
-    data = static_cast<char *>(data) + offset;
-    if (SessionAlsaUtils::isMmapUsecase(sAttr)) {
+    if (writeDesc.useAdm) {
         if (sizeWritten) {
-            long ns = 0;
-            if (sAttr.out_media_config.sample_rate)
-                ns = pcm_bytes_to_frames(pcm, sizeWritten)*1000000000LL/
-                    sAttr.out_media_config.sample_rate;
-            PAL_DBG(LOG_TAG, "2.bufsize:%u ns:%ld", sizeWritten, ns);
+            long ns = ioDescBytesToNs(&writeDesc, sizeWritten);
+
+            PAL_VERBOSE(LOG_TAG, "2.bufsize:%u ns:%ld", sizeWritten, ns);
             requestAdmFocus(s, ns);
-            status =  pcm_mmap_write(pcm, data,  sizeWritten);
+            status = writeDesc.writeFn(pcm, data, sizeWritten);
             releaseAdmFocus(s);
             if (status != 0) {
                 PAL_ERR(LOG_TAG, "Error! pcm_mmap_write failed");
@@ -2019,7 +2065,7 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
             }
         }
     } else {
-        status =  pcm_write(pcm, data,  sizeWritten);
+        status = writeDesc.writeFn(pcm, data, sizeWritten);
         if (status != 0) {
             PAL_ERR(LOG_TAG, "Error! pcm_write failed");
             goto exit;
@@ -2029,6 +2075,7 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
     *size = bytesWritten;
 exit:
     PAL_VERBOSE(LOG_TAG, "exit status: %d", status);
+    PAL_TRACE("pcm %p wrote %d status %d", pcm, bytesWritten, status);
     return status;
 }
 
@@ -2547,7 +2594,7 @@ int SessionAlsaPcm::getParameters(Stream *s __unused, int tagId, uint32_t param_
         status = -EINVAL;
         goto exit;
     }
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         status = -ENOENT;
@@ -2876,7 +2923,7 @@ int SessionAlsaPcm::createMmapBuffer(Stream *s, int32_t min_size_frames,
 
 
         CntrlName << stream << pcmDevIds.at(0) << " " << control;
-        ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+        ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str().data());
         if (!ctl) {
             PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
             status = -ENOENT;
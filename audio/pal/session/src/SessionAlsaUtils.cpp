@@ -295,27 +295,71 @@ bool SessionAlsaUtils::isMmapUsecase(struct pal_stream_attributes sAttr)
 
 }
 
-struct mixer_ctl *SessionAlsaUtils::getStaticMixerControl(struct mixer *am, std::string name)
+std::mutex SessionAlsaUtils::mixerCtlCacheMutex;
+std::unordered_map<struct mixer *, std::unordered_map<std::string, struct mixer_ctl *>>
+    SessionAlsaUtils::mixerCtlCache;
+
+/*
+ * tinyalsa resolves control names with a linear search over all card
+ * controls, cache the result per mixer. Failed lookups are not cached
+ * since some controls only show up once the card is fully registered.
+ */
+struct mixer_ctl *SessionAlsaUtils::getMixerControl(struct mixer *am, const std::string &name)
 {
-    std::ostringstream cntrlName;
+    struct mixer_ctl *ctl = nullptr;
+
+    if (!am)
+        return nullptr;
+
+    std::lock_guard<std::mutex> lock(mixerCtlCacheMutex);
+    auto &ctls = mixerCtlCache[am];
+    auto it = ctls.find(name);
+    if (it != ctls.end())
+        return it->second;
+
+    ctl = mixer_get_ctl_by_name(am, name.c_str());
+    if (ctl)
+        ctls.emplace(name, ctl);
+
+    return ctl;
+}
+
+struct mixer_ctl *SessionAlsaUtils::getMixerControl(struct mixer *am, const char *name)
+{
+    if (!name)
+        return nullptr;
+
+    return getMixerControl(am, std::string(name));
+}
+
+/* drop cached controls of one mixer, or of all mixers if am is null */
+void SessionAlsaUtils::invalidateMixerControlCache(struct mixer *am)
+{
+    std::lock_guard<std::mutex> lock(mixerCtlCacheMutex);
+
+    if (am)
+        mixerCtlCache.erase(am);
+    else
+        mixerCtlCache.clear();
+}
 
-    cntrlName << name;
-    PAL_DBG(LOG_TAG, "mixer control name is %s", cntrlName.str().data());
+struct mixer_ctl *SessionAlsaUtils::getStaticMixerControl(struct mixer *am, std::string name)
+{
+    PAL_DBG(LOG_TAG, "mixer control name is %s", name.c_str());
 
-    return mixer_get_ctl_by_name(am, cntrlName.str().data());
+    return getMixerControl(am, name);
 }
 
 struct mixer_ctl *SessionAlsaUtils::getFeMixerControl(struct mixer *am, std::string feName,
         uint32_t idx)
 {
-    std::ostringstream cntrlName;
     struct mixer_ctl *ctl = NULL;
 
-    cntrlName << feName << feCtrlNames[idx];
-    PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
-    ctl = mixer_get_ctl_by_name(am, cntrlName.str().data());
+    feName.append(feCtrlNames[idx]);
+    PAL_DBG(LOG_TAG, "mixer control %s", feName.c_str());
+    ctl = getMixerControl(am, feName);
     if (!ctl)
-        PAL_FATAL(LOG_TAG, "invalid mixer control: %s", cntrlName.str().data());
+        PAL_FATAL(LOG_TAG, "invalid mixer control: %s", feName.c_str());
 
     return ctl;
 }
@@ -323,11 +367,104 @@ struct mixer_ctl *SessionAlsaUtils::getFeMixerControl(struct mixer *am, std::str
 struct mixer_ctl *SessionAlsaUtils::getBeMixerControl(struct mixer *am, std::string beName,
         uint32_t idx)
 {
-    std::ostringstream cntrlName;
+    beName.append(beCtrlNames[idx]);
+    PAL_DBG(LOG_TAG, "mixer control %s", beName.c_str());
+    return getMixerControl(am, beName);
+}
 
-    cntrlName << beName << beCtrlNames[idx];
-    PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
-    return mixer_get_ctl_by_name(am, cntrlName.str().data());
+MixerTransaction::MixerTransaction()
+    : batchable_(true)
+{
+}
+
+/* queue a record of the batch, see struct agm_mixer_batch_value */
+void MixerTransaction::addRecord(struct mixer_ctl *ctl, const void *data, size_t size)
+{
+    struct agm_mixer_batch_value val;
+    Write write;
+
+    val.numid = mixer_ctl_get_id(ctl);
+    val.length = size;
+    batch_.insert(batch_.end(), (const uint8_t *)&val, (const uint8_t *)&val + sizeof(val));
+    write.ctl = ctl;
+    write.offset = batch_.size();
+    write.size = size;
+    batch_.insert(batch_.end(), (const uint8_t *)data, (const uint8_t *)data + size);
+    batch_.resize(batch_.size() + AGM_MIXER_BATCH_ALIGN(size) - size, 0);
+    writes_.push_back(write);
+}
+
+void MixerTransaction::setEnum(struct mixer_ctl *ctl, const char *value)
+{
+    uint32_t item, num;
+
+    if (!ctl || !value) {
+        PAL_ERR(LOG_TAG, "invalid mixer ctrl data passed");
+        return;
+    }
+
+    num = mixer_ctl_get_num_enums(ctl);
+    for (item = 0; item < num; item++) {
+        if (!strcmp(mixer_ctl_get_enum_string(ctl, item), value))
+            break;
+    }
+    /* let the fallback path report an unknown item */
+    if (item == num)
+        batchable_ = false;
+
+    addRecord(ctl, &item, sizeof(item));
+    writes_.back().value = value;
+}
+
+void MixerTransaction::setArray(struct mixer_ctl *ctl, const void *data, size_t size)
+{
+    if (!ctl || !data || size == 0) {
+        PAL_ERR(LOG_TAG, "invalid mixer ctrl data passed");
+        return;
+    }
+
+    if (mixer_ctl_get_type(ctl) == MIXER_CTL_TYPE_INT)
+        batchable_ = false;
+
+    addRecord(ctl, data, size);
+}
+
+int MixerTransaction::commit(struct mixer *mixer)
+{
+    struct mixer_ctl *batchCtl = nullptr;
+    int status = 0;
+
+    if (writes_.empty())
+        return 0;
+
+    if (batchable_ && batch_.size() <= AGM_MIXER_BATCH_MAX_SIZE)
+        batchCtl = SessionAlsaUtils::getMixerControl(mixer, AGM_MIXER_BATCH_CTL_NAME);
+
+    if (batchCtl) {
+        status = mixer_ctl_set_array(batchCtl, batch_.data(), batch_.size());
+        if (status)
+            PAL_ERR(LOG_TAG, "batch of %zu writes failed %d", writes_.size(), status);
+    } else {
+        for (auto &write : writes_) {
+            int ret;
+
+            if (!write.value.empty())
+                ret = mixer_ctl_set_enum_by_string(write.ctl, write.value.c_str());
+            else
+                ret = mixer_ctl_set_array(write.ctl, &batch_[write.offset], write.size);
+            if (ret) {
+                PAL_ERR(LOG_TAG, "write to %s failed %d", mixer_ctl_get_name(write.ctl),
+                        ret);
+                if (!status)
+                    status = ret;
+            }
+        }
+    }
+
+    writes_.clear();
+    batch_.clear();
+    batchable_ = true;
+    return status;
 }
 
 int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManager> rmHandle,
@@ -350,7 +487,7 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     struct mixer_ctl *beMetaDataMixerCtrl = nullptr;
     std::vector<std::shared_ptr<Device>> associatedDevices;
     std::shared_ptr<Device> beDevObj = nullptr;
-    struct mixer *mixerHandle;
+    struct mixer *mixerHandle = nullptr;
     uint32_t i;
     uint32_t streamPropId[] = {0x08000010, 1, 0x1}; /** gsl_subgraph_platform_driver_props.xml */
     uint32_t devicePropId[] = {0x08000010, 2, 0x2, 0x5};
@@ -358,6 +495,7 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     struct pal_device_info devinfo = {};
     struct pal_device dAttr;
     PayloadBuilder* builder = nullptr;
+    MixerTransaction txn;
 
     PAL_DBG(LOG_TAG, "Entry \n");
 
@@ -418,9 +556,9 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
             goto freeStreamMetaData;
         }
     }
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], "ZERO");
+    txn.setEnum(feMixerCtrls[FE_CONTROL], "ZERO");
     if (streamMetaData.size)
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamMetaData.buf,
+        txn.setArray(feMixerCtrls[FE_METADATA], (void *)streamMetaData.buf,
                 streamMetaData.size);
 
     for (std::vector<std::pair<int32_t, std::string>>::const_iterator be = BackEnds.begin();
@@ -521,14 +659,14 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
 
         /** set mixer controls */
         if (deviceMetaData.size)
-            mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+            txn.setArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], be->second.data());
+        txn.setEnum(feMixerCtrls[FE_CONTROL], be->second.data());
         if (streamDeviceMetaData.size) {
-            mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
+            txn.setArray(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
                     streamDeviceMetaData.size);
         }
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONNECT], (be->second).data());
+        txn.setEnum(feMixerCtrls[FE_CONNECT], (be->second).data());
 
         deviceKV.clear();
         streamDeviceKV.clear();
@@ -543,6 +681,8 @@ freeMetaData:
     if (deviceMetaData.buf)
         free(deviceMetaData.buf);
 freeStreamMetaData:
+    /** apply the writes queued so far, the transaction holds copies */
+    txn.commit(mixerHandle);
     if (streamMetaData.buf)
         free(streamMetaData.buf);
 exit:
@@ -572,6 +712,7 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     struct mixer_ctl *feMixerCtrls[FE_MAX_NUM_MIXER_CONTROLS] = { nullptr };
     struct mixer_ctl *beMetaDataMixerCtrl = nullptr;
     struct mixer *mixerHandle = nullptr;
+    MixerTransaction txn;
 
     status = streamHandle->getStreamAttributes(&sAttr);
     if(0 != status) {
@@ -627,21 +768,21 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
         }
 
         /** set mixer controls */
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_DISCONNECT], be->second.data());
+        txn.setEnum(feMixerCtrls[FE_DISCONNECT], be->second.data());
         for (auto freeDevmeta = freedevicemetadata.begin(); freeDevmeta != freedevicemetadata.end(); ++freeDevmeta) {
             PAL_DBG(LOG_TAG, "backend %s and freedevicemetadata %d", freeDevmeta->first.data(), freeDevmeta->second);
             if (!(freeDevmeta->first.compare(be->second))) {
                 if (freeDevmeta->second == 0) {
                     PAL_INFO(LOG_TAG, "No need to free device metadata as device is still active");
                 } else {
-                    mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+                    txn.setArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                                     deviceMetaData.size);
                 }
             }
         }
 
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], be->second.data());
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
+        txn.setEnum(feMixerCtrls[FE_CONTROL], be->second.data());
+        txn.setArray(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
                 streamDeviceMetaData.size);
 
         free(streamDeviceMetaData.buf);
@@ -651,15 +792,16 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     }
 
     // clear stream metadata
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], "ZERO");
+    txn.setEnum(feMixerCtrls[FE_CONTROL], "ZERO");
     getAgmMetaData(emptyKV, emptyKV, (struct prop_data *)streamPropId,
             streamMetaData);
     if (streamMetaData.size)
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA],
+        txn.setArray(feMixerCtrls[FE_METADATA],
             (void *)streamMetaData.buf, streamMetaData.size);
 
 
 freeMetaData:
+    txn.commit(mixerHandle);
     if (streamDeviceMetaData.buf)
         free(streamDeviceMetaData.buf);
     if (deviceMetaData.buf)
@@ -991,7 +1133,7 @@ int SessionAlsaUtils::getTimestamp(struct mixer *mixer, const std::vector<int> &
         return -EINVAL;
     }
     CntrlName<<pcmDeviceName<<" "<<getParamControl;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = SessionAlsaUtils::getMixerControl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return -ENOENT;
@@ -1064,7 +1206,7 @@ int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = SessionAlsaUtils::getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1148,7 +1290,7 @@ int SessionAlsaUtils::getTagsWithModuleInfo(struct mixer *mixer, int device, con
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = SessionAlsaUtils::getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1200,7 +1342,7 @@ int SessionAlsaUtils::setMixerParameter(struct mixer *mixer, int device,
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = SessionAlsaUtils::getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1236,7 +1378,7 @@ int SessionAlsaUtils::setStreamMetadataType(struct mixer *mixer, int device, con
     }
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = SessionAlsaUtils::getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1290,7 +1432,7 @@ int SessionAlsaUtils::registerMixerEvent(struct mixer *mixer, int device, void *
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = SessionAlsaUtils::getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1329,7 +1471,7 @@ int SessionAlsaUtils::setECRefPath(struct mixer *mixer, int device, const char *
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     printf("%s mixer -%s-\n", __func__, mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = SessionAlsaUtils::getMixerControl(mixer, mixer_str);
     if (!ctl) {
         printf("Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1366,7 +1508,7 @@ int SessionAlsaUtils::mixerWriteDatapathParams(struct mixer *mixer, int device,
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = SessionAlsaUtils::getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1416,6 +1558,7 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     sidetone_mode_t sidetoneMode = SIDETONE_OFF;
     struct pal_device dAttr;
     bool isDeviceFound = false;
+    MixerTransaction txn;
 
     if (RxDevIds.empty() || TxDevIds.empty()) {
         PAL_ERR(LOG_TAG, "RX and TX FE Dev Ids are empty");
@@ -1641,34 +1784,34 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     txDevNum = !rxDevNum;
 
     /** set TX mixer controls */
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], "ZERO");
+    txn.setEnum(txFeMixerCtrls[FE_CONTROL], "ZERO");
     if (streamTxMetaData.size)
-        mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
+        txn.setArray(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
                 streamTxMetaData.size);
     if (deviceTxMetaData.size)
-        mixer_ctl_set_array(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
+        txn.setArray(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
                 deviceTxMetaData.size);
     if (streamDeviceTxMetaData.size) {
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
-        mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
+        txn.setEnum(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
+        txn.setArray(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
                 streamDeviceTxMetaData.size);
     }
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONNECT], txBackEnds[0].second.data());
+    txn.setEnum(txFeMixerCtrls[FE_CONNECT], txBackEnds[0].second.data());
 
     /** set RX mixer controls */
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], "ZERO");
+    txn.setEnum(rxFeMixerCtrls[FE_CONTROL], "ZERO");
     if (streamRxMetaData.size)
-        mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
+        txn.setArray(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
                 streamRxMetaData.size);
     if (deviceRxMetaData.size)
-        mixer_ctl_set_array(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
+        txn.setArray(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
                 deviceRxMetaData.size);
     if (streamDeviceRxMetaData.size) {
-        mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
-        mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
+        txn.setEnum(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
+        txn.setArray(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
                 streamDeviceRxMetaData.size);
     }
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONNECT], rxBackEnds[0].second.data());
+    txn.setEnum(rxFeMixerCtrls[FE_CONNECT], rxBackEnds[0].second.data());
 
     if (sAttr.type != PAL_STREAM_VOICE_CALL) {
         txFeMixerCtrls[FE_LOOPBACK] = getFeMixerControl(mixerHandle, txFeName.str(), FE_LOOPBACK);
@@ -1678,9 +1821,11 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
             status = -EINVAL;
             goto freeTxMetaData;
         }
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
+        txn.setEnum(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
     }
 freeTxMetaData:
+    /** apply the writes queued so far, the transaction holds copies */
+    txn.commit(mixerHandle);
     free(streamDeviceTxMetaData.buf);
     free(deviceTxMetaData.buf);
     free(streamTxMetaData.buf);
@@ -1810,6 +1955,7 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     uint32_t devicePropId[] = {0x08000010, 2, 0x2, 0x5};
     uint32_t streamDevicePropId[] = {0x08000010, 1, 0x3}; /** gsl_subgraph_platform_driver_props.xml */
     uint32_t i, rxDevNum, txDevNum;
+    MixerTransaction txn;
 
     status = streamHandle->getStreamAttributes(&sAttr);
     if(0 != status) {
@@ -1910,25 +2056,25 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
             status = -EINVAL;
             goto freeTxMetaData;
         }
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
+        txn.setEnum(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
     }
 
     /** set TX mixer controls */
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_DISCONNECT], txBackEnds[0].second.data());
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], "ZERO");
-    mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
+    txn.setEnum(txFeMixerCtrls[FE_DISCONNECT], txBackEnds[0].second.data());
+    txn.setEnum(txFeMixerCtrls[FE_CONTROL], "ZERO");
+    txn.setArray(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
             streamTxMetaData.size);
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
-    mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
+    txn.setEnum(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
+    txn.setArray(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
             streamDeviceTxMetaData.size);
 
     /** set RX mixer controls */
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_DISCONNECT], rxBackEnds[0].second.data());
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], "ZERO");
-    mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
+    txn.setEnum(rxFeMixerCtrls[FE_DISCONNECT], rxBackEnds[0].second.data());
+    txn.setEnum(rxFeMixerCtrls[FE_CONTROL], "ZERO");
+    txn.setArray(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
             streamRxMetaData.size);
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
-    mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
+    txn.setEnum(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
+    txn.setArray(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
             streamDeviceRxMetaData.size);
 
     /* set Backend mixer control */
@@ -1938,20 +2084,21 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
             if (freeDevMeta->second == 0) {
                 PAL_INFO(LOG_TAG, "No need to free TX device metadata as device is still active");
             } else {
-                mixer_ctl_set_array(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
-                                    deviceTxMetaData.size);
+                txn.setArray(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
+                        deviceTxMetaData.size);
             }
         }
         if (!(freeDevMeta->first.compare(rxBackEnds[0].second))) {
             if (freeDevMeta->second == 0) {
                 PAL_INFO(LOG_TAG, "No need to free RX device metadata as device is still active");
             } else {
-                mixer_ctl_set_array(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
-                                    deviceRxMetaData.size);
+                txn.setArray(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
+                        deviceRxMetaData.size);
             }
         }
     }
 freeTxMetaData:
+    txn.commit(mixerHandle);
     if (streamDeviceTxMetaData.buf)
         free(streamDeviceTxMetaData.buf);
     if (deviceTxMetaData.buf)
@@ -1989,6 +2136,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     struct mixer_ctl* beMetaDataMixerCtrl = nullptr;
     std::vector <std::tuple<Stream*, uint32_t>> activeStreamsDevices;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    MixerTransaction txn;
     int sub = 1;
     uint32_t i;
 
@@ -2022,7 +2170,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
             break;
     }
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
-    disconnectCtrl = mixer_get_ctl_by_name(mixerHandle, disconnectCtrlName.str().data());
+    disconnectCtrl = SessionAlsaUtils::getMixerControl(mixerHandle, disconnectCtrlName.str().data());
     if (!disconnectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", disconnectCtrlName.str().data());
         return -EINVAL;
@@ -2039,7 +2187,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     }
 
     /** Disconnect FE to BE */
-    mixer_ctl_set_enum_by_string(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
+    txn.setEnum(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
 
     /** clear device metadata*/
     getAgmMetaData(emptyKV, emptyKV, (struct prop_data*)devicePropId,
@@ -2066,16 +2214,17 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     if (activeStreamsDevices.size() > 1) {
         PAL_INFO(LOG_TAG, "No need to free device metadata since active streams present on device");
     } else {
-        mixer_ctl_set_array(beMetaDataMixerCtrl, (void*)deviceMetaData.buf,
+        txn.setArray(beMetaDataMixerCtrl, (void*)deviceMetaData.buf,
             deviceMetaData.size);
     }
 
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL],
+    txn.setEnum(feMixerCtrls[FE_CONTROL],
         aifBackEndsToDisconnect[0].second.data());
-    mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void*)streamDeviceMetaData.buf,
+    txn.setArray(feMixerCtrls[FE_METADATA], (void*)streamDeviceMetaData.buf,
         streamDeviceMetaData.size);
 
 freeMetaData:
+    txn.commit(mixerHandle);
     if (streamDeviceMetaData.buf)
         free(streamDeviceMetaData.buf);
     if (deviceMetaData.buf)
@@ -2120,7 +2269,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
             break;
     }
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
-    disconnectCtrl = mixer_get_ctl_by_name(mixerHandle, disconnectCtrlName.str().data());
+    disconnectCtrl = SessionAlsaUtils::getMixerControl(mixerHandle, disconnectCtrlName.str().data());
     if (!disconnectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", disconnectCtrlName.str().data());
         return -EINVAL;
@@ -2259,7 +2408,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
          }
     }
 
-    connectCtrl = mixer_get_ctl_by_name(mixerHandle, connectCtrlName.str().data());
+    connectCtrl = SessionAlsaUtils::getMixerControl(mixerHandle, connectCtrlName.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         status = -EINVAL;
@@ -2329,7 +2478,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
         }
     }
 
-    connectCtrl = mixer_get_ctl_by_name(mixerHandle, connectCtrlName.str().data());
+    connectCtrl = SessionAlsaUtils::getMixerControl(mixerHandle, connectCtrlName.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         status = -EINVAL;
@@ -2385,6 +2534,7 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
     struct mixer_ctl *aifMdCtrl = nullptr;
     PayloadBuilder* builder = new PayloadBuilder();
     struct mixer *mixerHandle = nullptr;
+    MixerTransaction txn;
     uint32_t devicePropId[] = {0x08000010, 2, 0x2, 0x5};
     uint32_t streamDevicePropId[] = {0x08000010, 1, 0x3}; /** gsl_subgraph_platform_driver_props.xml */
     bool is_compress = false;
@@ -2547,7 +2697,7 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
 
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
 
-    aifMdCtrl = mixer_get_ctl_by_name(mixerHandle, aifMdName.str().data());
+    aifMdCtrl = SessionAlsaUtils::getMixerControl(mixerHandle, aifMdName.str().data());
     PAL_DBG(LOG_TAG, "mixer control %s", aifMdName.str().data());
     if (!aifMdCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", aifMdName.str().data());
@@ -2555,18 +2705,18 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
         goto freeMetaData;
     }
     if (deviceMetaData.size)
-        mixer_ctl_set_array(aifMdCtrl, (void *)deviceMetaData.buf, deviceMetaData.size);
+        txn.setArray(aifMdCtrl, (void *)deviceMetaData.buf, deviceMetaData.size);
 
-    feCtrl = mixer_get_ctl_by_name(mixerHandle, cntrlName.str().data());
+    feCtrl = SessionAlsaUtils::getMixerControl(mixerHandle, cntrlName.str().data());
     PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
     if (!feCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", cntrlName.str().data());
         status = -EINVAL;
         goto freeMetaData;
     }
-    mixer_ctl_set_enum_by_string(feCtrl, aifBackEndsToConnect[0].second.data());
+    txn.setEnum(feCtrl, aifBackEndsToConnect[0].second.data());
 
-    feMdCtrl = mixer_get_ctl_by_name(mixerHandle, feMdName.str().data());
+    feMdCtrl = SessionAlsaUtils::getMixerControl(mixerHandle, feMdName.str().data());
     PAL_DBG(LOG_TAG, "mixer control %s", feMdName.str().data());
     if (!feMdCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", feMdName.str().data());
@@ -2574,8 +2724,9 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
         goto freeMetaData;
     }
     if (streamDeviceMetaData.size)
-        mixer_ctl_set_array(feMdCtrl, (void *)streamDeviceMetaData.buf, streamDeviceMetaData.size);
+        txn.setArray(feMdCtrl, (void *)streamDeviceMetaData.buf, streamDeviceMetaData.size);
 freeMetaData:
+    txn.commit(mixerHandle);
     free(streamDeviceMetaData.buf);
     free(deviceMetaData.buf);
 
@@ -1287,7 +1287,7 @@ int SessionAlsaVoice::payloadTaged(Stream * s, configType type, int tag,
                 goto exit;
             }
             tagCntrlName<<stream<<" "<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = SessionAlsaUtils::getMixerControl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 return -ENOENT;
@@ -1787,7 +1787,7 @@ int SessionAlsaVoice::setVoiceMixerParameter(Stream * s, struct mixer *mixer,
     snprintf(mixer_str, ctl_len, "%s %s", stream, control);
 
     PAL_VERBOSE(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = SessionAlsaUtils::getMixerControl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
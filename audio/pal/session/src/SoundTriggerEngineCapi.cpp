@@ -40,6 +40,12 @@
 #include "Stream.h"
 #include "SoundTriggerPlatformInfo.h"
 
+/*
+ * Upper bound for one wait on the ring buffer, so exit_buffering_ is
+ * still honored when no more data arrives from the first stage.
+ */
+#define CAPI_READ_WAIT_TIMEOUT_MS 20
+
 ST_DBG_DECLARE(static int keyword_detection_cnt = 0);
 ST_DBG_DECLARE(static int user_verification_cnt = 0);
 
@@ -133,8 +139,8 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     int32_t status = 0;
     char *process_input_buff = nullptr;
     capi_v2_err_t rc = CAPI_V2_EOK;
-    capi_v2_stream_data_t *stream_input = nullptr;
-    sva_result_t *result_cfg_ptr = nullptr;
+    capi_v2_stream_data_t *stream_input = &stream_input_;
+    sva_result_t *result_cfg_ptr = &kw_result_;
     int32_t read_size = 0;
     size_t start_idx = 0;
     size_t end_idx = 0;
@@ -192,36 +198,12 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     }
 
     memset(&capi_result, 0, sizeof(capi_result));
-    process_input_buff = (char*)calloc(1, buffer_size_);
-    if (!process_input_buff) {
-        status = -ENOMEM;
-        PAL_ERR(LOG_TAG, "failed to allocate process input buff, status %d",
-                status);
-        goto exit;
-    }
-
-    stream_input = (capi_v2_stream_data_t *)
-                   calloc(1, sizeof(capi_v2_stream_data_t));
-    if (!stream_input) {
-        status = -ENOMEM;
-        PAL_ERR(LOG_TAG, "failed to allocate stream input, status %d", status);
-        goto exit;
-    }
-
-    stream_input->buf_ptr = (capi_v2_buf_t*)calloc(1, sizeof(capi_v2_buf_t));
-    if (!stream_input->buf_ptr) {
-        status = -ENOMEM;
-        PAL_ERR(LOG_TAG, "failed to allocate stream_input->buf_ptr, status %d",
-                status);
-        goto exit;
-    }
-
-    result_cfg_ptr = (sva_result_t*)calloc(1, sizeof(sva_result_t));
-    if (!result_cfg_ptr) {
-        status = -ENOMEM;
-        PAL_ERR(LOG_TAG, "failed to allocate result cfg ptr status %d", status);
+    status = PrepareWorkBuffers(std::max((size_t)buffer_size_, lab_buffer_size));
+    if (status) {
+        PAL_ERR(LOG_TAG, "failed to prepare work buffers, status %d", status);
         goto exit;
     }
+    process_input_buff = process_input_buff_;
 
     process_start = std::chrono::steady_clock::now();
     while (!exit_buffering_ &&
@@ -235,15 +217,33 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
 
         /* advance the offset to ensure we are reading at the right place */
         if (!buffer_advanced && buffer_start_ > 0) {
-            if (reader_->advanceReadOffset(buffer_start_)) {
+            if (reader_->getUnreadSize() >= buffer_start_ &&
+                reader_->advanceReadOffset(buffer_start_)) {
                 buffer_advanced = true;
             } else {
+                /* -EINVAL: reader disabled or offset beyond the ring */
+                status = reader_->waitForUnreadSize(buffer_start_,
+                    CAPI_READ_WAIT_TIMEOUT_MS);
+                if (status == -EINVAL) {
+                    PAL_ERR(LOG_TAG, "cannot wait for start offset %u", buffer_start_);
+                    goto exit;
+                }
+                status = 0;
                 continue;
             }
         }
 
-        if (reader_->getUnreadSize() < buffer_size_)
+        if (reader_->getUnreadSize() < buffer_size_) {
+            /* sleep until the first stage has buffered enough data */
+            status = reader_->waitForUnreadSize(buffer_size_,
+                CAPI_READ_WAIT_TIMEOUT_MS);
+            if (status == -EINVAL) {
+                PAL_ERR(LOG_TAG, "cannot wait for %u bytes", buffer_size_);
+                goto exit;
+            }
+            status = 0;
             continue;
+        }
 
         read_size = reader_->read((void*)process_input_buff, buffer_size_);
         if (read_size == 0) {
@@ -352,16 +352,6 @@ exit:
     if (reader_)
         reader_->updateState(READER_DISABLED);
 
-    if (process_input_buff)
-        free(process_input_buff);
-    if (stream_input) {
-        if (stream_input->buf_ptr)
-            free(stream_input->buf_ptr);
-        free(stream_input);
-    }
-    if (result_cfg_ptr)
-        free(result_cfg_ptr);
-
     PAL_DBG(LOG_TAG, "Exit, status %d", status);
 
     return status;
@@ -372,10 +362,10 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     int32_t status = 0;
     char *process_input_buff = nullptr;
     capi_v2_err_t rc = CAPI_V2_EOK;
-    capi_v2_stream_data_t *stream_input = nullptr;
+    capi_v2_stream_data_t *stream_input = &stream_input_;
     capi_v2_buf_t capi_uv_ptr;
-    stage2_uv_wrapper_result *result_cfg_ptr = nullptr;
-    stage2_uv_wrapper_stage1_uv_score_t *uv_cfg_ptr = nullptr;
+    stage2_uv_wrapper_result *result_cfg_ptr = &uv_result_;
+    stage2_uv_wrapper_stage1_uv_score_t *uv_cfg_ptr = &uv_score_;
     int32_t read_size = 0;
     capi_v2_buf_t capi_result;
     bool buffer_advanced = false;
@@ -425,43 +415,12 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     memset(&capi_uv_ptr, 0, sizeof(capi_uv_ptr));
     memset(&capi_result, 0, sizeof(capi_result));
 
-    process_input_buff = (char*)calloc(1, buffer_size_);
-    if (!process_input_buff) {
-        PAL_ERR(LOG_TAG, "failed to allocate process input buff");
-        status = -ENOMEM;
-        goto exit;
-    }
-
-    stream_input = (capi_v2_stream_data_t *)
-                   calloc(1, sizeof(capi_v2_stream_data_t));
-    if (!stream_input) {
-        PAL_ERR(LOG_TAG, "failed to allocate stream input");
-        status = -ENOMEM;
-        goto exit;
-    }
-
-    stream_input->buf_ptr = (capi_v2_buf_t*)calloc(1, sizeof(capi_v2_buf_t));
-    if (!stream_input->buf_ptr) {
-        PAL_ERR(LOG_TAG, "failed to allocate buf ptr");
-        status = -ENOMEM;
-        goto exit;
-    }
-
-    result_cfg_ptr = (stage2_uv_wrapper_result*)
-                     calloc(1, sizeof(stage2_uv_wrapper_result));
-    if (!result_cfg_ptr) {
-        PAL_ERR(LOG_TAG, "failed to allocate result cfg ptr");
-        status = -ENOMEM;
-        goto exit;
-    }
-
-    uv_cfg_ptr = (stage2_uv_wrapper_stage1_uv_score_t *)
-                 calloc(1, sizeof(stage2_uv_wrapper_stage1_uv_score_t));
-    if (!uv_cfg_ptr) {
-        PAL_ERR(LOG_TAG, "failed to allocate uv cfg ptr");
-        status = -ENOMEM;
+    status = PrepareWorkBuffers(buffer_size_);
+    if (status) {
+        PAL_ERR(LOG_TAG, "failed to prepare work buffers, status %d", status);
         goto exit;
     }
+    process_input_buff = process_input_buff_;
 
     str = dynamic_cast<StreamSoundTrigger *>(stream_handle_);
     if (str->GetModelType() == ST_MODULE_TYPE_GMM) {
@@ -508,15 +467,33 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
 
         /* advance the offset to ensure we are reading at the right place */
         if (!buffer_advanced && buffer_start_ > 0) {
-            if (reader_->advanceReadOffset(buffer_start_)) {
+            if (reader_->getUnreadSize() >= buffer_start_ &&
+                reader_->advanceReadOffset(buffer_start_)) {
                 buffer_advanced = true;
             } else {
+                /* -EINVAL: reader disabled or offset beyond the ring */
+                status = reader_->waitForUnreadSize(buffer_start_,
+                    CAPI_READ_WAIT_TIMEOUT_MS);
+                if (status == -EINVAL) {
+                    PAL_ERR(LOG_TAG, "cannot wait for start offset %u", buffer_start_);
+                    goto exit;
+                }
+                status = 0;
                 continue;
             }
         }
 
-        if (reader_->getUnreadSize() < buffer_size_)
+        if (reader_->getUnreadSize() < buffer_size_) {
+            /* sleep until the first stage has buffered enough data */
+            status = reader_->waitForUnreadSize(buffer_size_,
+                CAPI_READ_WAIT_TIMEOUT_MS);
+            if (status == -EINVAL) {
+                PAL_ERR(LOG_TAG, "cannot wait for %u bytes", buffer_size_);
+                goto exit;
+            }
+            status = 0;
             continue;
+        }
 
         read_size = reader_->read((void*)process_input_buff, buffer_size_);
         if (read_size == 0) {
@@ -615,18 +592,6 @@ exit:
     if (reader_)
         reader_->updateState(READER_DISABLED);
 
-    if (process_input_buff)
-        free(process_input_buff);
-    if (stream_input) {
-        if (stream_input->buf_ptr)
-            free(stream_input->buf_ptr);
-        free(stream_input);
-    }
-    if (result_cfg_ptr)
-        free(result_cfg_ptr);
-    if (uv_cfg_ptr)
-        free(uv_cfg_ptr);
-
     PAL_DBG(LOG_TAG, "Exit, status %d", status);
 
     return status;
@@ -664,6 +629,14 @@ SoundTriggerEngineCapi::SoundTriggerEngineCapi(
     det_conf_score_ = 0;
     memset(&in_model_buffer_param_, 0, sizeof(in_model_buffer_param_));
     memset(&scratch_param_, 0, sizeof(scratch_param_));
+    process_input_buff_ = nullptr;
+    process_input_buff_size_ = 0;
+    memset(&stream_input_, 0, sizeof(stream_input_));
+    memset(&stream_input_buf_, 0, sizeof(stream_input_buf_));
+    stream_input_.buf_ptr = &stream_input_buf_;
+    memset(&kw_result_, 0, sizeof(kw_result_));
+    memset(&uv_result_, 0, sizeof(uv_result_));
+    memset(&uv_score_, 0, sizeof(uv_score_));
 
     st_info_ = SoundTriggerPlatformInfo::GetInstance();
     if (!st_info_) {
@@ -769,9 +742,42 @@ SoundTriggerEngineCapi::~SoundTriggerEngineCapi()
         free(capi_handle_);
         capi_handle_ = nullptr;
     }
+    if (process_input_buff_) {
+        free(process_input_buff_);
+        process_input_buff_ = nullptr;
+    }
     PAL_DBG(LOG_TAG, "Exit");
 }
 
+/*
+ * Work buffers are owned by the engine and reused across detections,
+ * the input buffer only grows when a larger window is requested.
+ */
+int32_t SoundTriggerEngineCapi::PrepareWorkBuffers(size_t input_size)
+{
+    char *buf = nullptr;
+
+    if (input_size > process_input_buff_size_) {
+        buf = (char *)realloc(process_input_buff_, input_size);
+        if (!buf) {
+            PAL_ERR(LOG_TAG, "failed to grow process input buff to %zu",
+                input_size);
+            return -ENOMEM;
+        }
+        process_input_buff_ = buf;
+        process_input_buff_size_ = input_size;
+    }
+    memset(process_input_buff_, 0, process_input_buff_size_);
+    memset(&stream_input_buf_, 0, sizeof(stream_input_buf_));
+    stream_input_.buf_ptr = &stream_input_buf_;
+    stream_input_.bufs_num = 0;
+    memset(&kw_result_, 0, sizeof(kw_result_));
+    memset(&uv_result_, 0, sizeof(uv_result_));
+    memset(&uv_score_, 0, sizeof(uv_score_));
+
+    return 0;
+}
+
 int32_t SoundTriggerEngineCapi::StartSoundEngine()
 {
     int32_t status = 0;
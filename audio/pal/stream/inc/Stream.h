@@ -168,6 +168,7 @@ protected:
     bool mutexLockedbyRm = false;
     sem_t mInUse;
     int connectToDefaultDevice(Stream* streamHandle, uint32_t dir);
+    int32_t setUIEffectBatch(pal_param_payload *batch);
 public:
     virtual ~Stream() {};
     struct pal_volume_data* mVolumeData = NULL;
@@ -219,6 +220,8 @@ public:
     uint32_t getRenderLatency();
     uint32_t getLatency();
     int32_t getAssociatedDevices(std::vector <std::shared_ptr<Device>> &adevices);
+    bool isAssociatedWith(std::shared_ptr<Device> d);
+    bool hasAssociatedDevices() { return !mDevices.empty(); }
     int32_t getAssociatedPalDevices(std::vector <struct pal_device> &palDevices);
     void clearOutPalDevices();
     void addPalDevice(struct pal_device *dattr) { mPalDevice.push_back(*dattr); }
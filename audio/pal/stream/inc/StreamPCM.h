@@ -31,6 +31,10 @@
 #define STREAMPCM_H_
 
 #include "Stream.h"
+#include <atomic>
+
+/* posted by resume, the devices are registered again once data flows */
+#define PCM_IO_CMD_RESUME 0x1
 
 class ResourceManager;
 class Device;
@@ -77,6 +81,17 @@ public:
    static int32_t isSampleRateSupported(uint32_t sampleRate);
    static int32_t isChannelSupported(uint32_t numChannels);
    static int32_t isBitWidthSupported(uint32_t bitWidth);
+private:
+   /*
+    * Held by read()/write() across the blocking session call only, after
+    * mStreamMutex is dropped. Control ops keep using mStreamMutex and do
+    * not wait for a period to drain, only stop() takes both before the
+    * session resets its data path. Always taken after mStreamMutex.
+    */
+   std::mutex mStreamIOMutex;
+   /* PCM_IO_CMD_* left by control ops for the data path to act on */
+   std::atomic<uint32_t> mIoCmds{0};
+   void handleIoCmds();
 };
 
 #endif//STREAMPCM_H_
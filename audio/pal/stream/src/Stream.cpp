@@ -520,6 +520,11 @@ int32_t Stream::getAssociatedDevices(std::vector <std::shared_ptr<Device>> &aDev
     return status;
 }
 
+bool Stream::isAssociatedWith(std::shared_ptr<Device> d)
+{
+    return std::find(mDevices.begin(), mDevices.end(), d) != mDevices.end();
+}
+
 void Stream::clearOutPalDevices()
 {
     std::vector <struct pal_device>::iterator dIter;
@@ -587,6 +592,45 @@ exit:
     return status;
 }
 
+/* called with mStreamMutex held, see PAL_PARAM_ID_UIEFFECT_BATCH */
+int32_t Stream::setUIEffectBatch(pal_param_payload *batch)
+{
+    int32_t status = 0;
+    uint32_t offset = 0, recordSize = 0;
+    pal_param_payload *record = NULL;
+    effect_pal_payload_t *effectPalPayload = nullptr;
+
+    if (!batch || !session) {
+        PAL_ERR(LOG_TAG, "invalid batch or session");
+        return -EINVAL;
+    }
+
+    while (offset < batch->payload_size) {
+        record = (pal_param_payload *)(batch->payload + offset);
+        if (batch->payload_size - offset < sizeof(pal_param_payload) ||
+            record->payload_size < sizeof(effect_pal_payload_t) ||
+            record->payload_size > batch->payload_size - offset - sizeof(pal_param_payload)) {
+            PAL_ERR(LOG_TAG, "invalid effect record at offset %u", offset);
+            return -EINVAL;
+        }
+        effectPalPayload = (effect_pal_payload_t *)record->payload;
+        if (effectPalPayload->isTKV)
+            status = session->setTKV(this, MODULE, effectPalPayload);
+        else
+            status = session->setParameters(this, effectPalPayload->tag,
+                                            PAL_PARAM_ID_UIEFFECT, record);
+        if (status) {
+            PAL_ERR(LOG_TAG, "effect tag 0x%x at offset %u failed with %d",
+                    effectPalPayload->tag, offset, status);
+            return status;
+        }
+        recordSize = sizeof(pal_param_payload) + ((record->payload_size + 3) & ~3U);
+        offset += recordSize;
+    }
+
+    return status;
+}
+
 int32_t Stream::getVolumeData(struct pal_volume_data *vData)
 {
     int32_t status = 0;
@@ -718,6 +718,9 @@ int32_t StreamCompress::setParameters(uint32_t param_id, void *payload)
             }
             break;
         }
+        case PAL_PARAM_ID_UIEFFECT_BATCH:
+            status = setUIEffectBatch((pal_param_payload *)payload);
+            break;
         case PAL_PARAM_ID_DEVICE_ROTATION:
         {
             // Call Session for Setting the parameter.
@@ -36,6 +36,7 @@
 #include "SessionAlsaPcm.h"
 #include "ResourceManager.h"
 #include "Device.h"
+#include "PalTrace.h"
 #include <unistd.h>
 #include <chrono>
 
@@ -626,6 +627,7 @@ exit:
 int32_t StreamPCM::stop()
 {
     int32_t status = 0;
+    std::unique_lock<std::mutex> ioLock(mStreamIOMutex, std::defer_lock);
 
     mStreamMutex.lock();
     PAL_DBG(LOG_TAG, "Enter. session handle - %pK mStreamAttr->direction - %d state %d",
@@ -636,10 +638,13 @@ int32_t StreamPCM::stop()
         rm->lockActiveStream();
         mStreamMutex.lock();
         currentState = STREAM_STOPPED;
+        mIoCmds.store(0, std::memory_order_relaxed);
         for (int i = 0; i < mDevices.size(); i++) {
             rm->deregisterDevice(mDevices[i], this);
         }
         rm->unlockActiveStream();
+        /* session stop resets the data path, let an in-flight buffer finish */
+        ioLock.lock();
         switch (mStreamAttr->direction) {
         case PAL_AUDIO_OUTPUT:
             PAL_VERBOSE(LOG_TAG, "In PAL_AUDIO_OUTPUT case, device count - %zu",
@@ -884,18 +889,22 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
             PAL_ERR(LOG_TAG, "stream_size= %d, srate = %d",
                     streamSize, sampleRate);
             status =  -EINVAL;
-            goto exit;
+            goto exit_unlock;
         }
         size = buf->size;
         memset(buf->buffer, 0, size);
         usleep((uint64_t)size * 1000000 / streamSize / sampleRate);
         PAL_DBG(LOG_TAG, "Sound card offline, dropped buffer size - %d", size);
         status = size;
-        goto exit;
+        goto exit_unlock;
     }
 
     if (currentState == STREAM_STARTED) {
+        std::unique_lock<std::mutex> ioLock(mStreamIOMutex);
+
+        mStreamMutex.unlock();
         status = session->read(this, SHMEM_ENDPOINT, buf, &size);
+        ioLock.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session read is failed with status %d", status);
             if (errno == -ENETRESET &&
@@ -918,13 +927,13 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
     } else {
         PAL_ERR(LOG_TAG, "Stream not started yet, state %d", currentState);
         status = -EINVAL;
-        goto exit;
+        goto exit_unlock;
     }
-    mStreamMutex.unlock();
     PAL_VERBOSE(LOG_TAG, "Exit. session read successful size - %d", size);
     return size;
-exit :
+exit_unlock:
     mStreamMutex.unlock();
+exit :
     PAL_DBG(LOG_TAG, "Exit. session read failed status %d", status);
     return status;
 }
@@ -960,6 +969,7 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
         size = buf->size;
         usleep((uint64_t)size * 1000000 / frameSize / sampleRate);
         PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
+        PAL_TRACE("dropped buffer size %d state %d", size, cachedState);
         mStreamMutex.unlock();
         PAL_VERBOSE(LOG_TAG, "Exit size: %d", size);
         return size;
@@ -968,8 +978,11 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
     // we should allow writes to go through in Start/Pause state as well.
     if ((currentState == STREAM_STARTED) ||
         (currentState == STREAM_PAUSED) ) {
-        status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        std::unique_lock<std::mutex> ioLock(mStreamIOMutex);
+
         mStreamMutex.unlock();
+        status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        ioLock.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session write is failed with status %d", status);
 
@@ -990,17 +1003,11 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
             } else {
                 goto exit;
             }
-        } else if (currentState == STREAM_PAUSED && !isPaused) {
-            rm->lockActiveStream();
-            mStreamMutex.lock();
-            for (int i = 0; i < mDevices.size(); i++) {
-                rm->registerDevice(mDevices[i], this);
-            }
-            mStreamMutex.unlock();
-            rm->unlockActiveStream();
-            currentState = STREAM_STARTED;
+        } else if (mIoCmds.load(std::memory_order_acquire)) {
+            handleIoCmds();
         }
         PAL_VERBOSE(LOG_TAG, "Exit. session write successful size - %d", size);
+        PAL_TRACE("session %p wrote %d", session, size);
         return size;
     } else {
         PAL_ERR(LOG_TAG, "Stream not started yet, state %d", currentState);
@@ -1018,6 +1025,25 @@ exit:
     return status;
 }
 
+/* runs on the writer once a buffer went through, without mStreamIOMutex */
+void StreamPCM::handleIoCmds()
+{
+    uint32_t cmds = 0;
+
+    rm->lockActiveStream();
+    mStreamMutex.lock();
+    cmds = mIoCmds.exchange(0, std::memory_order_acq_rel);
+    /* pause or stop may have come in since the command was posted */
+    if ((cmds & PCM_IO_CMD_RESUME) && currentState == STREAM_PAUSED && !isPaused) {
+        for (int i = 0; i < mDevices.size(); i++) {
+            rm->registerDevice(mDevices[i], this);
+        }
+        currentState = STREAM_STARTED;
+    }
+    mStreamMutex.unlock();
+    rm->unlockActiveStream();
+}
+
 int32_t  StreamPCM::registerCallBack(pal_stream_callback /*cb*/, uint64_t /*cookie*/)
 {
     return 0;
@@ -1072,6 +1098,9 @@ int32_t  StreamPCM::setParameters(uint32_t param_id, void *payload)
             }
             break;
         }
+        case PAL_PARAM_ID_UIEFFECT_BATCH:
+            status = setUIEffectBatch((pal_param_payload *)payload);
+            break;
         case PAL_PARAM_ID_TTY_MODE:
         {
             param_payload = (pal_param_payload *)payload;
@@ -1205,6 +1234,7 @@ int32_t StreamPCM::pause_l()
             usleep(VOLUME_RAMP_PERIOD);
         isPaused = true;
         currentState = STREAM_PAUSED;
+        mIoCmds.fetch_and(~PCM_IO_CMD_RESUME, std::memory_order_relaxed);
         PAL_DBG(LOG_TAG, "session setConfig successful");
     }
 exit:
@@ -1241,6 +1271,8 @@ int32_t StreamPCM::resume_l()
     }
 
     isPaused = false;
+    if (currentState == STREAM_PAUSED)
+        mIoCmds.fetch_or(PCM_IO_CMD_RESUME, std::memory_order_release);
     PAL_DBG(LOG_TAG, "session setConfig successful");
 exit:
     PAL_DBG(LOG_TAG, "Exit status: %d", status);
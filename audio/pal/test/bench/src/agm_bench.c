@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Times the AGM session API on the synthetic platform: session open to
+ * start, the cost of every write and read, and moving a started session
+ * between backends. AGM runs against the GSL and tinyalsa stand-ins, see
+ * fake_gsl.c and fake_tinyalsa.c, so the numbers are AGM's own cost.
+ */
+
+#include "bench_common.h"
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <agm/agm_api.h>
+
+#define BENCH_RATE 48000
+#define BENCH_CHANNELS 2
+#define BENCH_BIT_WIDTH 16
+#define BENCH_SESSION_RX 1
+#define BENCH_SESSION_TX 2
+
+/* keys and values from configs/etc/usecaseKvManager.xml */
+static uint32_t stream_rx_metadata[] = {
+    2,                                          /* GKVs */
+    0xA1000000, 0xA100000E,                     /* STREAMRX PCM_LL_PLAYBACK */
+    0xAB000000, 0x1,                            /* INSTANCE 1 */
+    2,                                          /* CKVs */
+    0xA5000000, BENCH_RATE, 0xA6000000, BENCH_BIT_WIDTH,
+    0, 0,                                       /* no properties */
+};
+
+static uint32_t stream_tx_metadata[] = {
+    1,
+    0xB1000000, 0xB1000009,                     /* STREAMTX RAW_RECORD */
+    2,
+    0xA5000000, BENCH_RATE, 0xA6000000, BENCH_BIT_WIDTH,
+    0, 0,
+};
+
+static uint32_t speaker_metadata[] = {
+    1,
+    0xA2000000, 0xA2000001,                     /* DEVICERX SPEAKER */
+    2,
+    0xA5000000, BENCH_RATE, 0xA6000000, BENCH_BIT_WIDTH,
+    0, 0,
+};
+
+static uint32_t handset_metadata[] = {
+    1,
+    0xA2000000, 0xA2000004,                     /* DEVICERX HANDSET */
+    2,
+    0xA5000000, BENCH_RATE, 0xA6000000, BENCH_BIT_WIDTH,
+    0, 0,
+};
+
+static uint32_t handset_mic_metadata[] = {
+    1,
+    0xA3000000, 0xA3000004,                     /* DEVICETX HANDSETMIC */
+    2,
+    0xA5000000, BENCH_RATE, 0xA6000000, BENCH_BIT_WIDTH,
+    0, 0,
+};
+
+struct bench_config {
+    unsigned int iterations;
+    unsigned int buffers;
+    unsigned int switches;
+    size_t buffer_size;
+};
+
+struct bench_results {
+    struct bench_stat open;
+    struct bench_stat start;
+    struct bench_stat write;
+    struct bench_stat device_switch;
+    struct bench_stat stop_close;
+    struct bench_stat capture_open;
+    struct bench_stat read;
+    struct bench_stat capture_stop_close;
+};
+
+static struct agm_media_config media_config = {
+    BENCH_RATE, BENCH_CHANNELS, AGM_FORMAT_PCM_S16_LE, 0,
+};
+
+static int setup_aif(uint32_t session_id, uint32_t aif_id, uint32_t *metadata,
+                     size_t size)
+{
+    int ret;
+
+    ret = agm_aif_set_media_config(aif_id, &media_config);
+    if (!ret)
+        ret = agm_aif_set_metadata(aif_id, size, (uint8_t *)metadata);
+    if (!ret)
+        ret = agm_session_aif_set_metadata(session_id, aif_id, size, (uint8_t *)metadata);
+    if (ret)
+        fprintf(stderr, "aif %u setup failed %d\n", aif_id, ret);
+
+    return ret;
+}
+
+/* connect, open, configure, prepare and start, open is timed up to prepare */
+static int open_session(const struct bench_config *cfg, uint32_t session_id,
+                        enum direction dir, uint32_t aif_id, uint64_t *handle,
+                        struct bench_stat *open, struct bench_stat *start)
+{
+    struct agm_session_config sess_config;
+    struct agm_buffer_config buf_config;
+    uint64_t t;
+    int ret;
+
+    memset(&sess_config, 0, sizeof(sess_config));
+    sess_config.dir = dir;
+    sess_config.sess_mode = AGM_SESSION_DEFAULT;
+    sess_config.data_mode = AGM_DATA_BLOCKING;
+    buf_config.count = 4;
+    buf_config.size = cfg->buffer_size;
+    buf_config.max_metadata_size = 0;
+
+    t = bench_now_ns();
+    ret = agm_session_aif_connect(session_id, aif_id, true);
+    if (ret) {
+        fprintf(stderr, "agm_session_aif_connect failed %d\n", ret);
+        return ret;
+    }
+    ret = agm_session_open(session_id, AGM_SESSION_DEFAULT, handle);
+    if (ret) {
+        fprintf(stderr, "agm_session_open failed %d\n", ret);
+        goto disconnect;
+    }
+    ret = agm_session_set_config(*handle, &sess_config, &media_config, &buf_config);
+    if (!ret)
+        ret = agm_session_prepare(*handle);
+    bench_stat_add(open, bench_now_ns() - t);
+    if (ret) {
+        fprintf(stderr, "agm session config/prepare failed %d\n", ret);
+        goto close;
+    }
+
+    if (start) {
+        t = bench_now_ns();
+        ret = agm_session_start(*handle);
+        bench_stat_add(start, bench_now_ns() - t);
+    } else {
+        ret = agm_session_start(*handle);
+    }
+    if (ret) {
+        fprintf(stderr, "agm_session_start failed %d\n", ret);
+        goto close;
+    }
+
+    return 0;
+
+close:
+    agm_session_close(*handle);
+disconnect:
+    agm_session_aif_connect(session_id, aif_id, false);
+    return ret;
+}
+
+static void close_session(uint32_t session_id, uint32_t aif_id, uint64_t handle,
+                          struct bench_stat *stat)
+{
+    uint64_t t = bench_now_ns();
+
+    agm_session_stop(handle);
+    agm_session_close(handle);
+    agm_session_aif_connect(session_id, aif_id, false);
+    bench_stat_add(stat, bench_now_ns() - t);
+}
+
+static int run_playback(const struct bench_config *cfg, struct bench_results *res,
+                        uint8_t *data)
+{
+    uint32_t aif_id = BENCH_AIF_SPEAKER_RX, next;
+    uint64_t handle = 0;
+    uint64_t t;
+    unsigned int i;
+    size_t size;
+    int ret;
+
+    ret = open_session(cfg, BENCH_SESSION_RX, RX, aif_id, &handle, &res->open, &res->start);
+    if (ret)
+        return ret;
+
+    for (i = 0; i < cfg->buffers; i++) {
+        size = cfg->buffer_size;
+        t = bench_now_ns();
+        ret = agm_session_write(handle, data, &size);
+        bench_stat_add(&res->write, bench_now_ns() - t);
+        if (ret) {
+            fprintf(stderr, "agm_session_write failed %d\n", ret);
+            goto close;
+        }
+    }
+
+    /* what PAL does for a device switch of a started stream */
+    for (i = 0; i < cfg->switches; i++) {
+        next = aif_id == BENCH_AIF_SPEAKER_RX ? BENCH_AIF_HANDSET_RX : BENCH_AIF_SPEAKER_RX;
+        t = bench_now_ns();
+        ret = agm_session_aif_connect(BENCH_SESSION_RX, aif_id, false);
+        if (!ret)
+            ret = agm_session_aif_connect(BENCH_SESSION_RX, next, true);
+        bench_stat_add(&res->device_switch, bench_now_ns() - t);
+        if (ret) {
+            fprintf(stderr, "device switch to aif %u failed %d\n", next, ret);
+            goto close;
+        }
+        aif_id = next;
+    }
+
+close:
+    close_session(BENCH_SESSION_RX, aif_id, handle, &res->stop_close);
+    return ret;
+}
+
+static int run_capture(const struct bench_config *cfg, struct bench_results *res,
+                       uint8_t *data)
+{
+    uint64_t handle = 0;
+    uint64_t t;
+    unsigned int i;
+    size_t size;
+    int ret;
+
+    ret = open_session(cfg, BENCH_SESSION_TX, TX, BENCH_AIF_HANDSET_TX, &handle,
+                       &res->capture_open, NULL);
+    if (ret)
+        return ret;
+
+    for (i = 0; i < cfg->buffers; i++) {
+        size = cfg->buffer_size;
+        t = bench_now_ns();
+        ret = agm_session_read(handle, data, &size);
+        bench_stat_add(&res->read, bench_now_ns() - t);
+        if (ret) {
+            fprintf(stderr, "agm_session_read failed %d\n", ret);
+            break;
+        }
+    }
+
+    close_session(BENCH_SESSION_TX, BENCH_AIF_HANDSET_TX, handle, &res->capture_stop_close);
+    return ret;
+}
+
+static void usage(const char *prog)
+{
+    printf("usage: %s [-n iterations] [-b buffers] [-s switches] [-m ms]\n"
+           "  -n  open/start/stop/close cycles, default 20\n"
+           "  -b  buffers written and read per cycle, default 200\n"
+           "  -s  device switches per cycle, default 4\n"
+           "  -m  buffer duration in ms, default 5\n",
+           prog);
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_config cfg = {
+        .iterations = 20,
+        .buffers = 200,
+        .switches = 4,
+    };
+    struct bench_results res;
+    struct bench_stat init;
+    struct bench_stat *stats;
+    unsigned int ms = 5;
+    unsigned int i;
+    uint8_t *data;
+    uint64_t t;
+    int opt, ret = 0;
+
+    while ((opt = getopt(argc, argv, "n:b:s:m:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            cfg.iterations = atoi(optarg);
+            break;
+        case 'b':
+            cfg.buffers = atoi(optarg);
+            break;
+        case 's':
+            cfg.switches = atoi(optarg);
+            break;
+        case 'm':
+            ms = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : -EINVAL;
+        }
+    }
+    cfg.buffer_size = BENCH_RATE / 1000 * ms * BENCH_CHANNELS * BENCH_BIT_WIDTH / 8;
+
+    data = (uint8_t *)calloc(1, cfg.buffer_size);
+    if (!data)
+        return -ENOMEM;
+
+    stats = (struct bench_stat *)&res;
+    bench_stat_init(&res.open, "session open+prepare", cfg.iterations);
+    bench_stat_init(&res.start, "session start", cfg.iterations);
+    bench_stat_init(&res.write, "session write", cfg.iterations * cfg.buffers);
+    bench_stat_init(&res.device_switch, "aif switch", cfg.iterations * cfg.switches);
+    bench_stat_init(&res.stop_close, "session stop+close", cfg.iterations);
+    bench_stat_init(&res.capture_open, "capture open+prepare", cfg.iterations);
+    bench_stat_init(&res.read, "session read", cfg.iterations * cfg.buffers);
+    bench_stat_init(&res.capture_stop_close, "capture stop+close", cfg.iterations);
+    bench_stat_init(&init, "agm_init", 1);
+
+    printf("config root %s, %zu byte buffers\n", bench_root(), cfg.buffer_size);
+
+    t = bench_now_ns();
+    ret = agm_init();
+    bench_stat_add(&init, bench_now_ns() - t);
+    if (ret) {
+        fprintf(stderr, "agm_init failed %d\n", ret);
+        goto done;
+    }
+
+    ret = setup_aif(BENCH_SESSION_RX, BENCH_AIF_SPEAKER_RX, speaker_metadata,
+                    sizeof(speaker_metadata));
+    if (!ret)
+        ret = setup_aif(BENCH_SESSION_RX, BENCH_AIF_HANDSET_RX, handset_metadata,
+                        sizeof(handset_metadata));
+    if (!ret)
+        ret = setup_aif(BENCH_SESSION_TX, BENCH_AIF_HANDSET_TX, handset_mic_metadata,
+                        sizeof(handset_mic_metadata));
+    if (!ret)
+        ret = agm_session_set_metadata(BENCH_SESSION_RX, sizeof(stream_rx_metadata),
+                                       (uint8_t *)stream_rx_metadata);
+    if (!ret)
+        ret = agm_session_set_metadata(BENCH_SESSION_TX, sizeof(stream_tx_metadata),
+                                       (uint8_t *)stream_tx_metadata);
+
+    for (i = 0; i < cfg.iterations && !ret; i++) {
+        ret = run_playback(&cfg, &res, data);
+        if (!ret)
+            ret = run_capture(&cfg, &res, data);
+    }
+    agm_deinit();
+
+    bench_stat_print(&init);
+    for (i = 0; i < sizeof(res) / sizeof(struct bench_stat); i++)
+        bench_stat_print(&stats[i]);
+
+done:
+    for (i = 0; i < sizeof(res) / sizeof(struct bench_stat); i++)
+        bench_stat_deinit(&stats[i]);
+    bench_stat_deinit(&init);
+    free(data);
+
+    return ret;
+}
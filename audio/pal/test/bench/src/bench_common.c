@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/* open and fopen below are the plain symbols, also define the 64 bit ones */
+#undef _FILE_OFFSET_BITS
+#define _GNU_SOURCE
+#include "bench_common.h"
+#include <dirent.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <kvh2xml.h>
+
+#ifndef BENCH_CONFIG_DIR
+#define BENCH_CONFIG_DIR "/usr/share/palbench/configs"
+#endif
+
+#define SND_CARD_STATE_NODE "/sys/kernel/snd_card/card_state"
+#define BENCH_MODULE_ID_BASE 0x07001000
+#define BENCH_MIID_BASE 0x4000
+
+struct bench_tag_module_entry {
+    uint32_t module_id;
+    uint32_t module_iid;
+};
+
+struct bench_tag_entry {
+    uint32_t tag_id;
+    uint32_t num_modules;
+    struct bench_tag_module_entry module_entry[1];
+};
+
+/* every tag PAL or AGM looks up, each mapped to one module */
+static const uint32_t bench_tags[] = {
+    STREAM_PCM_DECODER,
+    STREAM_PCM_ENCODER,
+    STREAM_PCM_CONVERTER,
+    STREAM_INPUT_MEDIA_FORMAT,
+    TAG_STREAM_PLACEHOLDER_DECODER,
+    TAG_STREAM_PLACEHOLDER_ENCODER,
+    RD_SHMEM_ENDPOINT,
+    WR_SHMEM_ENDPOINT,
+    STREAM_SPR,         /* also TAG_STREAM_SPR of AGM */
+    TAG_PAUSE,
+    TAG_STREAM_VOLUME,
+    TAG_STREAM_MFC_SR,
+    PER_STREAM_PER_DEVICE_MFC,
+    TAG_DEVICE_PP_MFC,
+    TAG_DEVICE_MFC_SR,
+    TAG_DEVICEPP_EC_MFC,
+    DEVICE_HW_ENDPOINT_RX,
+    DEVICE_HW_ENDPOINT_TX,
+};
+
+#define BENCH_NUM_TAGS (sizeof(bench_tags) / sizeof(bench_tags[0]))
+
+static pthread_once_t runtime_once = PTHREAD_ONCE_INIT;
+static char runtime_dir[64];
+static char card_state_path[PATH_MAX];
+
+static int (*real_open)(const char *, int, ...);
+static int (*real_open64)(const char *, int, ...);
+static FILE *(*real_fopen)(const char *, const char *);
+static FILE *(*real_fopen64)(const char *, const char *);
+static int (*real_access)(const char *, int);
+static DIR *(*real_opendir)(const char *);
+
+/* resolved on first use, libraries may open files before main */
+static void *real_sym(void **slot, const char *name)
+{
+    if (!*slot)
+        *slot = dlsym(RTLD_NEXT, name);
+    return *slot;
+}
+
+#define REAL(fn) ((__typeof__(real_##fn))real_sym((void **)&real_##fn, #fn))
+
+uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+const char *bench_root(void)
+{
+    const char *root = getenv("PAL_BENCH_ROOT");
+
+    return root ? root : BENCH_CONFIG_DIR;
+}
+
+static void runtime_cleanup(void)
+{
+    unlink(card_state_path);
+    rmdir(runtime_dir);
+}
+
+static void runtime_init(void)
+{
+    FILE *fp;
+
+    snprintf(runtime_dir, sizeof(runtime_dir), "/tmp/pal_bench.XXXXXX");
+    if (!mkdtemp(runtime_dir)) {
+        fprintf(stderr, "bench: cannot create runtime dir: %s\n", strerror(errno));
+        runtime_dir[0] = '\0';
+        return;
+    }
+    /* the card is online, PAL writes 2 into it when it goes down */
+    snprintf(card_state_path, sizeof(card_state_path), "%s/card_state", runtime_dir);
+    fp = REAL(fopen)(card_state_path, "w");
+    if (fp) {
+        fputs("1\n", fp);
+        fclose(fp);
+    }
+    atexit(runtime_cleanup);
+}
+
+/*
+ * Map a path the audio stack reads to the synthetic tree, falls back to
+ * the real path when the tree has no such file.
+ */
+static const char *bench_path(const char *path, char *buf, size_t len)
+{
+    static const struct {
+        const char *prefix;
+        const char *dir;
+    } map[] = {
+        { "/vendor/etc/", "/etc/" },
+        { "/etc/", "/etc/" },
+        { "/proc/asound/", "/proc/asound/" },
+        { "/sys/devices/soc0/", "/sys/devices/soc0/" },
+    };
+    size_t i, n;
+
+    if (!path)
+        return path;
+
+    if (!strcmp(path, SND_CARD_STATE_NODE)) {
+        pthread_once(&runtime_once, runtime_init);
+        return card_state_path[0] ? card_state_path : path;
+    }
+
+    for (i = 0; i < sizeof(map) / sizeof(map[0]); i++) {
+        n = strlen(map[i].prefix);
+        if (strncmp(path, map[i].prefix, n))
+            continue;
+        snprintf(buf, len, "%s%s%s", bench_root(), map[i].dir, path + n);
+        if (!REAL(access)(buf, F_OK))
+            return buf;
+        break;
+    }
+
+    return path;
+}
+
+int open(const char *path, int flags, ...)
+{
+    char buf[PATH_MAX];
+    mode_t mode = 0;
+    va_list ap;
+
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+    return REAL(open)(bench_path(path, buf, sizeof(buf)), flags, mode);
+}
+
+int open64(const char *path, int flags, ...)
+{
+    char buf[PATH_MAX];
+    mode_t mode = 0;
+    va_list ap;
+
+    if (flags & (O_CREAT | O_TMPFILE)) {
+        va_start(ap, flags);
+        mode = va_arg(ap, mode_t);
+        va_end(ap);
+    }
+    return REAL(open64)(bench_path(path, buf, sizeof(buf)), flags, mode);
+}
+
+FILE *fopen(const char *path, const char *mode)
+{
+    char buf[PATH_MAX];
+
+    return REAL(fopen)(bench_path(path, buf, sizeof(buf)), mode);
+}
+
+FILE *fopen64(const char *path, const char *mode)
+{
+    char buf[PATH_MAX];
+
+    return REAL(fopen64)(bench_path(path, buf, sizeof(buf)), mode);
+}
+
+int access(const char *path, int mode)
+{
+    char buf[PATH_MAX];
+
+    return REAL(access)(bench_path(path, buf, sizeof(buf)), mode);
+}
+
+DIR *opendir(const char *path)
+{
+    char buf[PATH_MAX];
+
+    return REAL(opendir)(bench_path(path, buf, sizeof(buf)));
+}
+
+int bench_stat_init(struct bench_stat *stat, const char *name, size_t max_count)
+{
+    stat->name = name;
+    stat->count = 0;
+    stat->max_count = max_count;
+    stat->samples = (uint64_t *)calloc(max_count, sizeof(uint64_t));
+
+    return stat->samples ? 0 : -ENOMEM;
+}
+
+void bench_stat_add(struct bench_stat *stat, uint64_t ns)
+{
+    if (stat->count < stat->max_count)
+        stat->samples[stat->count++] = ns;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+void bench_stat_print(struct bench_stat *stat)
+{
+    uint64_t sum = 0;
+    size_t i;
+
+    if (!stat->count) {
+        printf("%-28s %8s\n", stat->name, "no samples");
+        return;
+    }
+
+    qsort(stat->samples, stat->count, sizeof(uint64_t), cmp_u64);
+    for (i = 0; i < stat->count; i++)
+        sum += stat->samples[i];
+
+    printf("%-28s n=%-6zu min %9.1f avg %9.1f p50 %9.1f p99 %9.1f max %9.1f us\n",
+           stat->name, stat->count,
+           stat->samples[0] / 1000.0,
+           (double)sum / stat->count / 1000.0,
+           stat->samples[stat->count / 2] / 1000.0,
+           stat->samples[(stat->count * 99) / 100] / 1000.0,
+           stat->samples[stat->count - 1] / 1000.0);
+}
+
+void bench_stat_deinit(struct bench_stat *stat)
+{
+    free(stat->samples);
+    stat->samples = NULL;
+    stat->count = 0;
+}
+
+int bench_tags_fill(void *buf, size_t *size)
+{
+    size_t needed = sizeof(uint32_t) + BENCH_NUM_TAGS * sizeof(struct bench_tag_entry);
+    struct bench_tag_entry *entry;
+    size_t i;
+
+    if (!buf || *size < needed) {
+        *size = needed;
+        return -ENOSPC;
+    }
+
+    *(uint32_t *)buf = BENCH_NUM_TAGS;
+    entry = (struct bench_tag_entry *)((uint32_t *)buf + 1);
+    for (i = 0; i < BENCH_NUM_TAGS; i++, entry++) {
+        entry->tag_id = bench_tags[i];
+        entry->num_modules = 1;
+        entry->module_entry[0].module_id = BENCH_MODULE_ID_BASE + i;
+        entry->module_entry[0].module_iid = BENCH_MIID_BASE + i;
+    }
+    *size = needed;
+
+    return needed;
+}
+
+int bench_tag_lookup(uint32_t tag, uint32_t *module_id, uint32_t *miid)
+{
+    size_t i;
+
+    for (i = 0; i < BENCH_NUM_TAGS; i++) {
+        if (bench_tags[i] != tag)
+            continue;
+        *module_id = BENCH_MODULE_ID_BASE + i;
+        *miid = BENCH_MIID_BASE + i;
+        return 0;
+    }
+
+    return -ENOENT;
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef BENCH_COMMON_H
+#define BENCH_COMMON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* sound card of the synthetic platform, gives the "holi_bench" config extension */
+#define BENCH_SND_CARD_NAME "holi-bench-snd-card"
+#define BENCH_SND_CARD_HW 0
+/* codec controls used by configs/etc/mixer_paths_holi_bench.xml */
+#define BENCH_CODEC_CTLS { "RX_MACRO RX0 Switch", "RX_MACRO RX1 Switch", "TX DEC0 Switch" }
+
+/* backend ids in configs/proc/asound/pcm */
+#define BENCH_AIF_HANDSET_RX 0
+#define BENCH_AIF_SPEAKER_RX 1
+#define BENCH_AIF_HANDSET_TX 2
+
+struct bench_stat {
+    const char *name;
+    uint64_t *samples;
+    size_t count;
+    size_t max_count;
+};
+
+uint64_t bench_now_ns(void);
+
+/*
+ * Config files, proc and sysfs nodes the stacks read are served from
+ * $PAL_BENCH_ROOT (BENCH_CONFIG_DIR by default), the card state node
+ * from a private runtime directory.
+ */
+const char *bench_root(void);
+
+int bench_stat_init(struct bench_stat *stat, const char *name, size_t max_count);
+void bench_stat_add(struct bench_stat *stat, uint64_t ns);
+/* one line of min/avg/p50/p99/max in microseconds */
+void bench_stat_print(struct bench_stat *stat);
+void bench_stat_deinit(struct bench_stat *stat);
+
+/*
+ * Fill buf with the tag to module table of every graph, in the layout of
+ * struct gsl_tag_module_info. Returns the table size, or -ENOSPC and the
+ * needed size in *size when buf is too small.
+ */
+int bench_tags_fill(void *buf, size_t *size);
+/* module of tag in the table, -ENOENT if the tag is unknown */
+int bench_tag_lookup(uint32_t tag, uint32_t *module_id, uint32_t *miid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //BENCH_COMMON_H
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * GSL and ATS stand-in for the benchmark. Linked into the executable, it
+ * takes the place of libar-gsl and libats for AGM. Graphs are handles to
+ * a shared memory sized scratch buffer, every command succeeds and the
+ * tag queries are answered from the table of bench_tags_fill(), so AGM
+ * runs its whole graph setup without a DSP.
+ */
+
+#include "bench_common.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gsl_intf.h>
+#include <ar_osal_error.h>
+
+#define BENCH_SHMEM_SIZE (64 * 1024)
+
+struct bench_graph {
+    gsl_cb_func_ptr cb;
+    void *client_data;
+    uint8_t shmem[BENCH_SHMEM_SIZE];
+};
+
+int32_t ats_init(void)
+{
+    return AR_EOK;
+}
+
+int32_t ats_deinit(void)
+{
+    return AR_EOK;
+}
+
+int32_t gsl_init(struct gsl_init_data *init_data)
+{
+    (void)init_data;
+    return AR_EOK;
+}
+
+void gsl_deinit(void)
+{
+}
+
+int32_t gsl_open(const struct gsl_key_vector *graph_key_vect,
+                 const struct gsl_key_vector *cal_key_vect,
+                 gsl_handle_t *graph_handle)
+{
+    struct bench_graph *graph;
+
+    (void)graph_key_vect;
+    (void)cal_key_vect;
+    graph = (struct bench_graph *)calloc(1, sizeof(*graph));
+    if (!graph)
+        return AR_ENOMEMORY;
+    *graph_handle = (gsl_handle_t)graph;
+
+    return AR_EOK;
+}
+
+int32_t gsl_close(gsl_handle_t graph_handle)
+{
+    free(graph_handle);
+    return AR_EOK;
+}
+
+int32_t gsl_register_event_cb(gsl_handle_t graph_handle, gsl_cb_func_ptr cb,
+                              void *client_data)
+{
+    struct bench_graph *graph = (struct bench_graph *)graph_handle;
+
+    graph->cb = cb;
+    graph->client_data = client_data;
+
+    return AR_EOK;
+}
+
+int32_t gsl_ioctl(gsl_handle_t graph_handle, enum gsl_cmd_id cmd_id,
+                  void *cmd_payload, size_t cmd_payload_sz)
+{
+    (void)graph_handle;
+    (void)cmd_id;
+    (void)cmd_payload;
+    (void)cmd_payload_sz;
+    return AR_EOK;
+}
+
+int32_t gsl_set_cal(gsl_handle_t graph_handle,
+                    const struct gsl_key_vector *graph_key_vect,
+                    const struct gsl_key_vector *cal_key_vect)
+{
+    (void)graph_handle;
+    (void)graph_key_vect;
+    (void)cal_key_vect;
+    return AR_EOK;
+}
+
+int32_t gsl_set_config(gsl_handle_t graph_handle,
+                       const struct gsl_key_vector *graph_key_vect,
+                       uint32_t tag, const struct gsl_key_vector *tag_key_vect)
+{
+    (void)graph_handle;
+    (void)graph_key_vect;
+    (void)tag;
+    (void)tag_key_vect;
+    return AR_EOK;
+}
+
+/* the copy is what the DSP client would do with the payload */
+int32_t gsl_set_custom_config(gsl_handle_t graph_handle, const uint8_t *payload,
+                              const uint32_t payload_size)
+{
+    struct bench_graph *graph = (struct bench_graph *)graph_handle;
+
+    memcpy(graph->shmem, payload,
+           payload_size < BENCH_SHMEM_SIZE ? payload_size : BENCH_SHMEM_SIZE);
+
+    return AR_EOK;
+}
+
+int32_t gsl_get_custom_config(gsl_handle_t graph_handle, uint8_t *payload,
+                              uint32_t payload_size)
+{
+    (void)graph_handle;
+    (void)payload;
+    (void)payload_size;
+    return AR_EOK;
+}
+
+/* leaves the caller sized payload as it is, every parameter reads as 0 */
+int32_t gsl_get_tagged_data(struct gsl_key_vector *key_vect, uint32_t tag,
+                            struct gsl_key_vector *tag_key_vect, uint8_t *payload,
+                            size_t *payload_size)
+{
+    (void)key_vect;
+    (void)tag;
+    (void)tag_key_vect;
+    (void)payload;
+    (void)payload_size;
+    return AR_EOK;
+}
+
+int32_t gsl_get_tags_with_module_info(const struct gsl_key_vector *key_vect,
+                                      void *tag_module_info,
+                                      size_t *tag_module_info_size)
+{
+    size_t size = tag_module_info ? *tag_module_info_size : 0;
+
+    (void)key_vect;
+    if (bench_tags_fill(tag_module_info, &size) < 0) {
+        *tag_module_info_size = size;
+        /* a NULL buffer only asks for the size */
+        return tag_module_info ? AR_ENEEDMORE : AR_EOK;
+    }
+    *tag_module_info_size = size;
+
+    return AR_EOK;
+}
+
+int32_t gsl_get_tagged_module_info(const struct gsl_key_vector *key_vect, uint32_t tag,
+                                   struct gsl_module_id_info **module_info,
+                                   uint32_t *module_info_size)
+{
+    struct gsl_module_id_info *info;
+    uint32_t module_id, miid;
+
+    (void)key_vect;
+    if (bench_tag_lookup(tag, &module_id, &miid))
+        return AR_ENOTEXIST;
+
+    *module_info_size = sizeof(*info) + sizeof(struct gsl_module_id_info_entry);
+    info = (struct gsl_module_id_info *)calloc(1, *module_info_size);
+    if (!info)
+        return AR_ENOMEMORY;
+    info->num_modules = 1;
+    info->module_entry[0].module_id = module_id;
+    info->module_entry[0].module_iid = miid;
+    *module_info = info;
+
+    return AR_EOK;
+}
+
+int32_t gsl_get_graph_alias(const struct gsl_key_vector *graph_key_vect, char *alias,
+                            uint32_t *alias_len)
+{
+    (void)graph_key_vect;
+    snprintf(alias, *alias_len, "bench");
+    return AR_EOK;
+}
+
+int32_t gsl_write(gsl_handle_t graph_handle, uint32_t tag, struct gsl_buff *buff,
+                  uint32_t *consumed_size)
+{
+    struct bench_graph *graph = (struct bench_graph *)graph_handle;
+    uint32_t size = buff->size < BENCH_SHMEM_SIZE ? buff->size : BENCH_SHMEM_SIZE;
+
+    (void)tag;
+    memcpy(graph->shmem, buff->addr, size);
+    *consumed_size = size;
+
+    return AR_EOK;
+}
+
+int32_t gsl_read(gsl_handle_t graph_handle, uint32_t tag, struct gsl_buff *buff,
+                 uint32_t *filled_size)
+{
+    struct bench_graph *graph = (struct bench_graph *)graph_handle;
+    uint32_t size = buff->size < BENCH_SHMEM_SIZE ? buff->size : BENCH_SHMEM_SIZE;
+
+    (void)tag;
+    memcpy(buff->addr, graph->shmem, size);
+    *filled_size = size;
+
+    return AR_EOK;
+}
@@ -0,0 +1,690 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * tinyalsa stand-in for the benchmark. Linked into the executable, it
+ * takes the place of libtinyalsa for PAL, audio_route and AGM.
+ *
+ * Every card is a mixer whose controls are created on first lookup, so
+ * the control names of the virtual card need no list. A control keeps
+ * what was last written and reads it back, "<PCM> getTaggedInfo" reads
+ * the tag table of bench_tags_fill(). Writes to "agm batch write" are
+ * decoded and applied to the controls they name, as the AGM plugin does.
+ * PCMs are null devices that copy
+ * each buffer through a scratch buffer of the configured size and never
+ * block, the numbers are the software cost of the stacks alone.
+ */
+
+#define _GNU_SOURCE
+#include "bench_common.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <tinyalsa/asoundlib.h>
+
+#define BENCH_MAX_CARDS 128
+#define BENCH_CTL_NAME_LEN 128
+#define BENCH_CTL_MAX_VALUES 64
+#define BENCH_CTL_ARRAY_SIZE 4096
+#define BENCH_VIRT_CARD_NAME "holibenchvirtualsndcard"
+
+/* layout of agm_api.h, the benchmark does not build against AGM headers */
+#define BENCH_BATCH_CTL_NAME "agm batch write"
+#define BENCH_BATCH_ALIGN(x) (((x) + 3) & ~3)
+
+struct bench_batch_value {
+    uint32_t numid;
+    uint32_t length;
+};
+
+struct mixer_ctl {
+    struct mixer *mixer;
+    char name[BENCH_CTL_NAME_LEN];
+    enum mixer_ctl_type type;
+    unsigned int num_values;
+    int values[BENCH_CTL_MAX_VALUES];
+    char enum_value[BENCH_CTL_NAME_LEN];
+    uint8_t *array;
+    size_t array_size;
+    unsigned int id;
+    bool tagged_info;
+    bool batch;
+};
+
+/* one per card, opens share it and it outlives the last close */
+struct mixer {
+    unsigned int card;
+    char name[64];
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    unsigned int refs;
+    unsigned int close_seq;
+    struct mixer_ctl **ctls;
+    unsigned int num_ctls;
+    unsigned int max_ctls;
+};
+
+struct pcm {
+    unsigned int card;
+    unsigned int device;
+    unsigned int flags;
+    struct pcm_config config;
+    uint8_t *scratch;
+    unsigned int buffer_frames;
+    unsigned int frame_size;
+    unsigned int appl_ptr;
+    bool running;
+};
+
+static pthread_mutex_t cards_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct mixer *cards[BENCH_MAX_CARDS];
+
+static struct mixer_ctl *mixer_add_ctl(struct mixer *mixer, const char *name,
+                                       enum mixer_ctl_type type, unsigned int num_values)
+{
+    struct mixer_ctl **ctls;
+    struct mixer_ctl *ctl;
+
+    if (mixer->num_ctls == mixer->max_ctls) {
+        ctls = (struct mixer_ctl **)realloc(mixer->ctls,
+                (mixer->max_ctls + 64) * sizeof(*ctls));
+        if (!ctls)
+            return NULL;
+        mixer->ctls = ctls;
+        mixer->max_ctls += 64;
+    }
+    ctl = (struct mixer_ctl *)calloc(1, sizeof(*ctl));
+    if (!ctl)
+        return NULL;
+
+    ctl->mixer = mixer;
+    strncpy(ctl->name, name, sizeof(ctl->name) - 1);
+    ctl->type = type;
+    ctl->num_values = num_values;
+    ctl->id = mixer->num_ctls;
+    ctl->tagged_info = strstr(name, "getTaggedInfo") != NULL;
+    ctl->batch = !strcmp(name, BENCH_BATCH_CTL_NAME);
+    mixer->ctls[mixer->num_ctls++] = ctl;
+
+    return ctl;
+}
+
+struct mixer *mixer_open(unsigned int card)
+{
+    static const char * const codec_ctls[] = BENCH_CODEC_CTLS;
+    struct mixer *mixer;
+    size_t i;
+
+    if (card >= BENCH_MAX_CARDS)
+        return NULL;
+    /* the codec card and the virtual card of card-defs.xml */
+    if (card != BENCH_SND_CARD_HW && card != 100)
+        return NULL;
+
+    pthread_mutex_lock(&cards_lock);
+    mixer = cards[card];
+    if (!mixer) {
+        mixer = (struct mixer *)calloc(1, sizeof(*mixer));
+        if (!mixer) {
+            pthread_mutex_unlock(&cards_lock);
+            return NULL;
+        }
+        mixer->card = card;
+        snprintf(mixer->name, sizeof(mixer->name), "%s",
+                 card == BENCH_SND_CARD_HW ? BENCH_SND_CARD_NAME : BENCH_VIRT_CARD_NAME);
+        pthread_mutex_init(&mixer->lock, NULL);
+        pthread_cond_init(&mixer->cond, NULL);
+        /* audio_route only sees the controls that exist when it starts */
+        if (card == BENCH_SND_CARD_HW)
+            for (i = 0; i < sizeof(codec_ctls) / sizeof(codec_ctls[0]); i++)
+                mixer_add_ctl(mixer, codec_ctls[i], MIXER_CTL_TYPE_BOOL, 1);
+        cards[card] = mixer;
+    }
+    pthread_mutex_lock(&mixer->lock);
+    mixer->refs++;
+    pthread_mutex_unlock(&mixer->lock);
+    pthread_mutex_unlock(&cards_lock);
+
+    return mixer;
+}
+
+void mixer_close(struct mixer *mixer)
+{
+    if (!mixer)
+        return;
+
+    pthread_mutex_lock(&mixer->lock);
+    if (mixer->refs)
+        mixer->refs--;
+    /* wakes up event waiters, PAL closes the mixer to stop its event thread */
+    mixer->close_seq++;
+    pthread_cond_broadcast(&mixer->cond);
+    pthread_mutex_unlock(&mixer->lock);
+}
+
+const char *mixer_get_name(struct mixer *mixer)
+{
+    return mixer->name;
+}
+
+unsigned int mixer_get_num_ctls(struct mixer *mixer)
+{
+    unsigned int num;
+
+    pthread_mutex_lock(&mixer->lock);
+    num = mixer->num_ctls;
+    pthread_mutex_unlock(&mixer->lock);
+
+    return num;
+}
+
+struct mixer_ctl *mixer_get_ctl(struct mixer *mixer, unsigned int id)
+{
+    struct mixer_ctl *ctl = NULL;
+
+    pthread_mutex_lock(&mixer->lock);
+    if (id < mixer->num_ctls)
+        ctl = mixer->ctls[id];
+    pthread_mutex_unlock(&mixer->lock);
+
+    return ctl;
+}
+
+struct mixer_ctl *mixer_get_ctl_by_name(struct mixer *mixer, const char *name)
+{
+    struct mixer_ctl *ctl = NULL;
+    unsigned int i;
+
+    if (!mixer || !name)
+        return NULL;
+
+    pthread_mutex_lock(&mixer->lock);
+    for (i = 0; i < mixer->num_ctls; i++) {
+        if (!strcmp(mixer->ctls[i]->name, name)) {
+            ctl = mixer->ctls[i];
+            break;
+        }
+    }
+    /* codec controls are fixed, virtual card controls come into being */
+    if (!ctl && mixer->card != BENCH_SND_CARD_HW)
+        ctl = mixer_add_ctl(mixer, name, MIXER_CTL_TYPE_BYTE, BENCH_CTL_ARRAY_SIZE);
+    pthread_mutex_unlock(&mixer->lock);
+
+    return ctl;
+}
+
+int mixer_subscribe_events(struct mixer *mixer, int subscribe)
+{
+    (void)mixer;
+    (void)subscribe;
+    return 0;
+}
+
+/* no control ever raises an event, waits until the mixer is closed */
+int mixer_wait_event(struct mixer *mixer, int timeout)
+{
+    struct timespec ts;
+    unsigned int seq;
+
+    pthread_mutex_lock(&mixer->lock);
+    seq = mixer->close_seq;
+    if (timeout < 0) {
+        while (seq == mixer->close_seq)
+            pthread_cond_wait(&mixer->cond, &mixer->lock);
+    } else {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += timeout / 1000;
+        ts.tv_nsec += (timeout % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        while (seq == mixer->close_seq &&
+               pthread_cond_timedwait(&mixer->cond, &mixer->lock, &ts) != ETIMEDOUT)
+            ;
+    }
+    pthread_mutex_unlock(&mixer->lock);
+
+    return 0;
+}
+
+int mixer_read_event(struct mixer *mixer, struct ctl_event *ev)
+{
+    (void)mixer;
+    (void)ev;
+    return -EAGAIN;
+}
+
+/* the index in mixer->ctls, which is what batch records name */
+unsigned int mixer_ctl_get_id(const struct mixer_ctl *ctl)
+{
+    return ctl ? ctl->id : (unsigned int)-EINVAL;
+}
+
+const char *mixer_ctl_get_name(struct mixer_ctl *ctl)
+{
+    return ctl ? ctl->name : NULL;
+}
+
+enum mixer_ctl_type mixer_ctl_get_type(struct mixer_ctl *ctl)
+{
+    return ctl ? ctl->type : MIXER_CTL_TYPE_UNKNOWN;
+}
+
+const char *mixer_ctl_get_type_string(struct mixer_ctl *ctl)
+{
+    switch (mixer_ctl_get_type(ctl)) {
+    case MIXER_CTL_TYPE_BOOL: return "BOOL";
+    case MIXER_CTL_TYPE_INT: return "INT";
+    case MIXER_CTL_TYPE_ENUM: return "ENUM";
+    case MIXER_CTL_TYPE_BYTE: return "BYTE";
+    default: return "Unknown";
+    }
+}
+
+unsigned int mixer_ctl_get_num_values(struct mixer_ctl *ctl)
+{
+    return ctl ? ctl->num_values : 0;
+}
+
+unsigned int mixer_ctl_get_num_enums(struct mixer_ctl *ctl)
+{
+    return ctl && ctl->type == MIXER_CTL_TYPE_ENUM ? 1 : 0;
+}
+
+const char *mixer_ctl_get_enum_string(struct mixer_ctl *ctl, unsigned int enum_id)
+{
+    if (!ctl || ctl->type != MIXER_CTL_TYPE_ENUM || enum_id)
+        return NULL;
+    return ctl->enum_value;
+}
+
+void mixer_ctl_update(struct mixer_ctl *ctl)
+{
+    (void)ctl;
+}
+
+int mixer_ctl_is_access_tlv_rw(struct mixer_ctl *ctl)
+{
+    (void)ctl;
+    return 0;
+}
+
+int mixer_ctl_get_range_min(struct mixer_ctl *ctl)
+{
+    (void)ctl;
+    return 0;
+}
+
+int mixer_ctl_get_range_max(struct mixer_ctl *ctl)
+{
+    return ctl && ctl->type == MIXER_CTL_TYPE_BOOL ? 1 : 100;
+}
+
+int mixer_ctl_get_value(struct mixer_ctl *ctl, unsigned int id)
+{
+    int value = -EINVAL;
+
+    if (!ctl || id >= BENCH_CTL_MAX_VALUES)
+        return -EINVAL;
+
+    pthread_mutex_lock(&ctl->mixer->lock);
+    value = ctl->values[id];
+    pthread_mutex_unlock(&ctl->mixer->lock);
+
+    return value;
+}
+
+int mixer_ctl_set_value(struct mixer_ctl *ctl, unsigned int id, int value)
+{
+    if (!ctl || id >= BENCH_CTL_MAX_VALUES)
+        return -EINVAL;
+
+    pthread_mutex_lock(&ctl->mixer->lock);
+    if (ctl->type == MIXER_CTL_TYPE_BYTE) {
+        ctl->type = MIXER_CTL_TYPE_INT;
+        ctl->num_values = BENCH_CTL_MAX_VALUES;
+    }
+    ctl->values[id] = value;
+    pthread_mutex_unlock(&ctl->mixer->lock);
+
+    return 0;
+}
+
+int mixer_ctl_get_percent(struct mixer_ctl *ctl, unsigned int id)
+{
+    return mixer_ctl_get_value(ctl, id);
+}
+
+int mixer_ctl_set_percent(struct mixer_ctl *ctl, unsigned int id, int percent)
+{
+    return mixer_ctl_set_value(ctl, id, percent);
+}
+
+int mixer_ctl_get_array(struct mixer_ctl *ctl, void *array, size_t count)
+{
+    size_t size = count;
+    int ret = 0;
+
+    if (!ctl || !array)
+        return -EINVAL;
+
+    if (ctl->tagged_info) {
+        ret = bench_tags_fill(array, &size);
+        return ret < 0 ? ret : 0;
+    }
+
+    pthread_mutex_lock(&ctl->mixer->lock);
+    if (ctl->type == MIXER_CTL_TYPE_INT || ctl->type == MIXER_CTL_TYPE_BOOL) {
+        size = count < ctl->num_values ? count : ctl->num_values;
+        memcpy(array, ctl->values, size * sizeof(int));
+    } else {
+        size = count < ctl->array_size ? count : ctl->array_size;
+        memcpy(array, ctl->array, size);
+        memset((uint8_t *)array + size, 0, count - size);
+    }
+    pthread_mutex_unlock(&ctl->mixer->lock);
+
+    return 0;
+}
+
+static int ctl_set_array_locked(struct mixer_ctl *ctl, const void *array, size_t count)
+{
+    uint8_t *buf;
+
+    if (ctl->type == MIXER_CTL_TYPE_INT || ctl->type == MIXER_CTL_TYPE_BOOL) {
+        if (count > ctl->num_values)
+            count = ctl->num_values;
+        memcpy(ctl->values, array, count * sizeof(int));
+        return 0;
+    }
+    if (count > ctl->array_size) {
+        buf = (uint8_t *)realloc(ctl->array, count);
+        if (!buf)
+            return -ENOMEM;
+        ctl->array = buf;
+    }
+    /* the copy is what the kernel would do with the payload */
+    memcpy(ctl->array, array, count);
+    ctl->array_size = count;
+
+    return 0;
+}
+
+/*
+ * Applies each record of a batch to the control it names, enum controls
+ * take an item index and the only item is the current value. Runs on to
+ * the end and returns the first error, like the plugin.
+ */
+static int ctl_set_batch_locked(struct mixer *mixer, const uint8_t *data, size_t count)
+{
+    struct bench_batch_value rec;
+    struct mixer_ctl *ctl;
+    size_t off = 0;
+    uint32_t item;
+    int ret = 0, err;
+
+    while (off < count) {
+        if (count - off < sizeof(rec))
+            return ret ? ret : -EINVAL;
+        memcpy(&rec, data + off, sizeof(rec));
+        off += sizeof(rec);
+        if (rec.length > count - off || BENCH_BATCH_ALIGN(rec.length) > count - off)
+            return ret ? ret : -EINVAL;
+
+        err = -EINVAL;
+        ctl = rec.numid < mixer->num_ctls ? mixer->ctls[rec.numid] : NULL;
+        if (ctl && !ctl->batch && ctl->type == MIXER_CTL_TYPE_ENUM) {
+            if (rec.length == sizeof(item)) {
+                memcpy(&item, data + off, sizeof(item));
+                err = item ? -EINVAL : 0;
+            }
+        } else if (ctl && !ctl->batch) {
+            err = ctl_set_array_locked(ctl, data + off, rec.length);
+        }
+        if (err && !ret)
+            ret = err;
+        off += BENCH_BATCH_ALIGN(rec.length);
+    }
+
+    return ret;
+}
+
+int mixer_ctl_set_array(struct mixer_ctl *ctl, const void *array, size_t count)
+{
+    int ret;
+
+    if (!ctl || !array)
+        return -EINVAL;
+
+    pthread_mutex_lock(&ctl->mixer->lock);
+    if (ctl->batch)
+        ret = ctl_set_batch_locked(ctl->mixer, (const uint8_t *)array, count);
+    else
+        ret = ctl_set_array_locked(ctl, array, count);
+    pthread_mutex_unlock(&ctl->mixer->lock);
+
+    return ret;
+}
+
+int mixer_ctl_set_enum_by_string(struct mixer_ctl *ctl, const char *string)
+{
+    if (!ctl || !string)
+        return -EINVAL;
+
+    pthread_mutex_lock(&ctl->mixer->lock);
+    ctl->type = MIXER_CTL_TYPE_ENUM;
+    ctl->num_values = 1;
+    strncpy(ctl->enum_value, string, sizeof(ctl->enum_value) - 1);
+    pthread_mutex_unlock(&ctl->mixer->lock);
+
+    return 0;
+}
+
+unsigned int pcm_format_to_bits(enum pcm_format format)
+{
+    switch (format) {
+    case PCM_FORMAT_S32_LE:
+    case PCM_FORMAT_S24_LE:
+        return 32;
+    case PCM_FORMAT_S24_3LE:
+        return 24;
+    case PCM_FORMAT_S8:
+        return 8;
+    default:
+        return 16;
+    }
+}
+
+struct pcm *pcm_open(unsigned int card, unsigned int device, unsigned int flags,
+                     struct pcm_config *config)
+{
+    struct pcm *pcm;
+
+    pcm = (struct pcm *)calloc(1, sizeof(*pcm));
+    if (!pcm)
+        return NULL;
+
+    pcm->card = card;
+    pcm->device = device;
+    pcm->flags = flags;
+    if (config)
+        pcm->config = *config;
+    if (!pcm->config.channels)
+        pcm->config.channels = 2;
+    if (!pcm->config.period_size)
+        pcm->config.period_size = 960;
+    if (!pcm->config.period_count)
+        pcm->config.period_count = 2;
+    pcm->frame_size = pcm->config.channels * pcm_format_to_bits(pcm->config.format) / 8;
+    pcm->buffer_frames = pcm->config.period_size * pcm->config.period_count;
+    pcm->scratch = (uint8_t *)calloc(pcm->buffer_frames, pcm->frame_size);
+
+    return pcm;
+}
+
+int pcm_close(struct pcm *pcm)
+{
+    if (!pcm)
+        return -EINVAL;
+
+    free(pcm->scratch);
+    free(pcm);
+
+    return 0;
+}
+
+int pcm_is_ready(struct pcm *pcm)
+{
+    return pcm && pcm->scratch;
+}
+
+const char *pcm_get_error(struct pcm *pcm)
+{
+    (void)pcm;
+    return "";
+}
+
+unsigned int pcm_get_buffer_size(struct pcm *pcm)
+{
+    return pcm->buffer_frames;
+}
+
+unsigned int pcm_frames_to_bytes(struct pcm *pcm, unsigned int frames)
+{
+    return frames * pcm->frame_size;
+}
+
+unsigned int pcm_bytes_to_frames(struct pcm *pcm, unsigned int bytes)
+{
+    return bytes / pcm->frame_size;
+}
+
+int pcm_prepare(struct pcm *pcm)
+{
+    pcm->appl_ptr = 0;
+    return 0;
+}
+
+int pcm_start(struct pcm *pcm)
+{
+    pcm->running = true;
+    return 0;
+}
+
+int pcm_stop(struct pcm *pcm)
+{
+    pcm->running = false;
+    return 0;
+}
+
+/* copies through the scratch buffer, wrapping at its end */
+static void pcm_copy(struct pcm *pcm, uint8_t *dst, const uint8_t *src, unsigned int count)
+{
+    unsigned int size = pcm->buffer_frames * pcm->frame_size;
+    unsigned int off = (pcm->appl_ptr % pcm->buffer_frames) * pcm->frame_size;
+    unsigned int n;
+
+    while (count) {
+        n = size - off < count ? size - off : count;
+        if (src)
+            memcpy(pcm->scratch + off, src, n);
+        else
+            memcpy(dst, pcm->scratch + off, n);
+        src = src ? src + n : NULL;
+        dst = dst ? dst + n : NULL;
+        count -= n;
+        off = 0;
+    }
+}
+
+int pcm_write(struct pcm *pcm, const void *data, unsigned int count)
+{
+    if (!pcm || !data)
+        return -EINVAL;
+
+    pcm_copy(pcm, NULL, (const uint8_t *)data, count);
+    pcm->appl_ptr += count / pcm->frame_size;
+    pcm->running = true;
+
+    return 0;
+}
+
+int pcm_read(struct pcm *pcm, void *data, unsigned int count)
+{
+    if (!pcm || !data)
+        return -EINVAL;
+
+    pcm_copy(pcm, (uint8_t *)data, NULL, count);
+    pcm->appl_ptr += count / pcm->frame_size;
+    pcm->running = true;
+
+    return 0;
+}
+
+int pcm_mmap_write(struct pcm *pcm, const void *data, unsigned int count)
+{
+    return pcm_write(pcm, data, count);
+}
+
+int pcm_mmap_read(struct pcm *pcm, void *data, unsigned int count)
+{
+    return pcm_read(pcm, data, count);
+}
+
+int pcm_mmap_begin(struct pcm *pcm, void **areas, unsigned int *offset, unsigned int *frames)
+{
+    unsigned int off = pcm->appl_ptr % pcm->buffer_frames;
+
+    *areas = pcm->scratch;
+    *offset = off;
+    if (*frames > pcm->buffer_frames - off)
+        *frames = pcm->buffer_frames - off;
+
+    return 0;
+}
+
+int pcm_mmap_commit(struct pcm *pcm, unsigned int offset, unsigned int frames)
+{
+    (void)offset;
+    pcm->appl_ptr += frames;
+    return frames;
+}
+
+/* the null device consumes everything at once */
+int pcm_mmap_get_hw_ptr(struct pcm *pcm, unsigned int *hw_ptr, struct timespec *tstamp)
+{
+    *hw_ptr = pcm->appl_ptr;
+    if (tstamp)
+        clock_gettime(CLOCK_MONOTONIC, tstamp);
+    return 0;
+}
+
+int pcm_get_htimestamp(struct pcm *pcm, unsigned int *avail, struct timespec *tstamp)
+{
+    *avail = pcm->buffer_frames;
+    clock_gettime(CLOCK_MONOTONIC, tstamp);
+    return 0;
+}
+
+int pcm_ioctl(struct pcm *pcm, int request, ...)
+{
+    (void)request;
+    if (!pcm)
+        return -EINVAL;
+    pcm->appl_ptr = 0;
+    return 0;
+}
+
+int pcm_get_poll_fd(struct pcm *pcm)
+{
+    (void)pcm;
+    return -1;
+}
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Times the PAL API on the synthetic platform: stream open/start/stop/
+ * close, the cost of every write and read, and device switches between
+ * speaker and handset. PAL runs against the tinyalsa stand-in, see
+ * fake_tinyalsa.c, so the numbers are PAL's own cost.
+ */
+
+#include "bench_common.h"
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <PalApi.h>
+#include <PalDefs.h>
+
+#define BENCH_RATE 48000
+#define BENCH_CHANNELS 2
+#define BENCH_BIT_WIDTH 16
+
+struct bench_config {
+    pal_stream_type_t type;
+    unsigned int iterations;
+    unsigned int buffers;
+    unsigned int switches;
+    size_t buffer_size;
+};
+
+struct bench_results {
+    struct bench_stat open;
+    struct bench_stat start;
+    struct bench_stat write;
+    struct bench_stat device_switch;
+    struct bench_stat stop;
+    struct bench_stat close;
+    struct bench_stat capture_open;
+    struct bench_stat capture_start;
+    struct bench_stat read;
+    struct bench_stat capture_close;
+};
+
+static void set_media_config(struct pal_media_config *config)
+{
+    config->sample_rate = BENCH_RATE;
+    config->bit_width = BENCH_BIT_WIDTH;
+    config->aud_fmt_id = PAL_AUDIO_FMT_PCM_S16_LE;
+    config->ch_info.channels = BENCH_CHANNELS;
+    config->ch_info.ch_map[0] = PAL_CHMAP_CHANNEL_FL;
+    config->ch_info.ch_map[1] = PAL_CHMAP_CHANNEL_FR;
+}
+
+static void set_device(struct pal_device *device, pal_device_id_t id)
+{
+    memset(device, 0, sizeof(*device));
+    device->id = id;
+    set_media_config(&device->config);
+}
+
+static int open_stream(const struct bench_config *cfg, pal_stream_direction_t dir,
+                       pal_device_id_t dev_id, pal_stream_handle_t **handle,
+                       struct bench_stat *stat)
+{
+    struct pal_stream_attributes attr;
+    struct pal_device device;
+    pal_buffer_config_t buf_cfg;
+    uint64_t t;
+    int ret;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.type = cfg->type;
+    attr.direction = dir;
+    set_media_config(&attr.in_media_config);
+    set_media_config(&attr.out_media_config);
+    set_device(&device, dev_id);
+
+    t = bench_now_ns();
+    ret = pal_stream_open(&attr, 1, &device, 0, NULL, NULL, 0, handle);
+    if (ret) {
+        fprintf(stderr, "pal_stream_open failed %d\n", ret);
+        return ret;
+    }
+
+    buf_cfg.buf_count = 4;
+    buf_cfg.buf_size = cfg->buffer_size;
+    buf_cfg.max_metadata_size = 0;
+    ret = pal_stream_set_buffer_size(*handle,
+                                     dir == PAL_AUDIO_INPUT ? &buf_cfg : NULL,
+                                     dir == PAL_AUDIO_OUTPUT ? &buf_cfg : NULL);
+    bench_stat_add(stat, bench_now_ns() - t);
+    if (ret) {
+        fprintf(stderr, "pal_stream_set_buffer_size failed %d\n", ret);
+        pal_stream_close(*handle);
+    }
+
+    return ret;
+}
+
+static int timed_start(pal_stream_handle_t *handle, struct bench_stat *stat)
+{
+    uint64_t t = bench_now_ns();
+    int ret = pal_stream_start(handle);
+
+    bench_stat_add(stat, bench_now_ns() - t);
+    if (ret)
+        fprintf(stderr, "pal_stream_start failed %d\n", ret);
+
+    return ret;
+}
+
+static void timed_stop_close(pal_stream_handle_t *handle, struct bench_stat *stop,
+                             struct bench_stat *close)
+{
+    uint64_t t = bench_now_ns();
+
+    pal_stream_stop(handle);
+    if (stop) {
+        bench_stat_add(stop, bench_now_ns() - t);
+        t = bench_now_ns();
+    }
+    pal_stream_close(handle);
+    bench_stat_add(close, bench_now_ns() - t);
+}
+
+static int run_playback(const struct bench_config *cfg, struct bench_results *res,
+                        uint8_t *data)
+{
+    pal_stream_handle_t *handle = NULL;
+    struct pal_buffer buf;
+    struct pal_device device;
+    uint64_t t;
+    unsigned int i;
+    ssize_t n;
+    int ret;
+
+    ret = open_stream(cfg, PAL_AUDIO_OUTPUT, PAL_DEVICE_OUT_SPEAKER, &handle, &res->open);
+    if (ret)
+        return ret;
+    ret = timed_start(handle, &res->start);
+    if (ret)
+        goto close;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.buffer = data;
+    buf.size = cfg->buffer_size;
+    for (i = 0; i < cfg->buffers; i++) {
+        t = bench_now_ns();
+        n = pal_stream_write(handle, &buf);
+        bench_stat_add(&res->write, bench_now_ns() - t);
+        if (n < 0) {
+            fprintf(stderr, "pal_stream_write failed %zd\n", n);
+            ret = (int)n;
+            goto close;
+        }
+    }
+
+    /* speaker and handset are on different backends */
+    for (i = 0; i < cfg->switches; i++) {
+        set_device(&device, i & 1 ? PAL_DEVICE_OUT_SPEAKER : PAL_DEVICE_OUT_HANDSET);
+        t = bench_now_ns();
+        ret = pal_stream_set_device(handle, 1, &device);
+        bench_stat_add(&res->device_switch, bench_now_ns() - t);
+        if (ret) {
+            fprintf(stderr, "pal_stream_set_device failed %d\n", ret);
+            goto close;
+        }
+        pal_stream_write(handle, &buf);
+    }
+
+close:
+    timed_stop_close(handle, &res->stop, &res->close);
+    return ret;
+}
+
+static int run_capture(const struct bench_config *cfg, struct bench_results *res,
+                       uint8_t *data)
+{
+    pal_stream_handle_t *handle = NULL;
+    struct pal_buffer buf;
+    uint64_t t;
+    unsigned int i;
+    ssize_t n;
+    int ret;
+
+    ret = open_stream(cfg, PAL_AUDIO_INPUT, PAL_DEVICE_IN_HANDSET_MIC, &handle,
+                      &res->capture_open);
+    if (ret)
+        return ret;
+    ret = timed_start(handle, &res->capture_start);
+    if (ret)
+        goto close;
+
+    memset(&buf, 0, sizeof(buf));
+    buf.buffer = data;
+    buf.size = cfg->buffer_size;
+    for (i = 0; i < cfg->buffers; i++) {
+        t = bench_now_ns();
+        n = pal_stream_read(handle, &buf);
+        bench_stat_add(&res->read, bench_now_ns() - t);
+        if (n < 0) {
+            fprintf(stderr, "pal_stream_read failed %zd\n", n);
+            ret = (int)n;
+            break;
+        }
+    }
+
+close:
+    timed_stop_close(handle, NULL, &res->capture_close);
+    return ret;
+}
+
+static void usage(const char *prog)
+{
+    printf("usage: %s [-t ll|db] [-n iterations] [-b buffers] [-s switches] [-m ms]\n"
+           "  -t  stream type, low latency (default) or deep buffer\n"
+           "  -n  open/start/stop/close cycles, default 20\n"
+           "  -b  buffers written and read per cycle, default 200\n"
+           "  -s  device switches per cycle, default 4\n"
+           "  -m  buffer duration in ms, default 5 for ll and 20 for db\n",
+           prog);
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_config cfg = {
+        .type = PAL_STREAM_LOW_LATENCY,
+        .iterations = 20,
+        .buffers = 200,
+        .switches = 4,
+    };
+    struct bench_results res;
+    struct bench_stat init;
+    struct bench_stat *stats;
+    unsigned int ms = 0;
+    unsigned int i;
+    uint8_t *data;
+    uint64_t t;
+    int opt, ret = 0;
+
+    while ((opt = getopt(argc, argv, "t:n:b:s:m:h")) != -1) {
+        switch (opt) {
+        case 't':
+            if (!strcmp(optarg, "db")) {
+                cfg.type = PAL_STREAM_DEEP_BUFFER;
+            } else if (strcmp(optarg, "ll")) {
+                usage(argv[0]);
+                return -EINVAL;
+            }
+            break;
+        case 'n':
+            cfg.iterations = atoi(optarg);
+            break;
+        case 'b':
+            cfg.buffers = atoi(optarg);
+            break;
+        case 's':
+            cfg.switches = atoi(optarg);
+            break;
+        case 'm':
+            ms = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : -EINVAL;
+        }
+    }
+    if (!ms)
+        ms = cfg.type == PAL_STREAM_DEEP_BUFFER ? 20 : 5;
+    cfg.buffer_size = BENCH_RATE / 1000 * ms * BENCH_CHANNELS * BENCH_BIT_WIDTH / 8;
+
+    data = (uint8_t *)calloc(1, cfg.buffer_size);
+    if (!data)
+        return -ENOMEM;
+
+    stats = (struct bench_stat *)&res;
+    bench_stat_init(&res.open, "playback open", cfg.iterations);
+    bench_stat_init(&res.start, "playback start", cfg.iterations);
+    bench_stat_init(&res.write, "playback write", cfg.iterations * cfg.buffers);
+    bench_stat_init(&res.device_switch, "device switch", cfg.iterations * cfg.switches);
+    bench_stat_init(&res.stop, "playback stop", cfg.iterations);
+    bench_stat_init(&res.close, "playback close", cfg.iterations);
+    bench_stat_init(&res.capture_open, "capture open", cfg.iterations);
+    bench_stat_init(&res.capture_start, "capture start", cfg.iterations);
+    bench_stat_init(&res.read, "capture read", cfg.iterations * cfg.buffers);
+    bench_stat_init(&res.capture_close, "capture stop+close", cfg.iterations);
+    bench_stat_init(&init, "pal_init", 1);
+
+    printf("config root %s, %s, %zu byte buffers\n", bench_root(),
+           cfg.type == PAL_STREAM_DEEP_BUFFER ? "deep buffer" : "low latency",
+           cfg.buffer_size);
+
+    t = bench_now_ns();
+    ret = pal_init();
+    bench_stat_add(&init, bench_now_ns() - t);
+    if (ret) {
+        fprintf(stderr, "pal_init failed %d\n", ret);
+        goto done;
+    }
+
+    for (i = 0; i < cfg.iterations && !ret; i++) {
+        ret = run_playback(&cfg, &res, data);
+        if (!ret)
+            ret = run_capture(&cfg, &res, data);
+    }
+    pal_deinit();
+
+    bench_stat_print(&init);
+    for (i = 0; i < sizeof(res) / sizeof(struct bench_stat); i++)
+        bench_stat_print(&stats[i]);
+
+done:
+    for (i = 0; i < sizeof(res) / sizeof(struct bench_stat); i++)
+        bench_stat_deinit(&stats[i]);
+    bench_stat_deinit(&init);
+    free(data);
+
+    return ret;
+}
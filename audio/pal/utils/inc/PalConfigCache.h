@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef PAL_CONFIG_CACHE_H
+#define PAL_CONFIG_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+#define PAL_CONFIG_CACHE_MAGIC 0x47464350 /* "PCFG" */
+
+#if defined(FEATURE_IPQ_OPENWRT) || defined(LINUX_ENABLED)
+#define PAL_CONFIG_CACHE_DIR "/var/cache/audio"
+#else
+#define PAL_CONFIG_CACHE_DIR "/data/vendor/audio"
+#endif
+
+/*
+ * Binary image of tables parsed from a configuration xml.
+ *
+ * The header records the owner's format version and the FNV-1a hash and
+ * size of the source xml, so an image is only used while the xml it was
+ * built from is unchanged. The payload is a flat stream of 32 bit words
+ * and length prefixed strings, laid out and interpreted by the owner,
+ * and is covered by its own hash.
+ */
+struct pal_config_cache_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t src_hash;
+    uint64_t src_size;
+    uint64_t payload_size;
+    uint64_t payload_hash;
+};
+
+class PalConfigCache {
+ public:
+    static uint64_t hash(const void *data, size_t size);
+    /* hash the file contents, without parsing them */
+    static int32_t hashFile(const char *path, uint64_t *hash, uint64_t *size);
+};
+
+class PalConfigCacheWriter {
+ public:
+    void putU32(uint32_t value);
+    void putString(const std::string &str);
+    /* write to a temporary file and rename it over path */
+    int32_t commit(const char *path, uint32_t version, uint64_t srcHash,
+                   uint64_t srcSize);
+ private:
+    std::vector<uint8_t> payload_;
+};
+
+class PalConfigCacheReader {
+ public:
+    PalConfigCacheReader();
+    ~PalConfigCacheReader();
+    /* returns -ENOENT if there is no image, -EINVAL if it is stale or corrupt */
+    int32_t open(const char *path, uint32_t version, uint64_t srcHash,
+                 uint64_t srcSize);
+    bool getU32(uint32_t *value);
+    bool getString(std::string &str);
+    bool atEnd() const { return cur_ == end_; }
+ private:
+    void close();
+    void *map_;
+    size_t mapSize_;
+    const uint8_t *cur_;
+    const uint8_t *end_;
+};
+
+#endif //PAL_CONFIG_CACHE_H
@@ -34,6 +34,8 @@
 
 
 #include <stdlib.h>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -53,12 +55,21 @@ typedef enum {
 
 class PalRingBuffer;
 
+/*
+ * Single producer, multi consumer ring buffer.
+ *
+ * Writer and reader positions are monotonically increasing byte counts,
+ * the physical offset is position % bufferEnd_. The writer only ever
+ * touches writePos_ and each reader only touches its own readPos_, so the
+ * data path needs no lock. The writer keeps a cached lower bound of all
+ * enabled reader positions and only rescans readers when that bound says
+ * the ring is full.
+ */
 class PalRingBufferReader {
  public:
      PalRingBufferReader(PalRingBuffer *buffer)
          : ringBuffer_(buffer),
-           unreadSize_(0),
-           readOffset_(0),
+           readPos_(0),
            state_(READER_DISABLED) {}
 
     ~PalRingBufferReader() {};
@@ -68,17 +79,24 @@ class PalRingBufferReader {
     void updateState(pal_ring_buffer_reader_state state);
     void getIndices(uint32_t *startIndice, uint32_t *endIndice);
     size_t getUnreadSize();
+    /*
+     * Block until at least size bytes are unread, the reader is disabled
+     * or timeoutMs elapses. timeoutMs of 0 waits forever.
+     * Returns 0 on success, -ETIMEDOUT on timeout, -EINVAL if disabled.
+     */
+    int32_t waitForUnreadSize(size_t size, uint32_t timeoutMs);
     void reset();
-    bool isEnabled() { return state_ == READER_ENABLED; }
+    bool isEnabled() {
+        return state_.load(std::memory_order_acquire) == READER_ENABLED;
+    }
 
     friend class PalRingBuffer;
     friend class StreamSoundTrigger;
 
  protected:
     PalRingBuffer *ringBuffer_;
-    size_t unreadSize_;
-    size_t readOffset_;
-    pal_ring_buffer_reader_state state_;
+    std::atomic<uint64_t> readPos_;
+    std::atomic<pal_ring_buffer_reader_state> state_;
 };
 
 class PalRingBuffer {
@@ -87,12 +105,17 @@ class PalRingBuffer {
         : buffer_((char*)(new char[bufferSize])),
           startIndex(0),
           endIndex(0),
-          writeOffset_(0),
+          writePos_(0),
+          writeLimit_(0),
+          minReadPos_(0),
+          waiters_(0),
+          writing_(false),
+          resetPending_(0),
           bufferEnd_(bufferSize) {}
 
     ~PalRingBuffer() {
         if (buffer_)
-            delete buffer_;
+            delete[] buffer_;
 
         for (int i = 0; i < readOffsets_.size(); i++)
             delete readOffsets_[i];
@@ -109,16 +132,32 @@ class PalRingBuffer {
     void reset();
     size_t getBufferSize() { return bufferEnd_; };
     void resizeRingBuffer(size_t bufferSize);
+    void wakeUpReaders();
 
  protected:
+    /* serializes reader list changes and reader state transitions */
     std::mutex mutex_;
     char* buffer_;
     uint32_t startIndex;
     uint32_t endIndex;
-    size_t writeOffset_;
+    /* total bytes published to readers */
+    std::atomic<uint64_t> writePos_;
+    /* end of the region the writer may be copying into */
+    std::atomic<uint64_t> writeLimit_;
+    /* lower bound of readPos_ over all enabled readers */
+    std::atomic<uint64_t> minReadPos_;
+    std::atomic<uint32_t> waiters_;
+    /* set while write() is copying, reset() waits for it to drop */
+    std::atomic<bool> writing_;
+    /* non zero while a reset() is quiescing the writer */
+    std::atomic<uint32_t> resetPending_;
+    std::mutex waitMutex_;
+    std::condition_variable waitCond_;
     size_t bufferEnd_;
     std::vector<PalRingBufferReader*> readOffsets_;
-    void updateUnReadSize(size_t writtenSize);
+    uint64_t getMinReadPos();
+    void lowerMinReadPos(uint64_t pos);
+    void copyOut(uint64_t pos, void* dst, size_t size);
     friend class PalRingBufferReader;
 };
 #endif
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef PAL_TRACE_H
+#define PAL_TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+#include <atomic>
+
+#define PAL_TRACE_MAGIC 0x43525450 /* "PTRC" */
+#define PAL_TRACE_VERSION 1
+#define PAL_TRACE_MAX_ARGS 4
+/* records per thread, power of two */
+#define PAL_TRACE_RING_SIZE 1024
+#define PAL_TRACE_MAX_RINGS 64
+#define PAL_TRACE_MAX_FORMATS 1024
+#define PAL_TRACE_INVALID_FORMAT UINT16_MAX
+
+#if defined(FEATURE_IPQ_OPENWRT) || defined(LINUX_ENABLED)
+#define PAL_TRACE_DUMP_PATH "/var/cache/audio/pal_trace.bin"
+#else
+#define PAL_TRACE_DUMP_PATH "/data/vendor/audio/pal_trace.bin"
+#endif
+
+/*
+ * Binary trace for data path diagnostics. A call site stores a format
+ * id and its raw arguments in a ring owned by the calling thread, with
+ * no locking and no formatting. Rings are only read by dump(). Tracing
+ * is off by default and is toggled with the pal_trace=true|false
+ * parameter; pal_trace_dump=true writes PAL_TRACE_DUMP_PATH.
+ *
+ * Dump layout, all little endian:
+ *   pal_trace_file_header
+ *   num_formats x { uint16 id, uint16 len, char fmt[len] }, where fmt
+ *   is prefixed with the "function: line: " of the call site
+ *   num_records x pal_trace_record, oldest first per thread
+ * Each argument is widened to 64 bits, so a decoder applies the format
+ * with every conversion consuming one args word.
+ */
+struct pal_trace_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_formats;
+    uint32_t num_records;
+};
+
+struct pal_trace_record {
+    uint64_t ts_ns;
+    uint32_t tid;
+    uint16_t fmt_id;
+    uint16_t num_args;
+    uint64_t args[PAL_TRACE_MAX_ARGS];
+};
+
+class PalTrace {
+ public:
+    static bool isEnabled() { return enabled_.load(std::memory_order_relaxed); }
+    static void setEnabled(bool enable);
+    /* returns the id for the call site, or PAL_TRACE_INVALID_FORMAT */
+    static uint16_t registerFormat(const char *func, int line, const char *fmt);
+    static void record(uint16_t fmtId, uint16_t numArgs, const uint64_t *args);
+    static int32_t dump(const char *path);
+
+    template <typename T>
+    static uint64_t toArg(T value)
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_pointer<T>::value ||
+                      std::is_enum<T>::value, "trace arguments must be scalars");
+        return toArgImpl(value, std::is_floating_point<T>());
+    }
+
+ private:
+    template <typename T>
+    static uint64_t toArgImpl(T value, std::false_type)
+    {
+        return (uint64_t)value;
+    }
+    template <typename T>
+    static uint64_t toArgImpl(T value, std::true_type)
+    {
+        double d = value;
+        uint64_t bits;
+
+        memcpy(&bits, &d, sizeof(bits));
+        return bits;
+    }
+
+    static std::atomic<bool> enabled_;
+};
+
+template <typename... Args>
+static inline void palTrace(uint16_t fmtId, Args... args)
+{
+    static_assert(sizeof...(Args) <= PAL_TRACE_MAX_ARGS, "too many trace arguments");
+    const uint64_t argv[sizeof...(Args) + 1] = {PalTrace::toArg(args)..., 0};
+
+    PalTrace::record(fmtId, sizeof...(Args), argv);
+}
+
+/* trace fmt and up to PAL_TRACE_MAX_ARGS scalar arguments */
+#define PAL_TRACE(fmt, ...)                                                  \
+    do {                                                                     \
+        if (PalTrace::isEnabled()) {                                         \
+            static const uint16_t pal_trace_fmt_id =                         \
+                    PalTrace::registerFormat(__func__, __LINE__, fmt);       \
+            palTrace(pal_trace_fmt_id, ##__VA_ARGS__);                       \
+        }                                                                    \
+    } while (0)
+
+#endif //PAL_TRACE_H
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef STREAM_HANDLE_TABLE_H
+#define STREAM_HANDLE_TABLE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#define STREAM_HANDLE_TABLE_SIZE 256
+#define STREAM_HANDLE_INVALID_SLOT UINT32_MAX
+
+/*
+ * Open addressed table of stream handles with a per-slot atomic state
+ * word, used to validate and pin a stream on the data path without
+ * taking a global lock.
+ *
+ * State word layout: generation[63:32] | active[31] | users[30:0].
+ * Any slot reuse bumps the generation, so a pin racing with close and
+ * re-open of a slot fails its compare-exchange instead of pinning the
+ * wrong stream. add/deactivate/remove are control path operations and
+ * are serialized internally.
+ */
+class StreamHandleTable {
+ public:
+    StreamHandleTable();
+    ~StreamHandleTable() {};
+
+    int32_t add(const void *handle);
+    /* stop new pins and wait for in-flight users to drop theirs */
+    int32_t deactivate(const void *handle);
+    int32_t remove(const void *handle);
+    /*
+     * Returns 0 and the pinned slot on success, -EINVAL if the handle is
+     * known but being closed, -ENOENT if the handle is not tracked.
+     */
+    int32_t pin(const void *handle, uint32_t *slot);
+    void unpin(uint32_t slot);
+
+ private:
+    struct HandleSlot {
+        std::atomic<uintptr_t> key;
+        std::atomic<uint64_t> state;
+    };
+
+    uint32_t hash(uintptr_t key);
+    int32_t find(uintptr_t key);
+
+    HandleSlot slots_[STREAM_HANDLE_TABLE_SIZE];
+    std::mutex mutex_;
+    std::mutex drainMutex_;
+    std::condition_variable drainCond_;
+};
+#endif
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: PalConfigCache"
+
+#include "PalConfigCache.h"
+#include "PalCommon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FNV1A_64_OFFSET 0xcbf29ce484222325ULL
+#define FNV1A_64_PRIME 0x100000001b3ULL
+
+uint64_t PalConfigCache::hash(const void *data, size_t size)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t h = FNV1A_64_OFFSET;
+
+    for (size_t i = 0; i < size; i++) {
+        h ^= p[i];
+        h *= FNV1A_64_PRIME;
+    }
+    return h;
+}
+
+int32_t PalConfigCache::hashFile(const char *path, uint64_t *hash, uint64_t *size)
+{
+    struct stat st;
+    void *map = NULL;
+    int fd = -1;
+    int32_t ret = 0;
+
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ret = -errno;
+        PAL_ERR(LOG_TAG, "failed to open %s, ret %d", path, ret);
+        return ret;
+    }
+
+    if (fstat(fd, &st) < 0) {
+        ret = -errno;
+        PAL_ERR(LOG_TAG, "failed to stat %s, ret %d", path, ret);
+        goto exit;
+    }
+
+    *size = st.st_size;
+    if (st.st_size == 0) {
+        *hash = FNV1A_64_OFFSET;
+        goto exit;
+    }
+
+    map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        ret = -errno;
+        PAL_ERR(LOG_TAG, "failed to map %s, ret %d", path, ret);
+        goto exit;
+    }
+    *hash = PalConfigCache::hash(map, st.st_size);
+    munmap(map, st.st_size);
+
+exit:
+    ::close(fd);
+    return ret;
+}
+
+void PalConfigCacheWriter::putU32(uint32_t value)
+{
+    const uint8_t *p = (const uint8_t *)&value;
+
+    payload_.insert(payload_.end(), p, p + sizeof(value));
+}
+
+void PalConfigCacheWriter::putString(const std::string &str)
+{
+    putU32(str.size());
+    payload_.insert(payload_.end(), str.begin(), str.end());
+}
+
+int32_t PalConfigCacheWriter::commit(const char *path, uint32_t version,
+                                     uint64_t srcHash, uint64_t srcSize)
+{
+    struct pal_config_cache_header header;
+    std::string tmpPath = std::string(path) + ".tmp";
+    int fd = -1;
+    int32_t ret = 0;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = PAL_CONFIG_CACHE_MAGIC;
+    header.version = version;
+    header.src_hash = srcHash;
+    header.src_size = srcSize;
+    header.payload_size = payload_.size();
+    header.payload_hash = PalConfigCache::hash(payload_.data(), payload_.size());
+
+    fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        ret = -errno;
+        PAL_INFO(LOG_TAG, "cannot create %s, ret %d", tmpPath.c_str(), ret);
+        return ret;
+    }
+
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+        write(fd, payload_.data(), payload_.size()) != (ssize_t)payload_.size() ||
+        fsync(fd) < 0) {
+        ret = errno ? -errno : -EIO;
+        PAL_ERR(LOG_TAG, "failed to write %s, ret %d", tmpPath.c_str(), ret);
+        ::close(fd);
+        unlink(tmpPath.c_str());
+        return ret;
+    }
+    ::close(fd);
+
+    if (rename(tmpPath.c_str(), path) < 0) {
+        ret = -errno;
+        PAL_ERR(LOG_TAG, "failed to install %s, ret %d", path, ret);
+        unlink(tmpPath.c_str());
+        return ret;
+    }
+
+    PAL_INFO(LOG_TAG, "wrote %s, %zu bytes", path, payload_.size());
+    return ret;
+}
+
+PalConfigCacheReader::PalConfigCacheReader()
+    : map_(NULL), mapSize_(0), cur_(NULL), end_(NULL)
+{
+}
+
+PalConfigCacheReader::~PalConfigCacheReader()
+{
+    close();
+}
+
+void PalConfigCacheReader::close()
+{
+    if (map_)
+        munmap(map_, mapSize_);
+    map_ = NULL;
+    mapSize_ = 0;
+    cur_ = NULL;
+    end_ = NULL;
+}
+
+int32_t PalConfigCacheReader::open(const char *path, uint32_t version,
+                                   uint64_t srcHash, uint64_t srcSize)
+{
+    const struct pal_config_cache_header *header;
+    struct stat st;
+    int fd = -1;
+    int32_t ret = 0;
+
+    close();
+
+    fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -ENOENT;
+
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*header)) {
+        ret = -EINVAL;
+        goto exit;
+    }
+
+    map_ = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map_ == MAP_FAILED) {
+        map_ = NULL;
+        ret = -EINVAL;
+        goto exit;
+    }
+    mapSize_ = st.st_size;
+
+    header = (const struct pal_config_cache_header *)map_;
+    if (header->magic != PAL_CONFIG_CACHE_MAGIC || header->version != version ||
+        header->src_hash != srcHash || header->src_size != srcSize ||
+        header->payload_size != mapSize_ - sizeof(*header)) {
+        PAL_INFO(LOG_TAG, "%s is stale", path);
+        ret = -EINVAL;
+        goto exit;
+    }
+
+    cur_ = (const uint8_t *)map_ + sizeof(*header);
+    end_ = cur_ + header->payload_size;
+    if (PalConfigCache::hash(cur_, header->payload_size) != header->payload_hash) {
+        PAL_ERR(LOG_TAG, "%s payload checksum mismatch", path);
+        ret = -EINVAL;
+    }
+
+exit:
+    ::close(fd);
+    if (ret)
+        close();
+    return ret;
+}
+
+bool PalConfigCacheReader::getU32(uint32_t *value)
+{
+    if ((size_t)(end_ - cur_) < sizeof(*value))
+        return false;
+
+    memcpy(value, cur_, sizeof(*value));
+    cur_ += sizeof(*value);
+    return true;
+}
+
+bool PalConfigCacheReader::getString(std::string &str)
+{
+    uint32_t len = 0;
+
+    if (!getU32(&len) || (size_t)(end_ - cur_) < len)
+        return false;
+
+    str.assign((const char *)cur_, len);
+    cur_ += len;
+    return true;
+}
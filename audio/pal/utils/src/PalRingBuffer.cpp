@@ -31,12 +31,15 @@
 #ifdef LINUX_ENABLED
 #include <algorithm>
 #endif
+#include <chrono>
+#include <thread>
 #include "PalRingBuffer.h"
 #include "PalCommon.h"
 #define LOG_TAG "PAL: PalRingBuffer"
 
 int32_t PalRingBuffer::removeReader(PalRingBufferReader *reader)
 {
+    std::lock_guard<std::mutex> lock(mutex_);
     auto iter = std::find(readOffsets_.begin(), readOffsets_.end(), reader);
     if (iter != readOffsets_.end())
         readOffsets_.erase(iter);
@@ -50,28 +53,37 @@ size_t PalRingBuffer::read(std::shared_ptr<PalRingBufferReader>reader __unused,
     return 0;
 }
 
-size_t PalRingBuffer::getFreeSize()
+/*
+ * Rescan enabled readers and refresh the cached minimum read position.
+ * Only called when the cached value says the ring is (nearly) full.
+ */
+uint64_t PalRingBuffer::getMinReadPos()
 {
-
-    size_t freeSize = bufferEnd_;
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint64_t minPos = writePos_.load(std::memory_order_acquire);
     std::vector<PalRingBufferReader*>::iterator it;
 
     for (it = readOffsets_.begin(); it != readOffsets_.end(); it++) {
-        if ((*(it))->state_ == READER_ENABLED)
-            freeSize = std::min(freeSize, bufferEnd_ - (*(it))->unreadSize_);
+        if ((*(it))->state_.load(std::memory_order_acquire) == READER_ENABLED)
+            minPos = std::min(minPos,
+                (*(it))->readPos_.load(std::memory_order_acquire));
     }
-    return freeSize;
+    minReadPos_.store(minPos);
+    return minPos;
 }
 
-void PalRingBuffer::updateUnReadSize(size_t writtenSize)
+/* called with mutex_ held by a reader which moves behind the cached minimum */
+void PalRingBuffer::lowerMinReadPos(uint64_t pos)
 {
-    int32_t i = 0;
-    std::vector<PalRingBufferReader*>::iterator it;
+    if (pos < minReadPos_.load())
+        minReadPos_.store(pos);
+}
 
-    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++, i++) {
-        (*(it))->unreadSize_ += writtenSize;
-        PAL_VERBOSE(LOG_TAG, "Reader (%d), unreadSize(%zu)", i, (*(it))->unreadSize_);
-    }
+size_t PalRingBuffer::getFreeSize()
+{
+    uint64_t minPos = getMinReadPos();
+
+    return bufferEnd_ - (writePos_.load(std::memory_order_acquire) - minPos);
 }
 
 void PalRingBuffer::updateIndices(uint32_t startIndice, uint32_t endIndice)
@@ -81,61 +93,113 @@ void PalRingBuffer::updateIndices(uint32_t startIndice, uint32_t endIndice)
     PAL_VERBOSE(LOG_TAG, "start index = %u, end index = %u", startIndex, endIndex);
 }
 
+void PalRingBuffer::copyOut(uint64_t pos, void* dst, size_t size)
+{
+    size_t offset = pos % bufferEnd_;
+    size_t firstPart = std::min(size, bufferEnd_ - offset);
+
+    ar_mem_cpy(dst, firstPart, buffer_ + offset, firstPart);
+    if (size > firstPart)
+        ar_mem_cpy((char *)dst + firstPart, size - firstPart, buffer_,
+                         size - firstPart);
+}
+
 size_t PalRingBuffer::write(void* writeBuffer, size_t writeSize)
 {
-    /* update the unread size for each reader*/
-    mutex_.lock();
-    size_t freeSize = getFreeSize();
-    size_t writtenSize = 0;
-    int32_t i = 0;
+    uint64_t writePos = 0;
+    uint64_t minPos = 0;
     size_t sizeToCopy = 0;
+    size_t offset = 0;
+    size_t firstPart = 0;
+
+    /*
+     * Announce the write before looking for a pending reset, reset() does
+     * the opposite, so one of the two always backs off.
+     */
+    writing_.store(true);
+    while (resetPending_.load()) {
+        writing_.store(false);
+        std::this_thread::yield();
+        writing_.store(true);
+    }
 
-    PAL_DBG(LOG_TAG, "Enter. freeSize(%zu), writeOffset(%zu)", freeSize, writeOffset_);
+    /* single producer, only this thread moves writePos_ */
+    writePos = writePos_.load(std::memory_order_relaxed);
+    minPos = minReadPos_.load();
+    if (writePos + writeSize - minPos > bufferEnd_)
+        minPos = getMinReadPos();
+    sizeToCopy = std::min(writeSize, bufferEnd_ - (size_t)(writePos - minPos));
+
+    /*
+     * Publish the region about to be overwritten before trusting the cached
+     * minimum, a reader being enabled concurrently either sees this limit
+     * and starts after it, or its lowered minimum is seen below.
+     */
+    writeLimit_.store(writePos + sizeToCopy);
+    if (minReadPos_.load() < minPos) {
+        minPos = getMinReadPos();
+        sizeToCopy = std::min(sizeToCopy,
+            bufferEnd_ - (size_t)(writePos - minPos));
+        writeLimit_.store(writePos + sizeToCopy);
+    }
 
-    if (writeSize <= freeSize)
-        sizeToCopy = writeSize;
-    else
-        sizeToCopy = freeSize;
+    PAL_VERBOSE(LOG_TAG, "Enter. writeSize(%zu), writePos(%llu), sizeToCopy(%zu)",
+        writeSize, (unsigned long long)writePos, sizeToCopy);
 
     if (sizeToCopy) {
+        offset = writePos % bufferEnd_;
+        firstPart = std::min(sizeToCopy, bufferEnd_ - offset);
+        ar_mem_cpy(buffer_ + offset, firstPart, writeBuffer, firstPart);
         //buffer wrapped around
-        if (writeOffset_ + sizeToCopy > bufferEnd_) {
-            i = bufferEnd_ - writeOffset_;
-
-            ar_mem_cpy(buffer_ + writeOffset_, i, writeBuffer, i);
-            writtenSize += i;
-            sizeToCopy -= writtenSize;
-            ar_mem_cpy(buffer_, sizeToCopy, (char*)writeBuffer + writtenSize,
-                             sizeToCopy);
-            writtenSize += sizeToCopy;
-            writeOffset_ = sizeToCopy;
-        } else {
-            ar_mem_cpy(buffer_ + writeOffset_, sizeToCopy, writeBuffer,
-                             sizeToCopy);
-            writeOffset_ += sizeToCopy;
-            writtenSize = sizeToCopy;
+        if (sizeToCopy > firstPart)
+            ar_mem_cpy(buffer_, sizeToCopy - firstPart,
+                             (char*)writeBuffer + firstPart,
+                             sizeToCopy - firstPart);
+        writePos_.store(writePos + sizeToCopy);
+        if (waiters_.load() > 0) {
+            std::lock_guard<std::mutex> lock(waitMutex_);
+            waitCond_.notify_all();
         }
     }
-    updateUnReadSize(writtenSize);
-    writeOffset_ = writeOffset_ % bufferEnd_;
-    PAL_DBG(LOG_TAG, "Exit. writeOffset(%zu)", writeOffset_);
-    mutex_.unlock();
-    return writtenSize;
+    writing_.store(false);
+
+    return sizeToCopy;
+}
+
+void PalRingBuffer::wakeUpReaders()
+{
+    std::lock_guard<std::mutex> lock(waitMutex_);
+    waitCond_.notify_all();
 }
 
 void PalRingBuffer::reset()
 {
     std::vector<PalRingBufferReader*>::iterator it;
 
+    /*
+     * write() does not take mutex_, keep the writer out while positions are
+     * rewound so no reader is left ahead of writePos_. The writer may need
+     * mutex_ to rescan readers, so wait for it before locking.
+     */
+    resetPending_++;
+    while (writing_.load())
+        std::this_thread::yield();
+
     mutex_.lock();
     startIndex = 0;
     endIndex = 0;
-    writeOffset_ = 0;
-    mutex_.unlock();
+    writePos_.store(0);
+    writeLimit_.store(0);
+    minReadPos_.store(0);
 
     /* Reset all the associated readers */
-    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++)
-        (*(it))->reset();
+    for (it = readOffsets_.begin(); it != readOffsets_.end(); it++) {
+        (*(it))->readPos_.store(0);
+        (*(it))->state_.store(READER_DISABLED);
+    }
+    mutex_.unlock();
+    resetPending_--;
+    wakeUpReaders();
 }
 
 void PalRingBuffer::resizeRingBuffer(size_t bufferSize)
@@ -150,116 +214,81 @@ void PalRingBuffer::resizeRingBuffer(size_t bufferSize)
 
 int32_t PalRingBufferReader::read(void* readBuffer, size_t bufferSize)
 {
-    int32_t readSize = 0;
+    uint64_t readPos = 0;
+    uint64_t writePos = 0;
+    size_t readSize = 0;
 
-    if (state_ == READER_DISABLED)
+    if (!isEnabled())
         return -EINVAL;
 
+    readPos = readPos_.load(std::memory_order_acquire);
+    writePos = ringBuffer_->writePos_.load(std::memory_order_acquire);
+    if (writePos <= readPos)
+        return 0;
+    readSize = std::min(bufferSize, (size_t)(writePos - readPos));
+
     // Return 0 when no data can be read for current reader
-    if (unreadSize_ == 0)
+    if (readSize == 0)
         return 0;
 
-    ringBuffer_->mutex_.lock();
+    ringBuffer_->copyOut(readPos, readBuffer, readSize);
+
+    // reader was reset or repositioned while copying, drop this chunk
+    if (!readPos_.compare_exchange_strong(readPos, readPos + readSize))
+        return 0;
 
-    // when writeOffset leads readOffset
-    if (ringBuffer_->writeOffset_ > readOffset_) {
-        unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-
-        if (bufferSize >= unreadSize_) {
-            ar_mem_cpy(readBuffer, unreadSize_, ringBuffer_->buffer_ +
-                             readOffset_, unreadSize_);
-            readOffset_ += unreadSize_;
-            readSize = unreadSize_;
-            unreadSize_ = 0;
-        } else {
-            ar_mem_cpy(readBuffer, unreadSize_, ringBuffer_->buffer_ +
-                             readOffset_, bufferSize);
-            readOffset_ += bufferSize;
-            readSize = bufferSize;
-            unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-        }
-    } else {
-        //When readOffset leads WriteOffset
-        int32_t freeClientSize = bufferSize;
-        int32_t i = ringBuffer_->bufferEnd_ - readOffset_;
-
-        if (bufferSize >= i) {
-            ar_mem_cpy(readBuffer, i, (char*)(ringBuffer_->buffer_ +
-                             readOffset_), i);
-            readSize = i;
-            freeClientSize -= readSize;
-            unreadSize_ = ringBuffer_->writeOffset_;
-            readOffset_ = 0;
-            //copy remaining unread buffer
-            if (freeClientSize > unreadSize_) {
-                ar_mem_cpy((char *)readBuffer + readSize, unreadSize_,
-                                 ringBuffer_->buffer_, unreadSize_);
-                readSize += unreadSize_;
-                readOffset_ = unreadSize_;
-                unreadSize_ = 0;
-            } else {
-                //copy whatever we can
-                ar_mem_cpy((char *)readBuffer + readSize, freeClientSize,
-                                 ringBuffer_->buffer_, freeClientSize);
-                readSize += freeClientSize;
-                readOffset_ = freeClientSize;
-                unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
-            }
-
-        } else {
-            ar_mem_cpy(readBuffer, bufferSize, ringBuffer_->buffer_ +
-                             readOffset_, bufferSize);
-            readSize = bufferSize;
-            readOffset_ += bufferSize;
-            unreadSize_ = ringBuffer_->bufferEnd_ - readOffset_ +
-                          ringBuffer_->writeOffset_;
-        }
-    }
-    ringBuffer_->mutex_.unlock();
     return readSize;
 }
 
 size_t PalRingBufferReader::advanceReadOffset(size_t advanceSize)
 {
-    size_t size_advanced = 0;
+    uint64_t readPos = readPos_.load(std::memory_order_acquire);
+    size_t unreadSize = getUnreadSize();
 
-    std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
-
-    /* add code to advance the offset here*/
-    if (unreadSize_ < advanceSize) {
+    if (unreadSize < advanceSize) {
         PAL_ERR(LOG_TAG, "Cannot advance read offset %zu greater than unread size %zu",
-            advanceSize, unreadSize_);
-        return size_advanced;
+            advanceSize, unreadSize);
+        return 0;
     }
 
-    unreadSize_ -= advanceSize;
-    if (readOffset_ + advanceSize < ringBuffer_->bufferEnd_) {
-        readOffset_ += advanceSize;
-    } else {
-        readOffset_ = readOffset_ + advanceSize - ringBuffer_->bufferEnd_;
-    }
-    size_advanced += advanceSize;
+    if (!readPos_.compare_exchange_strong(readPos, readPos + advanceSize))
+        return 0;
 
-    return size_advanced;
+    return advanceSize;
 }
 
 void PalRingBufferReader::updateState(pal_ring_buffer_reader_state state)
 {
+    uint64_t readPos = 0;
+    uint64_t writeLimit = 0;
+    size_t bufferEnd = ringBuffer_->bufferEnd_;
+
     PAL_DBG(LOG_TAG, "update reader state to %d", state);
-    std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
+    ringBuffer_->mutex_.lock();
 
     if (state_ == READER_DISABLED && state == READER_ENABLED) {
-        if (unreadSize_ > ringBuffer_->bufferEnd_)
-           unreadSize_ = ringBuffer_->bufferEnd_;
-
-        if (unreadSize_ <= ringBuffer_->writeOffset_) {
-            readOffset_ = ringBuffer_->writeOffset_ - unreadSize_;
-        } else {
-            readOffset_ = ringBuffer_->writeOffset_ +
-                ringBuffer_->bufferEnd_ - unreadSize_;
-        }
+        /*
+         * Keep at most one buffer worth of history and never start inside
+         * the region the writer may be filling right now.
+         */
+        readPos = readPos_.load();
+        writeLimit = ringBuffer_->writeLimit_.load();
+        if (writeLimit > bufferEnd)
+            readPos = std::max(readPos, writeLimit - bufferEnd);
+        readPos_.store(readPos);
+        state_.store(state);
+        ringBuffer_->lowerMinReadPos(readPos);
+
+        writeLimit = ringBuffer_->writeLimit_.load();
+        if (writeLimit > bufferEnd && writeLimit - bufferEnd > readPos)
+            readPos_.store(writeLimit - bufferEnd);
+    } else {
+        state_.store(state);
     }
-    state_ = state;
+    ringBuffer_->mutex_.unlock();
+
+    if (state == READER_DISABLED)
+        ringBuffer_->wakeUpReaders();
 }
 
 void PalRingBufferReader::getIndices(uint32_t *startIndice, uint32_t *endIndice)
@@ -272,23 +301,61 @@ void PalRingBufferReader::getIndices(uint32_t *startIndice, uint32_t *endIndice)
 
 size_t PalRingBufferReader::getUnreadSize()
 {
-    PAL_VERBOSE(LOG_TAG, "unread size %zu", unreadSize_);
-    return unreadSize_;
+    uint64_t readPos = readPos_.load(std::memory_order_acquire);
+    uint64_t writePos = ringBuffer_->writePos_.load(std::memory_order_acquire);
+    size_t unreadSize = 0;
+
+    /* a reset can rewind writePos_ under a reader that is not yet disabled */
+    if (writePos > readPos)
+        unreadSize = writePos - readPos;
+
+    PAL_VERBOSE(LOG_TAG, "unread size %zu", unreadSize);
+    return unreadSize;
+}
+
+int32_t PalRingBufferReader::waitForUnreadSize(size_t size, uint32_t timeoutMs)
+{
+    bool ready = true;
+
+    if (size > ringBuffer_->bufferEnd_) {
+        PAL_ERR(LOG_TAG, "wait size %zu exceeds buffer size %zu",
+            size, ringBuffer_->bufferEnd_);
+        return -EINVAL;
+    }
+
+    ringBuffer_->waiters_++;
+    std::unique_lock<std::mutex> lck(ringBuffer_->waitMutex_);
+    auto pred = [&]() { return !isEnabled() || getUnreadSize() >= size; };
+    if (timeoutMs)
+        ready = ringBuffer_->waitCond_.wait_for(lck,
+            std::chrono::milliseconds(timeoutMs), pred);
+    else
+        ringBuffer_->waitCond_.wait(lck, pred);
+    lck.unlock();
+    ringBuffer_->waiters_--;
+
+    if (!isEnabled())
+        return -EINVAL;
+
+    return ready ? 0 : -ETIMEDOUT;
 }
 
 void PalRingBufferReader::reset()
 {
     ringBuffer_->mutex_.lock();
-    readOffset_ = 0;
-    unreadSize_ = 0;
-    state_ = READER_DISABLED;
+    readPos_.store(ringBuffer_->writePos_.load());
+    state_.store(READER_DISABLED);
     ringBuffer_->mutex_.unlock();
+    ringBuffer_->wakeUpReaders();
 }
 
 PalRingBufferReader* PalRingBuffer::newReader()
 {
     PalRingBufferReader* readOffset =
                   new PalRingBufferReader(this);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    readOffset->readPos_.store(writePos_.load());
     readOffsets_.push_back(readOffset);
     return readOffset;
 }
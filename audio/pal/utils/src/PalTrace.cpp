@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: PalTrace"
+
+#include "PalTrace.h"
+#include "PalCommon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+struct PalTraceRing {
+    std::atomic<uint64_t> head;
+    std::atomic<bool> inUse;
+    uint32_t tid;
+    struct pal_trace_record records[PAL_TRACE_RING_SIZE];
+};
+
+/* gives the ring back for reuse when its thread exits */
+struct PalTraceRingOwner {
+    PalTraceRing *ring = NULL;
+    ~PalTraceRingOwner()
+    {
+        if (ring)
+            ring->inUse.store(false, std::memory_order_release);
+    }
+};
+
+std::atomic<bool> PalTrace::enabled_(false);
+
+static std::mutex traceMutex;
+static std::vector<std::string> traceFormats;
+static std::atomic<PalTraceRing *> traceRings[PAL_TRACE_MAX_RINGS];
+static std::atomic<uint32_t> traceNumRings(0);
+static thread_local PalTraceRingOwner traceRingOwner;
+
+void PalTrace::setEnabled(bool enable)
+{
+    enabled_.store(enable, std::memory_order_relaxed);
+    PAL_INFO(LOG_TAG, "pal trace %s", enable ? "enabled" : "disabled");
+}
+
+uint16_t PalTrace::registerFormat(const char *func, int line, const char *fmt)
+{
+    std::lock_guard<std::mutex> lock(traceMutex);
+
+    if (traceFormats.size() >= PAL_TRACE_MAX_FORMATS) {
+        PAL_ERR(LOG_TAG, "no room for format at %s:%d", func, line);
+        return PAL_TRACE_INVALID_FORMAT;
+    }
+    traceFormats.push_back(std::string(func) + ": " + std::to_string(line) +
+                           ": " + fmt);
+    return traceFormats.size() - 1;
+}
+
+static PalTraceRing *getThreadRing()
+{
+    PalTraceRing *ring = NULL;
+    bool inUse = false;
+    uint32_t i, num;
+
+    if (traceRingOwner.ring)
+        return traceRingOwner.ring;
+
+    num = traceNumRings.load(std::memory_order_acquire);
+    for (i = 0; i < num; i++) {
+        ring = traceRings[i].load(std::memory_order_acquire);
+        inUse = false;
+        if (ring && ring->inUse.compare_exchange_strong(inUse, true,
+                                                        std::memory_order_acquire))
+            goto exit;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+
+        num = traceNumRings.load(std::memory_order_relaxed);
+        if (num == PAL_TRACE_MAX_RINGS)
+            return NULL;
+
+        ring = new (std::nothrow) PalTraceRing();
+        if (!ring)
+            return NULL;
+        ring->head.store(0, std::memory_order_relaxed);
+        ring->inUse.store(true, std::memory_order_relaxed);
+        traceRings[num].store(ring, std::memory_order_release);
+        traceNumRings.store(num + 1, std::memory_order_release);
+    }
+
+exit:
+    ring->tid = syscall(SYS_gettid);
+    traceRingOwner.ring = ring;
+    return ring;
+}
+
+void PalTrace::record(uint16_t fmtId, uint16_t numArgs, const uint64_t *args)
+{
+    struct pal_trace_record *rec;
+    struct timespec ts;
+    PalTraceRing *ring;
+    uint64_t head;
+
+    if (fmtId == PAL_TRACE_INVALID_FORMAT)
+        return;
+
+    ring = getThreadRing();
+    if (!ring)
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    head = ring->head.load(std::memory_order_relaxed);
+    rec = &ring->records[head & (PAL_TRACE_RING_SIZE - 1)];
+    rec->ts_ns = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    rec->tid = ring->tid;
+    rec->fmt_id = fmtId;
+    rec->num_args = numArgs;
+    memcpy(rec->args, args, numArgs * sizeof(uint64_t));
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+/*
+ * Copies the records of a ring that its writer cannot have overwritten
+ * while they were being read.
+ */
+static void snapshotRing(PalTraceRing *ring, std::vector<struct pal_trace_record> &out)
+{
+    size_t base = out.size();
+    uint64_t first, last, head, i;
+
+    last = ring->head.load(std::memory_order_acquire);
+    first = last > PAL_TRACE_RING_SIZE ? last - PAL_TRACE_RING_SIZE : 0;
+    for (i = first; i < last; i++)
+        out.push_back(ring->records[i & (PAL_TRACE_RING_SIZE - 1)]);
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    /* records up to index head - ring size may have been overwritten */
+    head = ring->head.load(std::memory_order_relaxed);
+    if (head >= first + PAL_TRACE_RING_SIZE) {
+        i = std::min(head - PAL_TRACE_RING_SIZE + 1, last) - first;
+        out.erase(out.begin() + base, out.begin() + base + i);
+    }
+}
+
+int32_t PalTrace::dump(const char *path)
+{
+    struct pal_trace_file_header header;
+    std::vector<struct pal_trace_record> records;
+    std::vector<uint8_t> formats;
+    uint32_t i, num;
+    uint16_t id, len;
+    int fd = -1;
+    int32_t ret = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(traceMutex);
+
+        for (i = 0; i < traceFormats.size(); i++) {
+            id = i;
+            len = traceFormats[i].size();
+            formats.insert(formats.end(), (uint8_t *)&id, (uint8_t *)&id + sizeof(id));
+            formats.insert(formats.end(), (uint8_t *)&len, (uint8_t *)&len + sizeof(len));
+            formats.insert(formats.end(), traceFormats[i].begin(), traceFormats[i].end());
+        }
+        header.num_formats = traceFormats.size();
+    }
+
+    num = traceNumRings.load(std::memory_order_acquire);
+    for (i = 0; i < num; i++)
+        snapshotRing(traceRings[i].load(std::memory_order_acquire), records);
+
+    header.magic = PAL_TRACE_MAGIC;
+    header.version = PAL_TRACE_VERSION;
+    header.num_records = records.size();
+
+    fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        ret = -errno;
+        PAL_ERR(LOG_TAG, "cannot create %s, ret %d", path, ret);
+        return ret;
+    }
+
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header) ||
+        write(fd, formats.data(), formats.size()) != (ssize_t)formats.size() ||
+        write(fd, records.data(), records.size() * sizeof(records[0])) !=
+            (ssize_t)(records.size() * sizeof(records[0]))) {
+        ret = errno ? -errno : -EIO;
+        PAL_ERR(LOG_TAG, "failed to write %s, ret %d", path, ret);
+    } else {
+        PAL_INFO(LOG_TAG, "wrote %u records to %s", header.num_records, path);
+    }
+    ::close(fd);
+
+    return ret;
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: StreamHandleTable"
+
+#include "StreamHandleTable.h"
+#include "PalCommon.h"
+
+#define SLOT_EMPTY ((uintptr_t)0)
+#define SLOT_TOMBSTONE ((uintptr_t)1)
+
+#define STATE_ACTIVE ((uint64_t)1 << 31)
+#define STATE_USERS_MASK (STATE_ACTIVE - 1)
+#define STATE_GEN_ONE ((uint64_t)1 << 32)
+#define STATE_GEN_MASK (~(STATE_GEN_ONE - 1))
+
+StreamHandleTable::StreamHandleTable()
+{
+    for (int i = 0; i < STREAM_HANDLE_TABLE_SIZE; i++) {
+        slots_[i].key.store(SLOT_EMPTY);
+        slots_[i].state.store(0);
+    }
+}
+
+uint32_t StreamHandleTable::hash(uintptr_t key)
+{
+    uint64_t h = ((uint64_t)key >> 3) * 0x9E3779B97F4A7C15ULL;
+
+    return (uint32_t)(h >> 32) & (STREAM_HANDLE_TABLE_SIZE - 1);
+}
+
+/* lock free, probes until the key or a never used slot is found */
+int32_t StreamHandleTable::find(uintptr_t key)
+{
+    uint32_t start = hash(key);
+    uint32_t idx = 0;
+    uintptr_t cur = 0;
+
+    for (uint32_t n = 0; n < STREAM_HANDLE_TABLE_SIZE; n++) {
+        idx = (start + n) & (STREAM_HANDLE_TABLE_SIZE - 1);
+        cur = slots_[idx].key.load(std::memory_order_acquire);
+        if (cur == key)
+            return idx;
+        if (cur == SLOT_EMPTY)
+            break;
+    }
+    return -ENOENT;
+}
+
+int32_t StreamHandleTable::add(const void *handle)
+{
+    uintptr_t key = (uintptr_t)handle;
+    uint32_t start = hash(key);
+    uint32_t idx = 0;
+    int32_t freeIdx = -1;
+    int32_t cur = 0;
+    uint64_t gen = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cur = find(key);
+    if (cur >= 0) {
+        /* stale entry for a reused address, start a new generation */
+        gen = (slots_[cur].state.load() & STATE_GEN_MASK) + STATE_GEN_ONE;
+        slots_[cur].state.store(gen | STATE_ACTIVE |
+            (slots_[cur].state.load() & STATE_USERS_MASK));
+        return 0;
+    }
+
+    for (uint32_t n = 0; n < STREAM_HANDLE_TABLE_SIZE; n++) {
+        idx = (start + n) & (STREAM_HANDLE_TABLE_SIZE - 1);
+        if (slots_[idx].key.load() <= SLOT_TOMBSTONE) {
+            freeIdx = idx;
+            break;
+        }
+    }
+    if (freeIdx < 0) {
+        PAL_ERR(LOG_TAG, "handle table full, %pK not tracked", handle);
+        return -ENOSPC;
+    }
+
+    gen = (slots_[freeIdx].state.load() & STATE_GEN_MASK) + STATE_GEN_ONE;
+    slots_[freeIdx].state.store(gen | STATE_ACTIVE);
+    slots_[freeIdx].key.store(key, std::memory_order_release);
+    return 0;
+}
+
+int32_t StreamHandleTable::deactivate(const void *handle)
+{
+    int32_t idx = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idx = find((uintptr_t)handle);
+        if (idx < 0)
+            return idx;
+        slots_[idx].state.fetch_and(~STATE_ACTIVE);
+    }
+
+    std::unique_lock<std::mutex> lck(drainMutex_);
+    drainCond_.wait(lck, [&]() {
+        return (slots_[idx].state.load() & STATE_USERS_MASK) == 0;
+    });
+    return 0;
+}
+
+int32_t StreamHandleTable::remove(const void *handle)
+{
+    int32_t idx = 0;
+    uint64_t state = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    idx = find((uintptr_t)handle);
+    if (idx < 0)
+        return idx;
+
+    state = slots_[idx].state.load();
+    if (state & STATE_USERS_MASK)
+        PAL_ERR(LOG_TAG, "handle %pK removed with %u users", handle,
+            (uint32_t)(state & STATE_USERS_MASK));
+    slots_[idx].state.store((state & STATE_GEN_MASK) + STATE_GEN_ONE);
+    slots_[idx].key.store(SLOT_TOMBSTONE, std::memory_order_release);
+    return 0;
+}
+
+int32_t StreamHandleTable::pin(const void *handle, uint32_t *slot)
+{
+    uintptr_t key = (uintptr_t)handle;
+    int32_t idx = find(key);
+    uint64_t state = 0;
+
+    if (idx < 0)
+        return idx;
+
+    state = slots_[idx].state.load();
+    do {
+        if (slots_[idx].key.load(std::memory_order_acquire) != key)
+            return -ENOENT;
+        if (!(state & STATE_ACTIVE))
+            return -EINVAL;
+    } while (!slots_[idx].state.compare_exchange_weak(state, state + 1));
+
+    *slot = idx;
+    return 0;
+}
+
+void StreamHandleTable::unpin(uint32_t slot)
+{
+    uint64_t prev = 0;
+
+    if (slot >= STREAM_HANDLE_TABLE_SIZE)
+        return;
+
+    prev = slots_[slot].state.fetch_sub(1);
+    if ((prev & STATE_USERS_MASK) == 1 && !(prev & STATE_ACTIVE)) {
+        std::lock_guard<std::mutex> lck(drainMutex_);
+        drainCond_.notify_all();
+    }
+}
@@ -137,89 +137,114 @@ void offload_bassboost_set_strength(struct bass_boost_params *bassboost,
 #endif
 }
 
-static int send_kv_payload(pal_stream_handle_t *pal_stream_handle,
-                            uint32_t tag, pal_key_vector_t *kvp)
+/*
+ * Parameters of one apply window, packed as the payload of
+ * PAL_PARAM_ID_UIEFFECT_BATCH: the outer pal_param_payload header in
+ * words[0] followed by one pal_param_payload record per parameter. It
+ * lives on the stack of the send helper, so no parameter is allocated,
+ * and the whole window reaches PAL in one pal_stream_set_param() call.
+ */
+#define EFFECT_BATCH_MAX_WORDS 256
+
+struct effect_batch {
+    uint32_t num_params;
+    uint32_t num_words;
+    uint32_t words[EFFECT_BATCH_MAX_WORDS];
+};
+
+static void effect_batch_init(struct effect_batch *batch)
+{
+    batch->num_params = 0;
+    batch->num_words = sizeof(pal_param_payload) / sizeof(uint32_t);
+}
+
+/* returns the zeroed payload of a new record, or NULL when full */
+static uint32_t *effect_batch_add(struct effect_batch *batch, pal_param_type_t type,
+                                  uint32_t tag, uint32_t payload_size)
 {
-   int ret = 0;
-   pal_param_payload *pal_payload;
-   effect_pal_payload_t *effect_payload = NULL;
-   uint8_t *payload = NULL;
-   pal_key_vector_t *pal_key_vector = NULL;
-   uint32_t payload_size = 0;
-   payload_size = sizeof(pal_param_payload) + sizeof(effect_pal_payload_t) +
-                  sizeof(pal_key_vector_t) +
-                  kvp->num_tkvs * sizeof(pal_key_value_pair_t);
-
-   payload = (uint8_t *) calloc (1, payload_size);
-   if (!payload) {
-       ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__, payload_size);
-       ret = -ENOMEM;
-       goto done;
-   }
-   pal_payload = (pal_param_payload *) payload;
-   pal_payload->payload_size = sizeof(effect_pal_payload_t) +
-                                  sizeof(pal_key_vector_t) +
-                                  kvp->num_tkvs * sizeof(pal_key_value_pair_t);
-
-    effect_payload = (effect_pal_payload_t *)(payload + sizeof(pal_param_payload));
-    effect_payload->isTKV = PARAM_TKV;
+    pal_param_payload *record;
+    effect_pal_payload_t *effect_payload;
+    uint32_t record_size = sizeof(pal_param_payload) + sizeof(effect_pal_payload_t) +
+                           payload_size;
+    uint32_t num_words = (record_size + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    if (num_words > EFFECT_BATCH_MAX_WORDS - batch->num_words) {
+        ALOGE("%s: no room for tag 0x%x, size %u", __func__, tag, payload_size);
+        return NULL;
+    }
+
+    record = (pal_param_payload *)&batch->words[batch->num_words];
+    memset(record, 0, num_words * sizeof(uint32_t));
+    record->payload_size = sizeof(effect_pal_payload_t) + payload_size;
+    effect_payload = (effect_pal_payload_t *)record->payload;
+    effect_payload->isTKV = type;
     effect_payload->tag = tag;
-    effect_payload->payloadSize = sizeof(pal_key_vector_t) +
-                                  kvp->num_tkvs * sizeof(pal_key_value_pair_t);
-    pal_key_vector = (pal_key_vector_t *)(payload +
-                                              sizeof(pal_param_payload) +
-                                              sizeof(effect_pal_payload_t));
-
-    pal_key_vector->num_tkvs = kvp->num_tkvs;
-    memcpy(pal_key_vector->kvp, kvp->kvp,
-                        (kvp->num_tkvs * sizeof(pal_key_value_pair_t)));
-    ret = pal_stream_set_param(pal_stream_handle, PAL_PARAM_ID_UIEFFECT,
-                               pal_payload);
-    free(pal_payload);
-done:
-    return ret;
+    effect_payload->payloadSize = payload_size;
+
+    batch->num_words += num_words;
+    batch->num_params++;
+
+    return effect_payload->payload;
 }
 
-static int send_custom_payload(pal_stream_handle_t *pal_stream_handle,
-                              uint32_t tag, pal_effect_custom_payload_t *data,
-                              uint32_t custom_data_sz)
+static int effect_batch_add_kv(struct effect_batch *batch, uint32_t tag,
+                               uint32_t key, uint32_t value)
 {
+    pal_key_vector_t *pal_key_vector;
+
+    pal_key_vector = (pal_key_vector_t *)effect_batch_add(batch, PARAM_TKV, tag,
+                                  sizeof(pal_key_vector_t) + sizeof(pal_key_value_pair_t));
+    if (!pal_key_vector)
+        return -ENOSPC;
+
+    pal_key_vector->num_tkvs = 1;
+    pal_key_vector->kvp[0].key = key;
+    pal_key_vector->kvp[0].value = value;
+
+    return 0;
+}
+
+/* returns the num_words of parameter data to fill in, or NULL when full */
+static uint32_t *effect_batch_add_custom(struct effect_batch *batch, uint32_t tag,
+                                         uint32_t param_id, uint32_t num_words)
+{
+    pal_effect_custom_payload_t *custom_payload;
+
+    custom_payload = (pal_effect_custom_payload_t *)effect_batch_add(batch, PARAM_NONTKV,
+                                  tag, sizeof(pal_effect_custom_payload_t) +
+                                  num_words * sizeof(uint32_t));
+    if (!custom_payload)
+        return NULL;
+
+    custom_payload->paramId = param_id;
+
+    return custom_payload->data;
+}
+
+static int effect_batch_flush(pal_stream_handle_t *pal_stream_handle,
+                              struct effect_batch *batch)
+{
+    pal_param_payload *pal_payload = (pal_param_payload *)batch->words;
     int ret = 0;
-    pal_param_payload *pal_payload;
-    effect_pal_payload_t *effect_payload = NULL;
-    uint8_t *payload = NULL;
-    pal_effect_custom_payload_t *custom_payload = NULL;
-    uint32_t payload_size = 0;
-    payload_size = sizeof(pal_param_payload) + sizeof(effect_pal_payload_t) +
-                   sizeof(pal_effect_custom_payload_t) + custom_data_sz;
-
-    payload = (uint8_t *) calloc (1, payload_size);
-    if (!payload) {
-        ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__, payload_size);
-        ret = -ENOMEM;
-        goto done;
-    }
 
-    pal_payload = (pal_param_payload *) payload;
-    pal_payload->payload_size = sizeof(effect_pal_payload_t) +
-                                  sizeof(pal_effect_custom_payload_t) +
-                                  custom_data_sz;
+    if (!batch->num_params)
+        return 0;
+
+    /* a single parameter goes out as it always did */
+    if (batch->num_params == 1) {
+        ret = pal_stream_set_param(pal_stream_handle, PAL_PARAM_ID_UIEFFECT,
+                                   (pal_param_payload *)pal_payload->payload);
+    } else {
+        pal_payload->payload_size = (batch->num_words * sizeof(uint32_t)) -
+                                    sizeof(pal_param_payload);
+        ret = pal_stream_set_param(pal_stream_handle, PAL_PARAM_ID_UIEFFECT_BATCH,
+                                   pal_payload);
+    }
+    if (ret)
+        ALOGE("%s: pal_stream_set_param failed for %u params. ret = %d", __func__,
+              batch->num_params, ret);
+    effect_batch_init(batch);
 
-    effect_payload = (effect_pal_payload_t *)(payload + sizeof(pal_param_payload));
-    effect_payload->isTKV = PARAM_NONTKV;
-    effect_payload->tag = tag;
-    effect_payload->payloadSize = sizeof(pal_effect_custom_payload_t) +
-                                  custom_data_sz;
-    custom_payload = (pal_effect_custom_payload_t *)(payload +
-                                                   sizeof(pal_param_payload) +
-                                                   sizeof(effect_pal_payload_t));
-
-    custom_payload->paramId = data->paramId;
-    memcpy(custom_payload->data, data->data, custom_data_sz);
-    ret = pal_stream_set_param(pal_stream_handle, PAL_PARAM_ID_UIEFFECT,
-                              pal_payload);
-    free(pal_payload);
-done:
     return ret;
 }
 
@@ -235,82 +260,44 @@ static int bassboost_send_params_pal(eff_mode_t mode, pal_stream_handle_t *pal_s
                                  unsigned param_send_flags)
 {
     int ret = 0;
-    pal_effect_custom_payload_t *custom_payload = NULL;
+    struct effect_batch batch;
+    uint32_t *data = NULL;
 
     if (!pal_stream_handle) {
         ALOGE("%s: pal stream handle is null.\n", __func__);
         return -EINVAL;
     }
+    effect_batch_init(&batch);
     if (param_send_flags & OFFLOAD_SEND_BASSBOOST_ENABLE_FLAG) {
-        uint32_t num_kvs = 1;
-        pal_key_vector_t *pal_key_vector = NULL;
-        pal_key_vector = (pal_key_vector_t *) calloc(1, sizeof(pal_key_vector_t) +
-                                            num_kvs * sizeof(pal_key_value_pair_t));
-        if (!pal_key_vector) {
-            ALOGE("%s:%d calloc failed for size %zu", __func__, __LINE__,
-                 sizeof(pal_key_vector_t) + num_kvs * sizeof(pal_key_value_pair_t));
-            ret = -ENOMEM;
-            goto done;
-        }
-        pal_key_vector->num_tkvs = num_kvs;
-        pal_key_vector->kvp[0].key= BASS_BOOST_SWITCH;
-        pal_key_vector->kvp[0].value = bassboost->enable_flag;
-
-        ret = send_kv_payload(pal_stream_handle, TAG_STREAM_BASS_BOOST, pal_key_vector);
-        free(pal_key_vector);
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        ret = effect_batch_add_kv(&batch, TAG_STREAM_BASS_BOOST, BASS_BOOST_SWITCH,
+                                  bassboost->enable_flag);
+        if (ret)
             goto done;
-        }
     }
 
     if (param_send_flags & OFFLOAD_SEND_BASSBOOST_STRENGTH) {
-        uint32_t custom_data_sz = BASS_BOOST_STRENGTH_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                           sizeof(pal_effect_custom_payload_t) +
-                                           custom_data_sz);
-        if (!custom_payload) {
-            ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                   custom_data_sz);
-            ret = -ENOMEM;
-            goto done;
-        }
-        custom_payload->paramId = PARAM_ID_BASS_BOOST_STRENGTH;
-        custom_payload->data[0] = bassboost->strength;
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_BASS_BOOST,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_BASS_BOOST,
+                                       PARAM_ID_BASS_BOOST_STRENGTH,
+                                       BASS_BOOST_STRENGTH_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = bassboost->strength;
     }
 
     if (param_send_flags & OFFLOAD_SEND_BASSBOOST_MODE) {
-        uint32_t custom_data_sz = BASS_BOOST_STRENGTH_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                           sizeof(pal_effect_custom_payload_t) +
-                                           custom_data_sz);
-        if (!custom_payload) {
-            ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                   custom_data_sz);
-            ret = -ENOMEM;
-            goto done;
-        }
-        custom_payload->paramId = PARAM_ID_BASS_BOOST_MODE;
-        custom_payload->data[0] = bassboost->strength;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_BASS_BOOST,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_BASS_BOOST,
+                                       PARAM_ID_BASS_BOOST_MODE,
+                                       BASS_BOOST_STRENGTH_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = bassboost->strength;
     }
 
+    ret = effect_batch_flush(pal_stream_handle, &batch);
 done:
     return ret;
 }
@@ -348,6 +335,7 @@ static int pbe_send_params_pal(eff_mode_t mode, pal_stream_handle_t *pal_stream_
                             unsigned param_send_flags)
 {
     int ret = 0;
+    struct effect_batch batch;
 
     if (!pal_stream_handle) {
         ALOGE("%s: pal stream handle is null.\n", __func__);
@@ -355,31 +343,14 @@ static int pbe_send_params_pal(eff_mode_t mode, pal_stream_handle_t *pal_stream_
     }
 
     ALOGV("%s: enabled=%d", __func__, pbe->enable_flag);
+    effect_batch_init(&batch);
     if (param_send_flags & OFFLOAD_SEND_PBE_ENABLE_FLAG) {
-        uint32_t num_kvs = 1;
-        pal_key_vector_t *pal_key_vector = NULL;
-
-        pal_key_vector = (pal_key_vector_t *) calloc (1, sizeof(pal_key_vector_t) +
-                                         num_kvs * sizeof(pal_key_value_pair_t));
-        if (!pal_key_vector) {
-            ALOGE("%s:%d calloc failed for size %zu", __func__, __LINE__,
-                 sizeof(pal_key_vector_t) + num_kvs * sizeof(pal_key_value_pair_t));
-            ret = -ENOMEM;
+        ret = effect_batch_add_kv(&batch, TAG_STREAM_PBE, PBE_SWITCH,
+                                  pbe->enable_flag);
+        if (ret)
             goto done;
-        }
-
-        pal_key_vector->num_tkvs = num_kvs;
-        pal_key_vector->kvp[0].key= PBE_SWITCH;
-        pal_key_vector->kvp[0].value = pbe->enable_flag;
-
-        ret = send_kv_payload(pal_stream_handle, TAG_STREAM_PBE,
-                              pal_key_vector);
-        free(pal_key_vector);
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
-            goto done;
-        }
     }
+    ret = effect_batch_flush(pal_stream_handle, &batch);
 done:
     return ret;
 }
@@ -446,102 +417,49 @@ static int virtualizer_send_params_pal(eff_mode_t mode, pal_stream_handle_t *pal
                                    unsigned param_send_flags)
 {
     int ret = 0;
-    pal_effect_custom_payload_t *custom_payload = NULL;
+    struct effect_batch batch;
+    uint32_t *data = NULL;
 
     ALOGV("%s: flags 0x%x", __func__, param_send_flags);
+    effect_batch_init(&batch);
     if (param_send_flags & OFFLOAD_SEND_VIRTUALIZER_ENABLE_FLAG) {
-        uint32_t num_kvs = 1;
-        pal_key_vector_t *pal_key_vector = NULL;
-        pal_key_vector = (pal_key_vector_t *) calloc (1, sizeof(pal_key_vector_t) +
-                                         num_kvs * sizeof(pal_key_value_pair_t));
-        if (!pal_key_vector) {
-            ALOGE("%s:%d calloc failed for size %zu", __func__, __LINE__,
-                 sizeof(pal_key_vector_t) + num_kvs * sizeof(pal_key_value_pair_t));
-            ret = -ENOMEM;
+        ret = effect_batch_add_kv(&batch, TAG_STREAM_VIRTUALIZER, VIRTUALIZER_SWITCH,
+                                  virtualizer->enable_flag);
+        if (ret)
             goto done;
-        }
-
-        pal_key_vector->num_tkvs = num_kvs;
-        pal_key_vector->kvp[0].key= VIRTUALIZER_SWITCH;
-        pal_key_vector->kvp[0].value =  virtualizer->enable_flag;
-
-        ret = send_kv_payload(pal_stream_handle, TAG_STREAM_VIRTUALIZER,
-                              pal_key_vector);
-        free(pal_key_vector);
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
-            goto done;
-        }
     }
     if (param_send_flags & OFFLOAD_SEND_VIRTUALIZER_STRENGTH) {
-        uint32_t custom_data_sz = VIRTUALIZER_STRENGTH_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                          sizeof(pal_effect_custom_payload_t) +
-                                          custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_VIRTUALIZER_STRENGTH;
-        custom_payload->data[0] = virtualizer->strength;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_VIRTUALIZER,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_VIRTUALIZER,
+                                       PARAM_ID_VIRTUALIZER_STRENGTH,
+                                       VIRTUALIZER_STRENGTH_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = virtualizer->strength;
     }
     if (param_send_flags & OFFLOAD_SEND_VIRTUALIZER_OUT_TYPE) {
-        uint32_t custom_data_sz = VIRTUALIZER_STRENGTH_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                         sizeof(pal_effect_custom_payload_t) +
-                                         custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_VIRTUALIZER_OUT_TYPE;
-        custom_payload->data[0] = virtualizer->out_type;
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_VIRTUALIZER,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_VIRTUALIZER,
+                                       PARAM_ID_VIRTUALIZER_OUT_TYPE,
+                                       VIRTUALIZER_STRENGTH_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = virtualizer->out_type;
     }
     if (param_send_flags & OFFLOAD_SEND_VIRTUALIZER_GAIN_ADJUST) {
-        uint32_t custom_data_sz = VIRTUALIZER_STRENGTH_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                                sizeof(pal_effect_custom_payload_t) +
-                                                custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_VIRTUALIZER_GAIN_ADJUST;
-        custom_payload->data[0] = virtualizer->gain_adjust;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_VIRTUALIZER,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_VIRTUALIZER,
+                                       PARAM_ID_VIRTUALIZER_GAIN_ADJUST,
+                                       VIRTUALIZER_STRENGTH_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = virtualizer->gain_adjust;
     }
+
+    ret = effect_batch_flush(pal_stream_handle, &batch);
 done:
     return ret;
 }
@@ -608,7 +526,8 @@ static int eq_send_params_pal(eff_mode_t mode, pal_stream_handle_t *pal_stream_h
 {
     uint32_t i = 0, index = 0;
     int ret = 0;
-    pal_effect_custom_payload_t *custom_payload = NULL;
+    struct effect_batch batch;
+    uint32_t *data = NULL;
 
     if (!pal_stream_handle) {
         ALOGE("%s: pal stream handle is null.\n", __func__);
@@ -621,91 +540,48 @@ static int eq_send_params_pal(eff_mode_t mode, pal_stream_handle_t *pal_stream_h
         return 0;
     }
 
+    effect_batch_init(&batch);
     if (param_send_flags & OFFLOAD_SEND_EQ_ENABLE_FLAG) {
-        uint32_t num_kvs = 1;
-        pal_key_vector_t *pal_key_vector = NULL;
-        pal_key_vector = (pal_key_vector_t *) calloc (1, sizeof(pal_key_vector_t) +
-                                           num_kvs * sizeof(pal_key_value_pair_t));
-        if (!pal_key_vector) {
-            ALOGE("%s:%d calloc failed for size %zu", __func__, __LINE__,
-                 sizeof(pal_key_vector_t) + num_kvs * sizeof(pal_key_value_pair_t));
-            ret = -ENOMEM;
-            goto done;
-        }
-
-        pal_key_vector->num_tkvs = num_kvs;
-        pal_key_vector->kvp[0].key= EQUALIZER_SWITCH;
-        pal_key_vector->kvp[0].value = eq->enable_flag;
-        ret = send_kv_payload(pal_stream_handle, TAG_STREAM_EQUALIZER,
-                              pal_key_vector);
-        free(pal_key_vector);
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        ret = effect_batch_add_kv(&batch, TAG_STREAM_EQUALIZER, EQUALIZER_SWITCH,
+                                  eq->enable_flag);
+        if (ret)
             goto done;
-        }
     }
 
     if (param_send_flags & OFFLOAD_SEND_EQ_PRESET) {
-        uint32_t custom_data_sz = EQ_CONFIG_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                           sizeof(pal_effect_custom_payload_t) +
-                                           custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_EQ_CONFIG;
-        custom_payload->data[0] = eq->config.eq_pregain;
-        custom_payload->data[1] =
-            map_eq_opensl_preset_2_offload_preset[eq->config.preset_id];
-        custom_payload->data[2] = 0;    // num_of_band must be 0 for preset
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_EQUALIZER,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_EQUALIZER,
+                                       PARAM_ID_EQ_CONFIG, EQ_CONFIG_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = eq->config.eq_pregain;
+        data[1] = map_eq_opensl_preset_2_offload_preset[eq->config.preset_id];
+        data[2] = 0;    // num_of_band must be 0 for preset
     }
 
     if (param_send_flags & OFFLOAD_SEND_EQ_BANDS_LEVEL) {
-        uint32_t custom_data_sz = (EQ_CONFIG_PARAM_LEN +
-         (eq->config.num_bands * EQ_CONFIG_PER_BAND_PARAM_LEN)) * sizeof(uint32_t);
-
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                           sizeof(pal_effect_custom_payload_t) +
-                                           custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
+        data = effect_batch_add_custom(&batch, TAG_STREAM_EQUALIZER,
+                                       PARAM_ID_EQ_CONFIG, EQ_CONFIG_PARAM_LEN +
+                                       (eq->config.num_bands * EQ_CONFIG_PER_BAND_PARAM_LEN));
+        if (!data) {
+            ret = -ENOSPC;
+            goto done;
         }
-        custom_payload->paramId = PARAM_ID_EQ_CONFIG;
         index = 0;
-        custom_payload->data[index++] = eq->config.eq_pregain;
-        custom_payload->data[index++] = CUSTOM_OPENSL_PRESET;
-        custom_payload->data[index++] = eq->config.num_bands;
+        data[index++] = eq->config.eq_pregain;
+        data[index++] = CUSTOM_OPENSL_PRESET;
+        data[index++] = eq->config.num_bands;
         for (i = 0; i < eq->config.num_bands; i++) {
-            custom_payload->data[index++] = eq->per_band_cfg[i].filter_type;
-            custom_payload->data[index++] = eq->per_band_cfg[i].freq_millihertz;
-            custom_payload->data[index++] = eq->per_band_cfg[i].gain_millibels;
-            custom_payload->data[index++] = eq->per_band_cfg[i].quality_factor;
-            custom_payload->data[index++] = eq->per_band_cfg[i].band_idx;
-        }
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_EQUALIZER,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
-            goto done;
+            data[index++] = eq->per_band_cfg[i].filter_type;
+            data[index++] = eq->per_band_cfg[i].freq_millihertz;
+            data[index++] = eq->per_band_cfg[i].gain_millibels;
+            data[index++] = eq->per_band_cfg[i].quality_factor;
+            data[index++] = eq->per_band_cfg[i].band_idx;
         }
     }
+
+    ret = effect_batch_flush(pal_stream_handle, &batch);
 done:
     return ret;
 }
@@ -831,360 +707,160 @@ static int reverb_send_params_pal(eff_mode_t mode, pal_stream_handle_t *pal_stre
                               unsigned param_send_flags)
 {
     int ret = 0;
-    pal_effect_custom_payload_t *custom_payload = NULL;
+    struct effect_batch batch;
+    uint32_t *data = NULL;
 
     ALOGV("%s: flags 0x%x", __func__, param_send_flags);
 
+    effect_batch_init(&batch);
     if (param_send_flags & OFFLOAD_SEND_REVERB_ENABLE_FLAG) {
-        uint32_t num_kvs = 1;
-        pal_key_vector_t *pal_key_vector = NULL;
-        pal_key_vector = (pal_key_vector_t *) calloc (1, sizeof(pal_key_vector_t) +
-                                         num_kvs * sizeof(pal_key_value_pair_t));
-        if (!pal_key_vector) {
-            ALOGE("%s:%d calloc failed for size %zu", __func__, __LINE__,
-                 sizeof(pal_key_vector_t) + num_kvs * sizeof(pal_key_value_pair_t));
-            ret = -ENOMEM;
+        ret = effect_batch_add_kv(&batch, TAG_STREAM_REVERB, REVERB_SWITCH,
+                                  reverb->enable_flag);
+        if (ret)
             goto done;
-        }
-        pal_key_vector->num_tkvs = num_kvs;
-        pal_key_vector->kvp[0].key= REVERB_SWITCH;
-        pal_key_vector->kvp[0].value = reverb->enable_flag;
-        ret = send_kv_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              pal_key_vector);
-        free(pal_key_vector);
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
-            goto done;
-        }
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_MODE) {
-        uint32_t custom_data_sz = REVERB_MODE_PARAM_LEN * sizeof(uint32_t);
-
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                           sizeof(pal_effect_custom_payload_t) +
-                                           custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_MODE;
-        custom_payload->data[0] = reverb->mode;;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_MODE,
+                                       REVERB_MODE_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->mode;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_PRESET) {
-        uint32_t custom_data_sz = REVERB_PRESET_PARAM_LEN * sizeof(uint32_t);
-
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                           sizeof(pal_effect_custom_payload_t) +
-                                           custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_PRESET;
-        custom_payload->data[0] = reverb->preset;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_PRESET,
+                                       REVERB_PRESET_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->preset;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_WET_MIX) {
-        // param_id + actual payload
-        uint32_t custom_data_sz = REVERB_WET_MIX_PARAM_LEN * sizeof(uint32_t);
-
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                            sizeof(pal_effect_custom_payload_t) +
-                                            custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-
-        custom_payload->paramId = PARAM_ID_REVERB_WET_MIX;
-        custom_payload->data[0] = reverb->wet_mix;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_WET_MIX,
+                                       REVERB_WET_MIX_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->wet_mix;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_GAIN_ADJUST) {
-        uint32_t custom_data_sz = REVERB_GAIN_ADJUST_PARAM_LEN * sizeof(uint32_t);
-
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                            sizeof(pal_effect_custom_payload_t) +
-                                            custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-
-        custom_payload->paramId = PARAM_ID_REVERB_GAIN_ADJUST;
-        custom_payload->data[0] = reverb->gain_adjust;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_GAIN_ADJUST,
+                                       REVERB_GAIN_ADJUST_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->gain_adjust;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_ROOM_LEVEL) {
-        uint32_t custom_data_sz = REVERB_ROOM_LEVEL_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                            sizeof(pal_effect_custom_payload_t) +
-                                            custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_ROOM_LEVEL;
-        custom_payload->data[0] = reverb->room_level;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_ROOM_LEVEL,
+                                       REVERB_ROOM_LEVEL_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->room_level;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_ROOM_HF_LEVEL) {
-        uint32_t custom_data_sz = REVERB_ROOM_HF_LEVEL_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                            sizeof(pal_effect_custom_payload_t) +
-                                            custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_ROOM_HF_LEVEL;
-        custom_payload->data[0] = reverb->room_hf_level;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_ROOM_HF_LEVEL,
+                                       REVERB_ROOM_HF_LEVEL_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->room_hf_level;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_DECAY_TIME) {
-        uint32_t custom_data_sz = REVERB_DECAY_TIME_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                              sizeof(pal_effect_custom_payload_t) +
-                                              custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_DECAY_TIME;
-        custom_payload->data[0] = reverb->decay_time;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_DECAY_TIME,
+                                       REVERB_DECAY_TIME_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->decay_time;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_DECAY_HF_RATIO) {
-        uint32_t custom_data_sz = REVERB_DECAY_HF_RATIO_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                              sizeof(pal_effect_custom_payload_t) +
-                                              custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_DECAY_HF_RATIO;
-        custom_payload->data[0] = reverb->decay_hf_ratio;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_DECAY_HF_RATIO,
+                                       REVERB_DECAY_HF_RATIO_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->decay_hf_ratio;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_REFLECTIONS_LEVEL) {
-        uint32_t custom_data_sz = REVERB_REFLECTIONS_LEVEL_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                            sizeof(pal_effect_custom_payload_t) +
-                                            custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-
-        custom_payload->paramId = PARAM_ID_REVERB_REFLECTIONS_LEVEL;
-        custom_payload->data[0] = reverb->reflections_level;
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_REFLECTIONS_LEVEL,
+                                       REVERB_REFLECTIONS_LEVEL_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->reflections_level;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_REFLECTIONS_DELAY) {
-        uint32_t custom_data_sz = REVERB_REFLECTIONS_DELAY_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                             sizeof(pal_effect_custom_payload_t) +
-                                             custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-
-        custom_payload->paramId = PARAM_ID_REVERB_REFLECTIONS_DELAY;
-        custom_payload->data[0] = reverb->reflections_delay;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_REFLECTIONS_DELAY,
+                                       REVERB_REFLECTIONS_DELAY_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->reflections_delay;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_LEVEL) {
-        uint32_t custom_data_sz = REVERB_LEVEL_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                              sizeof(pal_effect_custom_payload_t) +
-                                              custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_LEVEL;
-        custom_payload->data[0] = reverb->level;
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_LEVEL,
+                                       REVERB_LEVEL_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
-
+        data[0] = reverb->level;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_DELAY) {
-        uint32_t custom_data_sz = REVERB_DELAY_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                             sizeof(pal_effect_custom_payload_t) +
-                                             custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_DELAY;
-        custom_payload->data[0] = reverb->delay;
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_DELAY,
+                                       REVERB_DELAY_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->delay;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_DIFFUSION) {
-        uint32_t custom_data_sz = REVERB_DIFFUSION_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                           sizeof(pal_effect_custom_payload_t) +
-                                           custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_DIFFUSION;
-        custom_payload->data[0] = reverb->diffusion;
-
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_DIFFUSION,
+                                       REVERB_DIFFUSION_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
             goto done;
         }
+        data[0] = reverb->diffusion;
     }
     if (param_send_flags & OFFLOAD_SEND_REVERB_DENSITY) {
-        uint32_t custom_data_sz = REVERB_DENSITY_PARAM_LEN * sizeof(uint32_t);
-        custom_payload = (pal_effect_custom_payload_t *) calloc (1,
-                                           sizeof(pal_effect_custom_payload_t) +
-                                           custom_data_sz);
-        if (!custom_payload) {
-             ALOGE("%s:%d calloc failed for size %d", __func__, __LINE__,
-                    custom_data_sz);
-             ret = -ENOMEM;
-             goto done;
-        }
-        custom_payload->paramId = PARAM_ID_REVERB_DENSITY;
-        custom_payload->data[0] = reverb->density;
-        ret = send_custom_payload(pal_stream_handle, TAG_STREAM_REVERB,
-                              custom_payload, custom_data_sz);
-        free(custom_payload);
-        custom_payload = NULL;
-        if (ret) {
-            ALOGE("%s: pal_stream_set_param failed. ret = %d", __func__, ret);
-            return ret;
+        data = effect_batch_add_custom(&batch, TAG_STREAM_REVERB,
+                                       PARAM_ID_REVERB_DENSITY,
+                                       REVERB_DENSITY_PARAM_LEN);
+        if (!data) {
+            ret = -ENOSPC;
+            goto done;
         }
+        data[0] = reverb->density;
     }
+
+    ret = effect_batch_flush(pal_stream_handle, &batch);
 done:
     return ret;
 }
@@ -19,6 +19,7 @@
 /*#define LOG_NDEBUG 0*/
 #include <assert.h>
 #include <math.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -33,6 +34,14 @@
 #include <audio_effects/effect_visualizer.h>
 #include "PalApi.h"
 
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define VISUALIZER_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define VISUALIZER_SSE2
+#endif
+
 #ifdef AUDIO_FEATURE_ENABLED_GCOV
 extern void  __gcov_flush();
 static void enable_gcov()
@@ -118,7 +127,8 @@ typedef struct buffer_stats_s {
 typedef struct visualizer_context_s {
     effect_context_t common;
 
-    uint32_t capture_idx;
+    /* written by the capture thread once the new samples are in capture_buf */
+    _Atomic uint32_t capture_idx;
     uint32_t capture_size;
     uint32_t scaling_mode;
     uint32_t last_capture_idx;
@@ -630,7 +640,7 @@ int visualizer_reset(effect_context_t *context)
 {
     visualizer_context_t * visu_ctxt = (visualizer_context_t *)context;
 
-    visu_ctxt->capture_idx = 0;
+    atomic_store_explicit(&visu_ctxt->capture_idx, 0, memory_order_relaxed);
     visu_ctxt->last_capture_idx = 0;
     visu_ctxt->buffer_update_time.tv_sec = 0;
     visu_ctxt->latency = DSP_OUTPUT_LATENCY_MS;
@@ -746,6 +756,166 @@ int visualizer_set_parameter(effect_context_t *context, effect_param_t *p, uint3
     return 0;
 }
 
+/*
+ * Measurement and capture kernels. The vector loops handle whole blocks
+ * and leave the tail to the scalar loop, both give the same results.
+ */
+
+/* peak of the absolute sample values and the exact sum of squares */
+static void visualizer_measure(const int16_t *in, uint32_t len,
+                               uint16_t *peak, uint64_t *sum_squares)
+{
+    uint32_t i = 0;
+    uint16_t max = 0;
+    uint64_t acc = 0;
+
+#if defined(VISUALIZER_NEON)
+    uint16x8_t vmax = vdupq_n_u16(0);
+    int64x2_t vacc = vdupq_n_s64(0);
+
+    for (; i + 8 <= len; i += 8) {
+        int16x8_t x = vld1q_s16(in + i);
+        /* abs(-32768) wraps to 0x8000, which is right as unsigned */
+        vmax = vmaxq_u16(vmax, vreinterpretq_u16_s16(vabsq_s16(x)));
+        vacc = vpadalq_s32(vacc, vmull_s16(vget_low_s16(x), vget_low_s16(x)));
+        vacc = vpadalq_s32(vacc, vmull_high_s16(x, x));
+    }
+    max = vmaxvq_u16(vmax);
+    acc = vaddvq_s64(vacc);
+#elif defined(VISUALIZER_SSE2)
+    /* SSE2 has no unsigned 16 bit max, compare biased values instead */
+    const __m128i bias = _mm_set1_epi16((short)0x8000);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i vmax = bias;
+    __m128i vacc = zero;
+    uint16_t lanes[8];
+    uint64_t sums[2];
+    int j;
+
+    for (; i + 8 <= len; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        __m128i sign = _mm_srai_epi16(x, 15);
+        __m128i mag = _mm_sub_epi16(_mm_xor_si128(x, sign), sign);
+        /* a pair of -32768 sums to 2^31, still right as unsigned */
+        __m128i sq = _mm_madd_epi16(x, x);
+
+        vmax = _mm_max_epi16(vmax, _mm_xor_si128(mag, bias));
+        vacc = _mm_add_epi64(vacc, _mm_unpacklo_epi32(sq, zero));
+        vacc = _mm_add_epi64(vacc, _mm_unpackhi_epi32(sq, zero));
+    }
+    _mm_storeu_si128((__m128i *)lanes, _mm_xor_si128(vmax, bias));
+    for (j = 0; j < 8; j++) {
+        if (lanes[j] > max)
+            max = lanes[j];
+    }
+    _mm_storeu_si128((__m128i *)sums, vacc);
+    acc = sums[0] + sums[1];
+#endif
+    for (; i < len; i++) {
+        int32_t smp = in[i];
+        uint16_t mag = smp < 0 ? -smp : smp;
+
+        if (mag > max)
+            max = mag;
+        acc += smp * smp;
+    }
+    *peak = max;
+    *sum_squares = acc;
+}
+
+/*
+ * Smallest number of leading zeros over all samples, negative samples
+ * counted as -smp - 1. That is the clz of the largest ~smp/smp value.
+ */
+static int32_t visualizer_min_clz(const int16_t *in, uint32_t len)
+{
+    uint32_t i = 0;
+    int32_t max = 0;
+
+#if defined(VISUALIZER_NEON)
+    int16x8_t vmax = vdupq_n_s16(0);
+
+    for (; i + 8 <= len; i += 8) {
+        int16x8_t x = vld1q_s16(in + i);
+        vmax = vmaxq_s16(vmax, veorq_s16(x, vshrq_n_s16(x, 15)));
+    }
+    max = vmaxvq_s16(vmax);
+#elif defined(VISUALIZER_SSE2)
+    __m128i vmax = _mm_setzero_si128();
+    int16_t lanes[8];
+    int j;
+
+    for (; i + 8 <= len; i += 8) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(in + i));
+        vmax = _mm_max_epi16(vmax, _mm_xor_si128(x, _mm_srai_epi16(x, 15)));
+    }
+    _mm_storeu_si128((__m128i *)lanes, vmax);
+    for (j = 0; j < 8; j++) {
+        if (lanes[j] > max)
+            max = lanes[j];
+    }
+#endif
+    for (; i < len; i++) {
+        int32_t smp = in[i];
+
+        smp ^= smp >> 15;
+        if (smp > max)
+            max = smp;
+    }
+    /* all silent, clz of 0 is undefined */
+    return max ? __builtin_clz(max) : 32;
+}
+
+/* sum each stereo frame, shift it to 8 bits and store it unsigned */
+static void visualizer_downmix(uint8_t *dst, const int16_t *in, uint32_t frames,
+                               int32_t shift)
+{
+    uint32_t i = 0;
+
+#if defined(VISUALIZER_NEON)
+    const int32x4_t vshift = vdupq_n_s32(-shift);
+    const uint8x8_t flip = vdup_n_u8(0x80);
+
+    for (; i + 8 <= frames; i += 8) {
+        int16x8x2_t lr = vld2q_s16(in + 2 * i);
+        int32x4_t lo = vshlq_s32(vaddl_s16(vget_low_s16(lr.val[0]),
+                                           vget_low_s16(lr.val[1])), vshift);
+        int32x4_t hi = vshlq_s32(vaddl_high_s16(lr.val[0], lr.val[1]), vshift);
+        /* narrowing keeps the low bits, like the cast below */
+        int8x8_t smp = vmovn_s16(vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)));
+
+        vst1_u8(dst + i, veor_u8(vreinterpret_u8_s8(smp), flip));
+    }
+#elif defined(VISUALIZER_SSE2)
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i low = _mm_set1_epi32(0xff);
+    const __m128i flip = _mm_set1_epi8((char)0x80);
+    const __m128i count = _mm_cvtsi32_si128(shift);
+    __m128i smp[4];
+    int j;
+
+    for (; i + 16 <= frames; i += 16) {
+        for (j = 0; j < 4; j++) {
+            /* madd with ones adds the left and right sample of each frame */
+            smp[j] = _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(in + 2 * i + 8 * j)),
+                                    ones);
+            /* keep the low byte so that the packs below never saturate */
+            smp[j] = _mm_and_si128(_mm_sra_epi32(smp[j], count), low);
+        }
+        _mm_storeu_si128((__m128i *)(dst + i),
+                         _mm_xor_si128(_mm_packus_epi16(_mm_packs_epi32(smp[0], smp[1]),
+                                                        _mm_packs_epi32(smp[2], smp[3])),
+                                       flip));
+    }
+#endif
+    for (; i < frames; i++) {
+        int32_t smp = in[2 * i] + in[2 * i + 1];
+
+        smp = smp >> shift;
+        dst[i] = ((uint8_t)smp)^0x80;
+    }
+}
+
 /* Real process function called from capture thread. Called with lock held */
 int visualizer_process(effect_context_t *context,
                        audio_buffer_t *inBuffer,
@@ -766,21 +936,15 @@ int visualizer_process(effect_context_t *context,
     // perform measurements if needed
     if (visu_ctxt->meas_mode & MEASUREMENT_MODE_PEAK_RMS) {
         // find the peak and RMS squared for the new buffer
-        uint32_t inIdx;
-        int16_t max_sample = 0;
-        float rms_squared_acc = 0;
-        for (inIdx = 0 ; inIdx < inBuffer->frameCount * visu_ctxt->channel_count ; inIdx++) {
-            if (inBuffer->s16[inIdx] > max_sample) {
-                max_sample = inBuffer->s16[inIdx];
-            } else if (-inBuffer->s16[inIdx] > max_sample) {
-                max_sample = -inBuffer->s16[inIdx];
-            }
-            rms_squared_acc += (inBuffer->s16[inIdx] * inBuffer->s16[inIdx]);
-        }
+        uint32_t len = inBuffer->frameCount * visu_ctxt->channel_count;
+        uint16_t peak_u16;
+        uint64_t sum_squares;
+
+        visualizer_measure(inBuffer->s16, len, &peak_u16, &sum_squares);
         // store the measurement
-        visu_ctxt->past_meas[visu_ctxt->meas_buffer_idx].peak_u16 = (uint16_t)max_sample;
+        visu_ctxt->past_meas[visu_ctxt->meas_buffer_idx].peak_u16 = peak_u16;
         visu_ctxt->past_meas[visu_ctxt->meas_buffer_idx].rms_squared =
-                rms_squared_acc / (inBuffer->frameCount * visu_ctxt->channel_count);
+                (float)sum_squares / len;
         visu_ctxt->past_meas[visu_ctxt->meas_buffer_idx].is_valid = true;
         if (++visu_ctxt->meas_buffer_idx >= visu_ctxt->meas_wndw_size_in_buffers) {
             visu_ctxt->meas_buffer_idx = 0;
@@ -793,15 +957,7 @@ int visualizer_process(effect_context_t *context,
     if (visu_ctxt->scaling_mode == VISUALIZER_SCALING_MODE_NORMALIZED) {
         /* derive capture scaling factor from peak value in current buffer
          * this gives more interesting captures for display. */
-        shift = 32;
-        int len = inBuffer->frameCount * 2;
-        int i;
-        for (i = 0; i < len; i++) {
-            int32_t smp = inBuffer->s16[i];
-            if (smp < 0) smp = -smp - 1; /* take care to keep the max negative in range */
-            int32_t clz = __builtin_clz(smp);
-            if (shift > clz) shift = clz;
-        }
+        shift = visualizer_min_clz(inBuffer->s16, inBuffer->frameCount * 2);
         /* A maximum amplitude signal will have 17 leading zeros, which we want to
          * translate to a shift of 8 (for converting 16 bit to 8 bit) */
         shift = 25 - shift;
@@ -817,28 +973,30 @@ int visualizer_process(effect_context_t *context,
         shift = 9;
     }
 
-    uint32_t capt_idx;
-    uint32_t in_idx;
-    uint8_t *buf = visu_ctxt->capture_buf;
-    for (in_idx = 0, capt_idx = visu_ctxt->capture_idx;
-         in_idx < inBuffer->frameCount;
-         in_idx++, capt_idx++) {
+    /* only this thread writes capture_idx */
+    uint32_t capt_idx = atomic_load_explicit(&visu_ctxt->capture_idx, memory_order_relaxed);
+    uint32_t in_idx = 0;
+    uint32_t frames;
+    while (in_idx < inBuffer->frameCount) {
         if (capt_idx >= CAPTURE_BUF_SIZE) {
             /* wrap around */
             capt_idx = 0;
         }
-        int32_t smp = inBuffer->s16[2 * in_idx] + inBuffer->s16[2 * in_idx + 1];
-        smp = smp >> shift;
-        buf[capt_idx] = ((uint8_t)smp)^0x80;
+        frames = inBuffer->frameCount - in_idx;
+        if (frames > CAPTURE_BUF_SIZE - capt_idx)
+            frames = CAPTURE_BUF_SIZE - capt_idx;
+        visualizer_downmix(visu_ctxt->capture_buf + capt_idx, inBuffer->s16 + 2 * in_idx,
+                           frames, shift);
+        in_idx += frames;
+        capt_idx += frames;
     }
 
-    /* XXX the following two should really be atomic, though it probably doesn't
-     * matter much for visualization purposes */
-    visu_ctxt->capture_idx = capt_idx;
     /* update last buffer update time stamp */
     if (clock_gettime(CLOCK_MONOTONIC, &visu_ctxt->buffer_update_time) < 0) {
         visu_ctxt->buffer_update_time.tv_sec = 0;
     }
+    /* a reader that sees the new index also sees the samples behind it */
+    atomic_store_explicit(&visu_ctxt->capture_idx, capt_idx, memory_order_release);
 
     if (context->state != EFFECT_STATE_ACTIVE) {
         ALOGV("%s DONE inactive", __func__);
@@ -873,7 +1031,9 @@ int visualizer_command(effect_context_t * context, uint32_t cmdCode, uint32_t cm
             }
             const uint32_t delta_smp = context->config.inputCfg.samplingRate * latency_ms / 1000;
 
-            int64_t capture_point = visu_ctxt->capture_idx;
+            const uint32_t capture_idx = atomic_load_explicit(&visu_ctxt->capture_idx,
+                                                              memory_order_acquire);
+            int64_t capture_point = capture_idx;
             capture_point -= visu_ctxt->capture_size;
             capture_point -= delta_smp;
             int64_t capture_size = visu_ctxt->capture_size;
@@ -896,7 +1056,7 @@ int visualizer_command(effect_context_t * context, uint32_t cmdCode, uint32_t cm
 
             /* if audio framework has stopped playing audio although the effect is still
              * active we must clear the capture buffer to return silence */
-            if ((visu_ctxt->last_capture_idx == visu_ctxt->capture_idx) &&
+            if ((visu_ctxt->last_capture_idx == capture_idx) &&
                     (visu_ctxt->buffer_update_time.tv_sec != 0)) {
                 if (delta_ms > MAX_STALL_TIME_MS) {
                     ALOGV("%s capture going to idle", __func__);
@@ -904,7 +1064,7 @@ int visualizer_command(effect_context_t * context, uint32_t cmdCode, uint32_t cm
                     memset(pReplyData, 0x80, visu_ctxt->capture_size);
                 }
             }
-            visu_ctxt->last_capture_idx = visu_ctxt->capture_idx;
+            visu_ctxt->last_capture_idx = capture_idx;
         } else {
             memset(pReplyData, 0x80, visu_ctxt->capture_size);
         }
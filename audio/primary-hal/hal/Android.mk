@@ -59,13 +59,14 @@ LOCAL_C_INCLUDES += \
 
 LOCAL_SRC_FILES := \
     AudioStream.cpp \
+    AudioKernels.cpp \
     AudioDevice.cpp \
     AudioVoice.cpp \
     audio_extn/soundtrigger.cpp \
     audio_extn/Gain.cpp \
     audio_extn/AudioExtn.cpp
 
-LOCAL_HEADER_LIBRARIES := libhardware_headers qti_audio_kernel_uapi
+LOCAL_HEADER_LIBRARIES := libhardware_headers qti_audio_kernel_uapi libagm_headers
 
 LOCAL_SHARED_LIBRARIES := \
     libbase \
@@ -78,6 +79,7 @@ LOCAL_SHARED_LIBRARIES := \
     libprocessgroup \
     libutils \
     libar-pal \
+    libagm_latency \
     android.hidl.allocator@1.0 \
     android.hidl.memory@1.0 \
     libhidlmemory
@@ -85,7 +87,8 @@ LOCAL_SHARED_LIBRARIES := \
 ifeq ($(strip $(AUDIO_FEATURE_ENABLED_PAL_HIDL)),true)
   LOCAL_SHARED_LIBRARIES += \
     vendor.qti.hardware.pal@1.0-impl \
-    vendor.qti.hardware.pal@1.0
+    vendor.qti.hardware.pal@1.0 \
+    vendor.qti.hardware.pal@1.1
 
   LOCAL_CFLAGS += -DPAL_HIDL_ENABLED
 endif
@@ -94,14 +97,12 @@ ifeq ($(strip $(AUDIO_FEATURE_ENABLED_AGM_HIDL)),true)
   LOCAL_SHARED_LIBRARIES += \
      vendor.qti.hardware.AGMIPC@1.0-impl \
      vendor.qti.hardware.AGMIPC@1.0 \
+     vendor.qti.hardware.AGMIPC@1.1 \
      libagm
 
   LOCAL_CFLAGS += -DAGM_HIDL_ENABLED
   LOCAL_C_INCLUDES += \
     $(TOP)/vendor/qcom/opensource/agm/ipc/HwBinders/agm_ipc_client/
-
-  LOCAL_HEADER_LIBRARIES += \
-    libagm_headers
 endif
 
 ifeq ($(strip $(AUDIO_FEATURE_ENABLED_GEF_SUPPORT)),true)
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "AHAL: AudioKernels"
+
+#include "AudioKernels.h"
+#include "AudioCommon.h"
+#include <audio_utils/format.h>
+#include <audio_utils/primitives.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#define AUDIO_KERNELS_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIO_KERNELS_SSE2
+#endif
+
+/*
+ * Scalar split with compile time frame sizes, the copies become plain
+ * loads and stores. The audio frame is staged since it may overlap the
+ * source frame when audio aliases src.
+ */
+template <size_t A, size_t H>
+static void splitScalar(const struct audio_split_kernel *kernel __unused, uint8_t *audio,
+                        uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    uint8_t frame[A];
+    size_t i;
+
+    for (i = 0; i < frames; i++) {
+        memcpy(frame, src, A);
+        if (haptic) {
+            memcpy(haptic, src + A, H);
+            haptic += H;
+        }
+        memcpy(audio, frame, A);
+        audio += A;
+        src += A + H;
+    }
+}
+
+static void splitGeneric(const struct audio_split_kernel *kernel, uint8_t *audio,
+                         uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    uint32_t audioSize = kernel->audioFrameSize;
+    uint32_t hapticSize = kernel->hapticFrameSize;
+    size_t i;
+
+    for (i = 0; i < frames; i++) {
+        if (haptic) {
+            memcpy(haptic, src + audioSize, hapticSize);
+            haptic += hapticSize;
+        }
+        memmove(audio, src, audioSize);
+        audio += audioSize;
+        src += audioSize + hapticSize;
+    }
+}
+
+/*
+ * Vector kernels load a whole block before storing it. A block of audio
+ * never reaches past the start of the next source block, so audio may
+ * alias src.
+ */
+#if defined(AUDIO_KERNELS_NEON)
+static void split16x2x1(const struct audio_split_kernel *kernel, uint8_t *audio,
+                        uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    uint16x8x3_t in;
+    uint16x8x2_t out;
+
+    for (; frames >= 8; frames -= 8) {
+        in = vld3q_u16((const uint16_t *)src);
+        out.val[0] = in.val[0];
+        out.val[1] = in.val[1];
+        vst2q_u16((uint16_t *)audio, out);
+        if (haptic) {
+            vst1q_u16((uint16_t *)haptic, in.val[2]);
+            haptic += 8 * sizeof(uint16_t);
+        }
+        audio += 8 * 2 * sizeof(uint16_t);
+        src += 8 * 3 * sizeof(uint16_t);
+    }
+    splitScalar<4, 2>(kernel, audio, haptic, src, frames);
+}
+
+static void split16x2x2(const struct audio_split_kernel *kernel, uint8_t *audio,
+                        uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    uint16x8x4_t in;
+    uint16x8x2_t out;
+
+    for (; frames >= 8; frames -= 8) {
+        in = vld4q_u16((const uint16_t *)src);
+        out.val[0] = in.val[0];
+        out.val[1] = in.val[1];
+        vst2q_u16((uint16_t *)audio, out);
+        if (haptic) {
+            out.val[0] = in.val[2];
+            out.val[1] = in.val[3];
+            vst2q_u16((uint16_t *)haptic, out);
+            haptic += 8 * 2 * sizeof(uint16_t);
+        }
+        audio += 8 * 2 * sizeof(uint16_t);
+        src += 8 * 4 * sizeof(uint16_t);
+    }
+    splitScalar<4, 4>(kernel, audio, haptic, src, frames);
+}
+
+static void split32x2x1(const struct audio_split_kernel *kernel, uint8_t *audio,
+                        uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    uint32x4x3_t in;
+    uint32x4x2_t out;
+
+    for (; frames >= 4; frames -= 4) {
+        in = vld3q_u32((const uint32_t *)src);
+        out.val[0] = in.val[0];
+        out.val[1] = in.val[1];
+        vst2q_u32((uint32_t *)audio, out);
+        if (haptic) {
+            vst1q_u32((uint32_t *)haptic, in.val[2]);
+            haptic += 4 * sizeof(uint32_t);
+        }
+        audio += 4 * 2 * sizeof(uint32_t);
+        src += 4 * 3 * sizeof(uint32_t);
+    }
+    splitScalar<8, 4>(kernel, audio, haptic, src, frames);
+}
+
+static void split32x2x2(const struct audio_split_kernel *kernel, uint8_t *audio,
+                        uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    uint32x4x4_t in;
+    uint32x4x2_t out;
+
+    for (; frames >= 4; frames -= 4) {
+        in = vld4q_u32((const uint32_t *)src);
+        out.val[0] = in.val[0];
+        out.val[1] = in.val[1];
+        vst2q_u32((uint32_t *)audio, out);
+        if (haptic) {
+            out.val[0] = in.val[2];
+            out.val[1] = in.val[3];
+            vst2q_u32((uint32_t *)haptic, out);
+            haptic += 4 * 2 * sizeof(uint32_t);
+        }
+        audio += 4 * 2 * sizeof(uint32_t);
+        src += 4 * 4 * sizeof(uint32_t);
+    }
+    splitScalar<8, 8>(kernel, audio, haptic, src, frames);
+}
+
+/* rounds to nearest even where memcpy_to_i32_from_float rounds ties away */
+static void convertFloatToI32(const struct audio_convert_kernel *kernel __unused,
+                              void *dst, const void *src, size_t samples)
+{
+    const float *in = (const float *)src;
+    int32_t *out = (int32_t *)dst;
+
+    /* the conversion saturates, +1.0 becomes INT32_MAX */
+    for (; samples >= 4; samples -= 4) {
+        vst1q_s32(out, vcvtnq_s32_f32(vmulq_n_f32(vld1q_f32(in), 2147483648.0f)));
+        in += 4;
+        out += 4;
+    }
+    memcpy_to_i32_from_float(out, in, samples);
+}
+#elif defined(AUDIO_KERNELS_SSE2)
+static void split16x2x2(const struct audio_split_kernel *kernel, uint8_t *audio,
+                        uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    __m128i f01, f23;
+
+    /* one frame is two 32 bit words, audio first */
+    for (; frames >= 4; frames -= 4) {
+        f01 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)src), _MM_SHUFFLE(3, 1, 2, 0));
+        f23 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(src + 16)),
+                                _MM_SHUFFLE(3, 1, 2, 0));
+        if (haptic) {
+            _mm_storeu_si128((__m128i *)haptic, _mm_unpackhi_epi64(f01, f23));
+            haptic += 4 * 2 * sizeof(uint16_t);
+        }
+        _mm_storeu_si128((__m128i *)audio, _mm_unpacklo_epi64(f01, f23));
+        audio += 4 * 2 * sizeof(uint16_t);
+        src += 4 * 4 * sizeof(uint16_t);
+    }
+    splitScalar<4, 4>(kernel, audio, haptic, src, frames);
+}
+
+static void split32x2x2(const struct audio_split_kernel *kernel, uint8_t *audio,
+                        uint8_t *haptic, const uint8_t *src, size_t frames)
+{
+    __m128i f0, f1;
+
+    /* one frame is two 64 bit words, audio first */
+    for (; frames >= 2; frames -= 2) {
+        f0 = _mm_loadu_si128((const __m128i *)src);
+        f1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        if (haptic) {
+            _mm_storeu_si128((__m128i *)haptic, _mm_unpackhi_epi64(f0, f1));
+            haptic += 2 * 2 * sizeof(uint32_t);
+        }
+        _mm_storeu_si128((__m128i *)audio, _mm_unpacklo_epi64(f0, f1));
+        audio += 2 * 2 * sizeof(uint32_t);
+        src += 2 * 4 * sizeof(uint32_t);
+    }
+    splitScalar<8, 8>(kernel, audio, haptic, src, frames);
+}
+
+/* rounds to nearest even where memcpy_to_i32_from_float rounds ties away */
+static void convertFloatToI32(const struct audio_convert_kernel *kernel __unused,
+                              void *dst, const void *src, size_t samples)
+{
+    const float *in = (const float *)src;
+    int32_t *out = (int32_t *)dst;
+    const __m128 scale = _mm_set1_ps(2147483648.0f);
+    const __m128i max = _mm_set1_epi32(INT32_MAX);
+    __m128 v;
+    __m128i r, over;
+
+    for (; samples >= 4; samples -= 4) {
+        v = _mm_mul_ps(_mm_loadu_ps(in), scale);
+        /* cvtps2dq returns INT32_MIN on overflow, which is right only below -1.0 */
+        over = _mm_castps_si128(_mm_cmpge_ps(v, scale));
+        r = _mm_cvtps_epi32(v);
+        r = _mm_or_si128(_mm_andnot_si128(over, r), _mm_and_si128(over, max));
+        _mm_storeu_si128((__m128i *)out, r);
+        in += 4;
+        out += 4;
+    }
+    memcpy_to_i32_from_float(out, in, samples);
+}
+#endif
+
+static void convertGeneric(const struct audio_convert_kernel *kernel, void *dst,
+                           const void *src, size_t samples)
+{
+    memcpy_by_audio_format(dst, kernel->dstFormat, src, kernel->srcFormat, samples);
+}
+
+void audio_kernels_get_split(struct audio_split_kernel *kernel, uint32_t bytesPerSample,
+                             uint32_t audioChannels, uint32_t hapticChannels)
+{
+    kernel->audioFrameSize = bytesPerSample * audioChannels;
+    kernel->hapticFrameSize = bytesPerSample * hapticChannels;
+    kernel->fn = splitGeneric;
+    kernel->name = "generic";
+
+    if (audioChannels == 2 && (hapticChannels == 1 || hapticChannels == 2)) {
+        switch (bytesPerSample) {
+        case 2:
+            kernel->fn = hapticChannels == 1 ? splitScalar<4, 2> : splitScalar<4, 4>;
+            kernel->name = "scalar";
+#if defined(AUDIO_KERNELS_NEON)
+            kernel->fn = hapticChannels == 1 ? split16x2x1 : split16x2x2;
+            kernel->name = "neon";
+#elif defined(AUDIO_KERNELS_SSE2)
+            if (hapticChannels == 2) {
+                kernel->fn = split16x2x2;
+                kernel->name = "sse2";
+            }
+#endif
+            break;
+        case 4:
+            kernel->fn = hapticChannels == 1 ? splitScalar<8, 4> : splitScalar<8, 8>;
+            kernel->name = "scalar";
+#if defined(AUDIO_KERNELS_NEON)
+            kernel->fn = hapticChannels == 1 ? split32x2x1 : split32x2x2;
+            kernel->name = "neon";
+#elif defined(AUDIO_KERNELS_SSE2)
+            if (hapticChannels == 2) {
+                kernel->fn = split32x2x2;
+                kernel->name = "sse2";
+            }
+#endif
+            break;
+        default:
+            break;
+        }
+    }
+    AHAL_DBG("split %u bytes %u+%u channels: %s", bytesPerSample, audioChannels,
+             hapticChannels, kernel->name);
+}
+
+void audio_kernels_get_convert(struct audio_convert_kernel *kernel,
+                               audio_format_t dstFormat, audio_format_t srcFormat)
+{
+    kernel->dstFormat = dstFormat;
+    kernel->srcFormat = srcFormat;
+    kernel->fn = convertGeneric;
+    kernel->name = "generic";
+
+#if defined(AUDIO_KERNELS_NEON) || defined(AUDIO_KERNELS_SSE2)
+    if (srcFormat == AUDIO_FORMAT_PCM_FLOAT && dstFormat == AUDIO_FORMAT_PCM_32_BIT) {
+        kernel->fn = convertFloatToI32;
+        kernel->name = "simd";
+    }
+#endif
+    AHAL_DBG("convert 0x%x to 0x%x: %s", srcFormat, dstFormat, kernel->name);
+}
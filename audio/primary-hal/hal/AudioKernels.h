@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2023 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef AUDIO_KERNELS_H
+#define AUDIO_KERNELS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <system/audio.h>
+
+struct audio_split_kernel;
+struct audio_convert_kernel;
+
+typedef void (*audio_split_fn_t)(const struct audio_split_kernel *kernel,
+                                 uint8_t *audio, uint8_t *haptic,
+                                 const uint8_t *src, size_t frames);
+typedef void (*audio_convert_fn_t)(const struct audio_convert_kernel *kernel,
+                                   void *dst, const void *src, size_t samples);
+
+/*
+ * Splits frames of interleaved audio and haptic channels into packed
+ * audio and packed haptic frames. audio may be the same buffer as src,
+ * haptic may be NULL to drop the haptic channels.
+ */
+struct audio_split_kernel {
+    audio_split_fn_t fn;
+    uint32_t audioFrameSize;
+    uint32_t hapticFrameSize;
+    const char *name;
+};
+
+/* Converts samples from srcFormat to dstFormat, same as memcpy_by_audio_format */
+struct audio_convert_kernel {
+    audio_convert_fn_t fn;
+    audio_format_t dstFormat;
+    audio_format_t srcFormat;
+    const char *name;
+};
+
+/*
+ * Pick the fastest kernel for the layout. SSE2/NEON versions exist for
+ * 16 and 32 bit samples with 2 audio channels and 1 or 2 haptic channels,
+ * and for float to 32 bit conversion. Anything else uses a scalar kernel.
+ */
+void audio_kernels_get_split(struct audio_split_kernel *kernel, uint32_t bytesPerSample,
+                             uint32_t audioChannels, uint32_t hapticChannels);
+void audio_kernels_get_convert(struct audio_convert_kernel *kernel,
+                               audio_format_t dstFormat, audio_format_t srcFormat);
+
+#endif //AUDIO_KERNELS_H
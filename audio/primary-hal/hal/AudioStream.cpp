@@ -45,6 +45,7 @@
 #include <thread>
 
 #include "PalApi.h"
+#include <agm/agm_latency.h>
 #include <audio_effects/effect_aec.h>
 #include <audio_effects/effect_ns.h>
 #include "audio_extn.h"
@@ -2763,6 +2764,9 @@ int StreamOutPrimary::Open() {
         hapticsStreamAttributes.out_media_config.bit_width = CODEC_BACKEND_DEFAULT_BIT_WIDTH;
         hapticsStreamAttributes.out_media_config.aud_fmt_id = PAL_AUDIO_FMT_PCM_S16_LE;
         hapticsStreamAttributes.out_media_config.ch_info = ch_info;
+        audio_kernels_get_split(&hapticsSplitKernel, audio_bytes_per_sample(config_.format),
+                audio_channel_count_from_out_mask(config_.channel_mask) - ch_info.channels,
+                ch_info.channels);
 
         if (!hapticsDevice && !mBypassHaptic) {
             hapticsDevice = (struct pal_device*) calloc(1, sizeof(struct pal_device));
@@ -2857,6 +2861,7 @@ int StreamOutPrimary::Open() {
             goto error_open;
         }
         AHAL_DBG("convert buffer allocated for size %d", convertBufSize);
+        audio_kernels_get_convert(&convertKernel, halOutputFormat, halInputFormat);
     }
 
     fragment_size_ = outBufSize;
@@ -2980,7 +2985,6 @@ ssize_t StreamOutPrimary::splitAndWriteAudioHapticsStream(const void *buffer, si
      bool allocHapticsBuffer = false;
      struct pal_buffer audioBuf;
      struct pal_buffer hapticBuf;
-     size_t srcIndex = 0, audIndex = 0, hapIndex = 0;
      uint8_t channelCount = audio_channel_count_from_out_mask(config_.channel_mask);
      uint8_t bytesPerSample = audio_bytes_per_sample(config_.format);
      uint32_t frameSize = channelCount * bytesPerSample;
@@ -3017,17 +3021,8 @@ ssize_t StreamOutPrimary::splitAndWriteAudioHapticsStream(const void *buffer, si
      hapticBuf.size = frameCount * hapticsFrameSize;
      hapticBuf.offset = 0;
 
-     for (size_t i = 0; i < frameCount; i++) {
-         memcpy((uint8_t *)(audioBuf.buffer) + audIndex, (uint8_t *)(audioBuf.buffer) + srcIndex,
-                audioFrameSize);
-         audIndex += audioFrameSize;
-         srcIndex += audioFrameSize;
-
-         memcpy((uint8_t *)(hapticBuf.buffer) + hapIndex, (uint8_t *)(audioBuf.buffer) + srcIndex,
-                    hapticsFrameSize);
-         hapIndex += hapticsFrameSize;
-         srcIndex += hapticsFrameSize;
-     }
+     hapticsSplitKernel.fn(&hapticsSplitKernel, audioBuf.buffer, hapticBuf.buffer,
+                           audioBuf.buffer, frameCount);
 
      // write audio data
      ret = pal_stream_write(pal_stream_handle_, &audioBuf);
@@ -3042,7 +3037,6 @@ ssize_t StreamOutPrimary::BypassHapticAndWriteAudioStream(const void *buffer, si
      ssize_t ret = 0;
      bool allocHapticsBuffer = false;
      struct pal_buffer audioBuf;
-     size_t srcIndex = 0, audIndex = 0, hapIndex = 0;
      uint8_t channelCount = audio_channel_count_from_out_mask(config_.channel_mask);
      uint8_t bytesPerSample = audio_bytes_per_sample(config_.format);
      uint32_t frameSize = channelCount * bytesPerSample;
@@ -3058,16 +3052,9 @@ ssize_t StreamOutPrimary::BypassHapticAndWriteAudioStream(const void *buffer, si
      audioBuf.size = frameCount * audioFrameSize;
      audioBuf.offset = 0;
 
-     for (size_t i = 0; i < frameCount; i++) {
-         memcpy((uint8_t *)(audioBuf.buffer) + audIndex, (uint8_t *)(audioBuf.buffer) + srcIndex,
-                audioFrameSize);
-         audIndex += audioFrameSize;
-         srcIndex += audioFrameSize;
-
-         // Skip haptic frames
-         hapIndex += hapticsFrameSize;
-         srcIndex += hapticsFrameSize;
-     }
+     // Skip haptic frames
+     hapticsSplitKernel.fn(&hapticsSplitKernel, audioBuf.buffer, NULL,
+                           audioBuf.buffer, frameCount);
 
      // write audio data
      ret = pal_stream_write(pal_stream_handle_, &audioBuf);
@@ -3225,6 +3212,7 @@ ssize_t StreamOutPrimary::configurePalOutputStream() {
 
 ssize_t StreamOutPrimary::write(const void *buffer, size_t bytes)
 {
+    AgmLatencyScope latency(AGM_LATENCY_STAGE_HAL);
     ssize_t ret = 0;
     struct pal_buffer palBuffer;
     uint32_t frames;
@@ -3259,7 +3247,7 @@ ssize_t StreamOutPrimary::write(const void *buffer, size_t bytes)
         }
 
         frames = bytes / (inputBitWidth / 8);
-        memcpy_by_audio_format(convertBuffer, halOutputFormat, buffer, halInputFormat, frames);
+        convertKernel.fn(&convertKernel, convertBuffer, buffer, frames);
         palBuffer.buffer = (uint8_t *)convertBuffer;
         palBuffer.size = frames * (outputBitWidth / 8);
         ret = pal_stream_write(pal_stream_handle_, &palBuffer);
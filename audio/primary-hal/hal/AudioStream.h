@@ -76,6 +76,7 @@
 #include <system/audio.h>
 
 #include "PalDefs.h"
+#include "AudioKernels.h"
 #include <audio_extn/AudioExtn.h>
 #include <mutex>
 #include <map>
@@ -597,6 +598,7 @@ protected:
     visualizer_hal_start_output fnp_visualizer_start_output_ = nullptr;
     visualizer_hal_stop_output fnp_visualizer_stop_output_ = nullptr;
     void *convertBuffer;
+    struct audio_convert_kernel convertKernel;
     //Haptics Usecase
     struct pal_stream_attributes hapticsStreamAttributes;
     pal_stream_handle_t* pal_haptics_stream_handle;
@@ -604,6 +606,7 @@ protected:
     struct pal_device* hapticsDevice;
     uint8_t* hapticBuffer;
     size_t hapticsBufSize;
+    struct audio_split_kernel hapticsSplitKernel;
 
     int FillHalFnPtrs();
     friend class AudioDevice;